@@ -24,6 +24,8 @@
 #include <MicroOcpp/Model/Availability/AvailabilityService.h>
 #include <MicroOcpp/Model/RemoteControl/RemoteControlService.h>
 #include <MicroOcpp/Core/Request.h>
+#include <MicroOcpp/Core/SlabAllocator.h>
+#include <MicroOcpp/Core/Configuration.h>
 #include <MicroOcpp/Core/OperationRegistry.h>
 #include <MicroOcpp/Core/FilesystemAdapter.h>
 #include <MicroOcpp/Core/FilesystemUtils.h>
@@ -45,8 +47,10 @@ WebSocketsClient *webSocket {nullptr};
 Connection *connection {nullptr};
 #endif
 
-Context *context {nullptr};
-std::shared_ptr<FilesystemAdapter> filesystem;
+MO_THREAD_LOCAL Context *context {nullptr}; //selected instance (see mocpp_select_instance())
+MO_THREAD_LOCAL std::shared_ptr<FilesystemAdapter> filesystem;
+
+unsigned int instanceCount = 0;
 
 #ifndef MO_NUMCONNECTORS
 #define MO_NUMCONNECTORS 2
@@ -254,7 +258,11 @@ void mocpp_initialize(Connection& connection, const char *bootNotificationCreden
 
     MO_DBG_DEBUG("initialize OCPP");
 
+#if MO_ENABLE_GROUP_COMMIT
+    filesystem = makeGroupCommitFilesystemAdapter(fs); //Context::loop() commits the written files in one go
+#else
     filesystem = fs;
+#endif
     MO_DBG_DEBUG("filesystem %s", filesystem ? "loaded" : "deactivated");
 
     BootStats bootstats;
@@ -269,10 +277,29 @@ void mocpp_initialize(Connection& connection, const char *bootNotificationCreden
 
     bootstats.bootNr++; //assign new boot number to this run
     BootService::storeBootStats(filesystem, bootstats);
+    if (filesystem) {
+        filesystem->flush(); //count this boot also if it crashes before the first loop ends
+    }
+
+    std::unique_ptr<ConfigurationRegistry> configuration;
+    if (instanceCount > 0) {
+        //further instance: scope the Configurations to this Context. The first instance uses the default registry
+        configuration = std::unique_ptr<ConfigurationRegistry>(new ConfigurationRegistry());
+    }
+    configuration_bind(configuration.get());
 
     configuration_init(filesystem); //call before each other library call
 
     context = new Context(connection, filesystem, bootstats.bootNr, version);
+    context->setConfigurationRegistry(std::move(configuration));
+#if MO_ENABLE_COMMAND_QUEUE
+    context->setSelectInstance([] (Context *instance) {
+        auto prevInstance = context;
+        mocpp_select_instance(instance);
+        return prevInstance;
+    });
+#endif
+    instanceCount++;
 
 #if MO_ENABLE_MBEDTLS
     context->setFtpClient(makeFtpClientMbedTLS());
@@ -389,11 +416,21 @@ void mocpp_deinitialize() {
             MO_DBG_DEBUG("boot success timer override");
             bootstats.lastBootSuccess = bootstats.bootNr;
             BootService::storeBootStats(filesystem, bootstats);
+            if (filesystem) {
+                filesystem->flush();
+            }
         }
     }
     
+    bool ownsConfiguration = context && context->getConfigurationRegistry();
+
+    if (context) {
+        instanceCount--;
+    }
+
     delete context;
     context = nullptr;
+    configuration_bind(nullptr);
 
 #ifndef MO_CUSTOM_WS
     delete connection;
@@ -402,12 +439,27 @@ void mocpp_deinitialize() {
     webSocket = nullptr;
 #endif
 
+    if (filesystem) {
+        filesystem->flush();
+    }
     filesystem.reset();
+    FilesystemUtils::freeReadBuffer();
+
+    if (!ownsConfiguration) {
+        configuration_deinit();
+    }
 
-    configuration_deinit();
+    if (instanceCount == 0) {
+        ObjectPool::shrinkAll();
+        #if MO_OVERRIDE_ALLOCATION && MO_ENABLE_SLAB_ALLOCATOR
+        mo_mem_slab_deinit();
+        #endif
+    }
 
 #if !MO_HEAP_PROFILER_EXTERNAL_CONTROL
-    MO_MEM_DEINIT();
+    if (instanceCount == 0) {
+        MO_MEM_DEINIT();
+    }
 #endif
 
     MO_DBG_DEBUG("deinitialized OCPP\n");
@@ -422,6 +474,26 @@ void mocpp_loop() {
     context->loop();
 }
 
+unsigned long mocpp_loop_next_deadline_ms() {
+    if (!context) {
+        MO_DBG_WARN("need to call mocpp_initialize before");
+        return 0;
+    }
+
+    return context->getNextLoopDelay();
+}
+
+#if MO_ENABLE_COMMAND_QUEUE
+bool mocpp_post(std::function<void()> command) {
+    if (!context) {
+        MO_DBG_WARN("need to call mocpp_initialize before");
+        return false;
+    }
+
+    return context->getCommandQueue().push(std::move(command));
+}
+#endif //MO_ENABLE_COMMAND_QUEUE
+
 bool beginTransaction(const char *idTag, unsigned int connectorId) {
     if (!context) {
         MO_DBG_ERR("OCPP uninitialized"); //need to call mocpp_initialize before
@@ -1327,6 +1399,12 @@ Context *getOcppContext() {
     return context;
 }
 
+void mocpp_select_instance(Context *instance) {
+    context = instance;
+    filesystem = instance ? instance->getFilesystem() : nullptr;
+    configuration_bind(instance ? instance->getConfigurationRegistry() : nullptr);
+}
+
 void setOnReceiveRequest(const char *operationType, OnReceiveReqListener onReceiveReq) {
     if (!context) {
         MO_DBG_ERR("OCPP uninitialized"); //need to call mocpp_initialize before
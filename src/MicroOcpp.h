@@ -14,6 +14,7 @@
 #include <MicroOcpp/Core/RequestCallbacks.h>
 #include <MicroOcpp/Core/Connection.h>
 #include <MicroOcpp/Core/Memory.h>
+#include <MicroOcpp/Core/CommandQueue.h>
 #include <MicroOcpp/Model/Metering/SampledValue.h>
 #include <MicroOcpp/Model/Transactions/Transaction.h>
 #include <MicroOcpp/Model/ConnectorBase/ChargePointErrorData.h>
@@ -123,6 +124,47 @@ void mocpp_deinitialize();
  */
 void mocpp_loop();
 
+/*
+ * Tickless mode: returns the time in ms until mocpp_loop() needs to run again. The host may sleep for this
+ * period, but must call mocpp_loop() earlier when
+ *     - the OCPP connection receives data (e.g. the socket becomes readable)
+ *     - an input changes (e.g. connector plugged, EV ready) or any other API function of this library is called
+ *     - another thread has posted a command (see mocpp_post())
+ * Returns 0 if mocpp_loop() has more work to do right away, and at most MO_LOOP_MAX_DELAY
+ */
+unsigned long mocpp_loop_next_deadline_ms();
+
+#if MO_ENABLE_COMMAND_QUEUE
+/*
+ * Thread-safe command ingress. All other functions of this header must run on the thread which calls mocpp_loop().
+ * Other threads (e.g. RFID reader, meter driver, HMI) can post their calls instead, without locking:
+ *
+ *     mocpp_post([] () {
+ *         beginTransaction("abc");
+ *     });
+ *
+ * The next mocpp_loop() executes the posted commands before anything else, in the order of posting. To receive
+ * the result, pass a completion callback. It runs on the loop thread right after the command:
+ *
+ *     mocpp_post<bool>([] () {return beginTransaction("abc");}, [] (bool success) {...});
+ *
+ * Returns false if MO is not initialized or if MO_COMMAND_QUEUE_SIZE commands are already waiting. With multiple
+ * instances, the command goes to the instance which is selected on the posting thread. It runs with that instance
+ * selected, regardless of which thread loops it
+ */
+bool mocpp_post(std::function<void()> command);
+
+template <class T>
+bool mocpp_post(std::function<T()> command, std::function<void(T)> onResult) {
+    return mocpp_post([command, onResult] () {
+        auto result = command();
+        if (onResult) {
+            onResult(result);
+        }
+    });
+}
+#endif //MO_ENABLE_COMMAND_QUEUE
+
 /*
  * Transaction management.
  * 
@@ -422,6 +464,28 @@ class Context;
 //To use, add `#include <MicroOcpp/Core/Context.h>`
 MicroOcpp::Context *getOcppContext();
 
+/*
+ * Multiple charge points in one process, e.g. a gateway in front of several EVSEs. Each charge point is a
+ * separate Context with its own Configurations. To keep their files apart, pass each one a filesystem with a
+ * different filename prefix (see makePrefixedFilesystemAdapter()). The functions of this header operate on
+ * the instance which is selected on the calling thread (thread-local if MO_ENABLE_MULTI_INSTANCE is set):
+ *
+ *     mocpp_initialize(connection1, credentials1, makePrefixedFilesystemAdapter(fs, "cp1-"));
+ *     auto cp1 = getOcppContext();
+ *     mocpp_select_instance(nullptr); //clear selection to initialize the next instance
+ *     mocpp_initialize(connection2, credentials2, makePrefixedFilesystemAdapter(fs, "cp2-"));
+ *     auto cp2 = getOcppContext();
+ *
+ *     mocpp_select_instance(cp1); //following calls on this thread apply to cp1
+ *     setConnectorPluggedInput(...);
+ *     mocpp_loop();
+ *
+ * With MO_ENABLE_MULTI_INSTANCE, a pool of worker threads can loop the instances, as long as only one thread
+ * at a time accesses the same instance. Initialize and deinitialize the instances on one thread. The built-in
+ * WebSocket of mocpp_initialize(backendUrl, ...) supports one instance only
+ */
+void mocpp_select_instance(MicroOcpp::Context *instance);
+
 /*
  * Set a listener which is notified when the OCPP lib processes an incoming operation of type
  * operationType. After the operation has been interpreted, onReceiveReq will be called with
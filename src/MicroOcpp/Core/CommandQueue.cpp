@@ -0,0 +1,79 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#include <MicroOcpp/Core/CommandQueue.h>
+
+#if MO_ENABLE_COMMAND_QUEUE
+
+#include <MicroOcpp/Debug.h>
+
+static_assert((MO_COMMAND_QUEUE_SIZE & (MO_COMMAND_QUEUE_SIZE - 1)) == 0, "MO_COMMAND_QUEUE_SIZE must be a power of 2");
+
+#define MO_COMMAND_QUEUE_MASK (MO_COMMAND_QUEUE_SIZE - 1)
+
+using namespace MicroOcpp;
+
+CommandQueue::CommandQueue() : MemoryManaged("CommandQueue"), pushPos{0} {
+    for (size_t i = 0; i < MO_COMMAND_QUEUE_SIZE; i++) {
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+bool CommandQueue::push(Command command) {
+    if (!command) {
+        MO_DBG_ERR("invalid arg");
+        return false;
+    }
+
+    Slot *slot;
+    size_t pos = pushPos.load(std::memory_order_relaxed);
+    for (;;) {
+        slot = &slots[pos & MO_COMMAND_QUEUE_MASK];
+        size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        auto diff = (long) (sequence - pos);
+        if (diff == 0) {
+            //slot is free, try to claim it
+            if (pushPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+            //other producer was faster, pos has been updated
+        } else if (diff < 0) {
+            //slot hasn't been consumed yet
+            return false;
+        } else {
+            pos = pushPos.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->command = std::move(command);
+    slot->sequence.store(pos + 1, std::memory_order_release); //publish to consumer
+    return true;
+}
+
+size_t CommandQueue::drain() {
+    //execute at most one round, so that commands which post further commands can't block the loop
+    size_t count = 0;
+    for (; count < MO_COMMAND_QUEUE_SIZE; count++) {
+        auto& slot = slots[popPos & MO_COMMAND_QUEUE_MASK];
+        size_t sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence != popPos + 1) {
+            break; //empty, or the producer is still writing this slot
+        }
+
+        auto command = std::move(slot.command);
+        slot.command = nullptr;
+        slot.sequence.store(popPos + MO_COMMAND_QUEUE_SIZE, std::memory_order_release); //release slot to producers
+        popPos++;
+
+        command();
+    }
+    return count;
+}
+
+bool CommandQueue::isEmpty() {
+    auto& slot = slots[popPos & MO_COMMAND_QUEUE_MASK];
+    return slot.sequence.load(std::memory_order_acquire) != popPos + 1;
+}
+
+#endif //MO_ENABLE_COMMAND_QUEUE
@@ -0,0 +1,54 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#ifndef MO_COMMANDQUEUE_H
+#define MO_COMMANDQUEUE_H
+
+//thread-safe command ingress for the public API (see mocpp_post())
+#ifndef MO_ENABLE_COMMAND_QUEUE
+#define MO_ENABLE_COMMAND_QUEUE 0
+#endif
+
+#if MO_ENABLE_COMMAND_QUEUE
+
+#include <MicroOcpp/Core/Memory.h>
+
+#include <atomic>
+#include <functional>
+
+//max number of posted commands which wait for the next loop(). Must be a power of 2
+#ifndef MO_COMMAND_QUEUE_SIZE
+#define MO_COMMAND_QUEUE_SIZE 16
+#endif
+
+namespace MicroOcpp {
+
+/*
+ * Bounded lock-free multi-producer single-consumer queue of commands. Any thread may push commands, only the loop
+ * thread executes them. Each slot has a sequence number which tells the producers whether the slot is free and the
+ * consumer whether the slot has been filled (after D. Vyukov's bounded MPMC queue)
+ */
+class CommandQueue : public MemoryManaged {
+public:
+    using Command = std::function<void()>;
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        Command command;
+    };
+    Slot slots [MO_COMMAND_QUEUE_SIZE];
+
+    std::atomic<size_t> pushPos;
+    size_t popPos = 0; //only accessed by the consumer
+public:
+    CommandQueue();
+
+    bool push(Command command); //any thread. Returns false if the queue is full
+    size_t drain(); //loop thread: execute the commands which are queued at this point. Returns number of executed commands
+    bool isEmpty(); //loop thread
+};
+
+} //end namespace MicroOcpp
+#endif //MO_ENABLE_COMMAND_QUEUE
+#endif
@@ -13,28 +13,40 @@
 
 namespace MicroOcpp {
 
-struct Validator {
-    const char *key = nullptr;
-    std::function<bool(const char*)> checkValue;
-    Validator(const char *key, std::function<bool(const char*)> checkValue) : key(key), checkValue(checkValue) {
+ConfigurationRegistry::ConfigurationRegistry() :
+        MemoryManaged("v16.Configuration.Registry"),
+        containers(makeVector<std::shared_ptr<ConfigurationContainer>>("v16.Configuration.Containers")),
+        validators(makeVector<Validator>("v16.Configuration.Validators")) {
 
-    }
-};
+}
 
 namespace ConfigurationLocal {
 
-std::shared_ptr<FilesystemAdapter> filesystem;
-auto configurationContainers = makeVector<std::shared_ptr<ConfigurationContainer>>("v16.Configuration.Containers");
-auto validators = makeVector<Validator>("v16.Configuration.Validators");
+MO_THREAD_LOCAL ConfigurationRegistry *boundRegistry = nullptr;
+
+ConfigurationRegistry& registry() {
+    if (boundRegistry) {
+        return *boundRegistry;
+    }
+    static ConfigurationRegistry defaultRegistry; //construct on first use, i.e. after the heap profiler
+    return defaultRegistry;
+}
 
 }
 
 using namespace ConfigurationLocal;
 
+ConfigurationRegistry *configuration_bind(ConfigurationRegistry *bind) {
+    auto prev = boundRegistry;
+    boundRegistry = bind;
+    return prev;
+}
+
 std::unique_ptr<ConfigurationContainer> createConfigurationContainer(const char *filename, bool accessible) {
     //create non-persistent Configuration store (i.e. lives only in RAM) if
     //     - Flash FS usage is switched off OR
     //     - Filename starts with "/volatile"
+    auto& filesystem = registry().filesystem;
     if (!filesystem ||
                  !strncmp(filename, CONFIGURATION_VOLATILE, strlen(CONFIGURATION_VOLATILE))) {
         return makeConfigurationContainerVolatile(filename, accessible);
@@ -46,12 +58,13 @@ std::unique_ptr<ConfigurationContainer> createConfigurationContainer(const char
 
 
 void addConfigurationContainer(std::shared_ptr<ConfigurationContainer> container) {
-    configurationContainers.push_back(container);
+    registry().containers.push_back(container);
 }
 
 std::shared_ptr<ConfigurationContainer> getContainer(const char *filename) {
+    auto& configurationContainers = registry().containers;
     auto container = std::find_if(configurationContainers.begin(), configurationContainers.end(),
-        [filename](decltype(configurationContainers)::value_type &elem) {
+        [filename](std::shared_ptr<ConfigurationContainer> &elem) {
             return !strcmp(elem->getFilename(), filename);
         });
 
@@ -74,7 +87,7 @@ ConfigurationContainer *declareContainer(const char *filename, bool accessible)
             MO_DBG_ERR("OOM");
             return nullptr;
         }
-        configurationContainers.push_back(container);
+        registry().containers.push_back(container);
     }
 
     if (container->isAccessible() != accessible) {
@@ -85,7 +98,7 @@ ConfigurationContainer *declareContainer(const char *filename, bool accessible)
 }
 
 std::shared_ptr<Configuration> loadConfiguration(TConfig type, const char *key, bool accessible) {
-    for (auto& container : configurationContainers) {
+    for (auto& container : registry().containers) {
         if (auto config = container->getConfiguration(key)) {
             if (config->getType() != type) {
                 MO_DBG_ERR("conflicting type for %s - remove old config", key);
@@ -162,7 +175,7 @@ template std::shared_ptr<Configuration> declareConfiguration<bool>(const char *k
 template std::shared_ptr<Configuration> declareConfiguration<const char*>(const char *key, const char *factoryDef, const char *filename, bool readonly, bool rebootRequired, bool accessible);
 
 std::function<bool(const char*)> *getConfigurationValidator(const char *key) {
-    for (auto& v : validators) {
+    for (auto& v : registry().validators) {
         if (!strcmp(v.key, key)) {
             return &v.checkValue;
         }
@@ -171,17 +184,17 @@ std::function<bool(const char*)> *getConfigurationValidator(const char *key) {
 }
 
 void registerConfigurationValidator(const char *key, std::function<bool(const char*)> validator) {
-    for (auto& v : validators) {
+    for (auto& v : registry().validators) {
         if (!strcmp(v.key, key)) {
             v.checkValue = validator;
             return;
         }
     }
-    validators.push_back(Validator{key, validator});
+    registry().validators.push_back(ConfigurationRegistry::Validator{key, validator});
 }
 
 Configuration *getConfigurationPublic(const char *key) {
-    for (auto& container : configurationContainers) {
+    for (auto& container : registry().containers) {
         if (container->isAccessible()) {
             if (auto res = container->getConfiguration(key)) {
                 return res.get();
@@ -195,7 +208,7 @@ Configuration *getConfigurationPublic(const char *key) {
 Vector<ConfigurationContainer*> getConfigurationContainersPublic() {
     auto res = makeVector<ConfigurationContainer*>("v16.Configuration.Containers");
 
-    for (auto& container : configurationContainers) {
+    for (auto& container : registry().containers) {
         if (container->isAccessible()) {
             res.push_back(container.get());
         }
@@ -205,20 +218,21 @@ Vector<ConfigurationContainer*> getConfigurationContainersPublic() {
 }
 
 bool configuration_init(std::shared_ptr<FilesystemAdapter> _filesystem) {
-    filesystem = _filesystem;
+    registry().filesystem = _filesystem;
     return true;
 }
 
 void configuration_deinit() {
-    makeVector<decltype(configurationContainers)::value_type>("v16.Configuration.Containers").swap(configurationContainers); //release allocated memory (see https://cplusplus.com/reference/vector/vector/clear/)
-    makeVector<decltype(validators)::value_type>("v16.Configuration.Validators").swap(validators);
-    filesystem.reset();
+    auto& reg = registry();
+    makeVector<std::shared_ptr<ConfigurationContainer>>("v16.Configuration.Containers").swap(reg.containers); //release allocated memory (see https://cplusplus.com/reference/vector/vector/clear/)
+    makeVector<ConfigurationRegistry::Validator>("v16.Configuration.Validators").swap(reg.validators);
+    reg.filesystem.reset();
 }
 
 bool configuration_load(const char *filename) {
     bool success = true;
 
-    for (auto& container : configurationContainers) {
+    for (auto& container : registry().containers) {
         if ((!filename || !strcmp(filename, container->getFilename())) && !container->load()) {
             success = false;
         }
@@ -230,7 +244,7 @@ bool configuration_load(const char *filename) {
 bool configuration_save() {
     bool success = true;
 
-    for (auto& container : configurationContainers) {
+    for (auto& container : registry().containers) {
         if (!container->save()) {
             success = false;
         }
@@ -240,7 +254,7 @@ bool configuration_save() {
 }
 
 bool configuration_clean_unused() {
-    for (auto& container : configurationContainers) {
+    for (auto& container : registry().containers) {
         container->removeUnused();
     }
     return configuration_save();
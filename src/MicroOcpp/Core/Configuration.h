@@ -18,6 +18,32 @@
 
 namespace MicroOcpp {
 
+/*
+ * Configurations of one MO instance. By default, all Configurations are in one process-wide registry. If a
+ * process runs multiple charge points (see mocpp_select_instance()), each further instance has its own registry.
+ * All functions below operate on the registry which is bound to the calling thread
+ */
+class ConfigurationRegistry : public MemoryManaged {
+public:
+    struct Validator {
+        const char *key = nullptr;
+        std::function<bool(const char*)> checkValue;
+        Validator(const char *key, std::function<bool(const char*)> checkValue) : key(key), checkValue(checkValue) { }
+    };
+
+    std::shared_ptr<FilesystemAdapter> filesystem;
+    Vector<std::shared_ptr<ConfigurationContainer>> containers;
+    Vector<Validator> validators;
+
+    ConfigurationRegistry();
+};
+
+/*
+ * Bind a registry to the calling thread (thread-local if MO_ENABLE_MULTI_INSTANCE, otherwise process-wide).
+ * nullptr = process-wide default registry. Returns the previously bound registry
+ */
+ConfigurationRegistry *configuration_bind(ConfigurationRegistry *bind);
+
 template <class T>
 std::shared_ptr<Configuration> declareConfiguration(const char *key, T factoryDefault, const char *filename = CONFIGURATION_FN, bool readonly = false, bool rebootRequired = false, bool accessible = true);
 
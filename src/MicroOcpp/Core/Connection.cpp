@@ -7,7 +7,7 @@
 
 using namespace MicroOcpp;
 
-LoopbackConnection::LoopbackConnection() : MemoryManaged("WebSocketLoopback") { }
+LoopbackConnection::LoopbackConnection() : MemoryManaged("WebSocketLoopback"), txtBuffer(makeVector<char>(getMemoryTag())) { }
 
 void LoopbackConnection::loop() { }
 
@@ -35,6 +35,21 @@ unsigned long LoopbackConnection::getLastConnected() {
     return lastConn;
 }
 
+char *LoopbackConnection::leaseTXTBuffer(size_t size) {
+    if (txtBuffer.size() < size) {
+        txtBuffer.resize(size);
+    }
+    return txtBuffer.data();
+}
+
+bool LoopbackConnection::commitTXTBuffer(size_t length) {
+    if (length > txtBuffer.size()) {
+        MO_DBG_ERR("exceeded TXT buffer");
+        return false;
+    }
+    return sendTXT(txtBuffer.data(), length);
+}
+
 void LoopbackConnection::setOnline(bool online) {
     if (online) {
         lastConn = mocpp_tick_ms();
@@ -53,7 +68,7 @@ void LoopbackConnection::setConnected(bool connected) {
 
 using namespace MicroOcpp::EspWiFi;
 
-WSClient::WSClient(WebSocketsClient *wsock) : MemoryManaged("WebSocketsClient"), wsock(wsock) {
+WSClient::WSClient(WebSocketsClient *wsock) : MemoryManaged("WebSocketsClient"), wsock(wsock), txtBuffer(makeVector<uint8_t>(getMemoryTag())) {
 
 }
 
@@ -118,4 +133,20 @@ bool WSClient::isConnected() {
     return wsock->isConnected();
 }
 
+char *WSClient::leaseTXTBuffer(size_t size) {
+    //reserve space in front of the payload so that the WS lib can write the frame header in place without copying the payload
+    if (txtBuffer.size() < WEBSOCKETS_MAX_HEADER_SIZE + size) {
+        txtBuffer.resize(WEBSOCKETS_MAX_HEADER_SIZE + size);
+    }
+    return (char*) txtBuffer.data() + WEBSOCKETS_MAX_HEADER_SIZE;
+}
+
+bool WSClient::commitTXTBuffer(size_t length) {
+    if (WEBSOCKETS_MAX_HEADER_SIZE + length > txtBuffer.size()) {
+        MO_DBG_ERR("exceeded TXT buffer");
+        return false;
+    }
+    return wsock->sendTXT(txtBuffer.data(), length, true); //headerToPayload: frame header goes into the reserved space
+}
+
 #endif
@@ -70,12 +70,31 @@ public:
      * connection status is uncertain, it's best to return true by default.
      */
     virtual bool isConnected() {return true;} //MO ignores true. This default implementation keeps backwards-compatibility
+
+    /*
+     * NEW IN v1.3 (optional)
+     *
+     * Zero-copy sending. If implemented, MO serializes outgoing messages directly into a buffer which is owned by
+     * the Connection, instead of serializing into a temporary String and passing it to sendTXT().
+     *
+     * leaseTXTBuffer(size) returns a writable buffer of at least `size` bytes, or nullptr if the Connection can't
+     * provide one. In that case, MO falls back to sendTXT(). After writing the message into the buffer, MO calls
+     * commitTXTBuffer(length) which should send the first `length` bytes of the buffer (the terminating zero is
+     * not included in `length`) and return true on success like sendTXT(). The Connection may modify the buffer
+     * while sending it (e.g. WebSocket masking).
+     *
+     * The default implementations disable this feature
+     */
+    virtual char *leaseTXTBuffer(size_t size) {return nullptr;}
+    virtual bool commitTXTBuffer(size_t length) {return false;}
 };
 
 class LoopbackConnection : public Connection, public MemoryManaged {
 private:
     ReceiveTXTcallback receiveTXT;
 
+    Vector<char> txtBuffer;
+
     //for simulating connection losses
     bool online = true;
     bool connected = true;
@@ -89,6 +108,8 @@ public:
     void setReceiveTXTcallback(ReceiveTXTcallback &receiveTXT) override;
     unsigned long getLastRecv() override;
     unsigned long getLastConnected() override;
+    char *leaseTXTBuffer(size_t size) override;
+    bool commitTXTBuffer(size_t length) override;
 
     void setOnline(bool online); //"online": sent messages are going through
     bool isOnline() {return online;}
@@ -109,6 +130,8 @@ class WSClient : public Connection, public MemoryManaged {
 private:
     WebSocketsClient *wsock;
     unsigned long lastRecv = 0, lastConnected = 0;
+
+    Vector<uint8_t> txtBuffer; //WebSocket frame, including the space for the frame header
 public:
     WSClient(WebSocketsClient *wsock);
 
@@ -123,6 +146,10 @@ public:
     unsigned long getLastConnected() override; //get last connection creation in millis
 
     bool isConnected() override;
+
+    char *leaseTXTBuffer(size_t size) override;
+
+    bool commitTXTBuffer(size_t length) override;
 };
 
 } //end namespace EspWiFi
@@ -5,15 +5,25 @@
 #include <MicroOcpp/Core/Context.h>
 #include <MicroOcpp/Core/Request.h>
 #include <MicroOcpp/Core/Connection.h>
+#include <MicroOcpp/Core/Configuration.h>
+#include <MicroOcpp/Core/FilesystemAdapter.h>
 #include <MicroOcpp/Model/Model.h>
+#include <MicroOcpp/Platform.h>
 
 #include <MicroOcpp/Debug.h>
 
 using namespace MicroOcpp;
 
 Context::Context(Connection& connection, std::shared_ptr<FilesystemAdapter> filesystem, uint16_t bootNr, ProtocolVersion version)
-        : MemoryManaged("Context"), connection(connection), model{version, bootNr}, reqQueue{connection, operationRegistry} {
+        : MemoryManaged("Context"), connection(connection), filesystem(filesystem), model{version, bootNr}, reqQueue{connection, operationRegistry} {
 
+#if MO_ENABLE_PERSISTENT_REQUEST_QUEUE
+    if (filesystem) {
+        persistentQueue = std::unique_ptr<PersistentRequestQueue>(new PersistentRequestQueue(connection, filesystem));
+        persistentQueue->load();
+        reqQueue.setPersistentSendQueue(persistentQueue.get());
+    }
+#endif
 }
 
 Context::~Context() {
@@ -21,9 +31,36 @@ Context::~Context() {
 }
 
 void Context::loop() {
+    auto prevConfiguration = configuration_bind(configuration.get());
+
+    loopStart = mocpp_tick_ms();
+    nextLoopDelay = MO_LOOP_MAX_DELAY;
+
+#if MO_ENABLE_COMMAND_QUEUE
+    if (selectInstance && !commandQueue.isEmpty()) {
+        auto prevInstance = selectInstance(this);
+        commandQueue.drain();
+        selectInstance(prevInstance);
+        configuration_bind(configuration.get()); //the selection has rebound the Configurations
+    } else {
+        commandQueue.drain();
+    }
+    if (!commandQueue.isEmpty()) {
+        scheduleLoop(0);
+    }
+#endif
+
     connection.loop();
     reqQueue.loop();
+    scheduleLoop(reqQueue.getNextLoopDelay());
+    timerWheel.advance(mocpp_tick_ms());
     model.loop();
+
+    if (filesystem) {
+        filesystem->flush(); //commit the files which this loop has written
+    }
+
+    configuration_bind(prevConfiguration);
 }
 
 void Context::initiateRequest(std::unique_ptr<Request> op) {
@@ -32,6 +69,25 @@ void Context::initiateRequest(std::unique_ptr<Request> op) {
         return;
     }
     reqQueue.sendRequest(std::move(op));
+    scheduleLoop(0);
+}
+
+void Context::scheduleLoop(unsigned long delayMs) {
+    unsigned long elapsed = mocpp_tick_ms() - loopStart;
+    if (elapsed + delayMs < nextLoopDelay) {
+        nextLoopDelay = elapsed + delayMs;
+    }
+}
+
+unsigned long Context::getNextLoopDelay() {
+#if MO_ENABLE_COMMAND_QUEUE
+    if (!commandQueue.isEmpty()) {
+        return 0;
+    }
+#endif
+    unsigned long elapsed = mocpp_tick_ms() - loopStart;
+    unsigned long delay = nextLoopDelay > elapsed ? nextLoopDelay - elapsed : 0;
+    return timerWheel.getNextDelay(delay);
 }
 
 Model& Context::getModel() {
@@ -54,6 +110,22 @@ RequestQueue& Context::getRequestQueue() {
     return reqQueue;
 }
 
+std::shared_ptr<FilesystemAdapter> Context::getFilesystem() {
+    return filesystem;
+}
+
+TimerWheel& Context::getTimerWheel() {
+    return timerWheel;
+}
+
+void Context::setConfigurationRegistry(std::unique_ptr<ConfigurationRegistry> configuration) {
+    this->configuration = std::move(configuration);
+}
+
+ConfigurationRegistry *Context::getConfigurationRegistry() {
+    return configuration.get();
+}
+
 void Context::setFtpClient(std::unique_ptr<FtpClient> ftpClient) {
     this->ftpClient = std::move(ftpClient);
 }
@@ -61,3 +133,13 @@ void Context::setFtpClient(std::unique_ptr<FtpClient> ftpClient) {
 FtpClient *Context::getFtpClient() {
     return ftpClient.get();
 }
+
+#if MO_ENABLE_COMMAND_QUEUE
+CommandQueue& Context::getCommandQueue() {
+    return commandQueue;
+}
+
+void Context::setSelectInstance(Context* (*selectInstance)(Context*)) {
+    this->selectInstance = selectInstance;
+}
+#endif
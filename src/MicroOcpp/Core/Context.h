@@ -9,25 +9,49 @@
 
 #include <MicroOcpp/Core/OperationRegistry.h>
 #include <MicroOcpp/Core/RequestQueue.h>
+#include <MicroOcpp/Core/PersistentRequestQueue.h>
 #include <MicroOcpp/Core/Memory.h>
 #include <MicroOcpp/Core/Ftp.h>
+#include <MicroOcpp/Core/CommandQueue.h>
+#include <MicroOcpp/Core/TimerWheel.h>
 #include <MicroOcpp/Model/Model.h>
 #include <MicroOcpp/Version.h>
 
+//max time between two loop() calls when idle (see Context::getNextLoopDelay())
+#ifndef MO_LOOP_MAX_DELAY
+#define MO_LOOP_MAX_DELAY 1000UL
+#endif
+
 namespace MicroOcpp {
 
 class Connection;
 class FilesystemAdapter;
+class ConfigurationRegistry;
 
 class Context : public MemoryManaged {
 private:
     Connection& connection;
+    std::shared_ptr<FilesystemAdapter> filesystem;
+    std::unique_ptr<ConfigurationRegistry> configuration; //Configurations of this instance. nullptr = process-wide default registry
     OperationRegistry operationRegistry;
+    TimerWheel timerWheel; //before model, so that it outlives the Timers of the services
     Model model;
     RequestQueue reqQueue;
 
+#if MO_ENABLE_PERSISTENT_REQUEST_QUEUE
+    std::unique_ptr<PersistentRequestQueue> persistentQueue;
+#endif
+
     std::unique_ptr<FtpClient> ftpClient;
 
+#if MO_ENABLE_COMMAND_QUEUE
+    CommandQueue commandQueue;
+    Context* (*selectInstance)(Context*) = nullptr;
+#endif
+
+    unsigned long loopStart = 0;
+    unsigned long nextLoopDelay = 0; //relative to loopStart
+
 public:
     Context(Connection& connection, std::shared_ptr<FilesystemAdapter> filesystem, uint16_t bootNr, ProtocolVersion version);
     ~Context();
@@ -46,8 +70,49 @@ public:
 
     RequestQueue& getRequestQueue();
 
+    std::shared_ptr<FilesystemAdapter> getFilesystem();
+
+    /*
+     * Deadlines of the services. loop() advances the TimerWheel before the Model and runs the callbacks of the
+     * due Timers. The next deadline counts into getNextLoopDelay()
+     */
+    TimerWheel& getTimerWheel();
+
+    /*
+     * Multiple instances: scope the Configurations to this Context. loop() binds the registry to the calling
+     * thread for its duration. Set it right after construction, the services declare their Configurations
+     * in the bound registry (see configuration_bind())
+     */
+    void setConfigurationRegistry(std::unique_ptr<ConfigurationRegistry> configuration);
+    ConfigurationRegistry *getConfigurationRegistry(); //nullptr = process-wide default registry
+
     void setFtpClient(std::unique_ptr<FtpClient> ftpClient);
     FtpClient *getFtpClient();
+
+#if MO_ENABLE_COMMAND_QUEUE
+    /*
+     * Commands which other threads have posted to this Context. loop() executes them before anything else (see
+     * mocpp_post())
+     */
+    CommandQueue& getCommandQueue();
+
+    /*
+     * The commands call the functions of MicroOcpp.h, which apply to the instance that is selected on the calling
+     * thread. loop() selects this Context for executing them and restores the previous selection afterwards, so that
+     * the commands reach this Context on any thread. selectInstance selects the given instance on the calling thread
+     * and returns the previously selected one. mocpp_initialize() sets it
+     */
+    void setSelectInstance(Context* (*selectInstance)(Context*));
+#endif
+
+    /*
+     * Tickless operation: the components report during loop() when they have scheduled work next. The host may
+     * sleep for getNextLoopDelay() ms until calling loop() again, unless the inputs change or the connection
+     * receives data. Components without time-driven work don't need to report; loop() runs at least every
+     * MO_LOOP_MAX_DELAY ms
+     */
+    void scheduleLoop(unsigned long delayMs); //run loop() again within delayMs. 0 = as soon as possible
+    unsigned long getNextLoopDelay();
 };
 
 } //end namespace MicroOcpp
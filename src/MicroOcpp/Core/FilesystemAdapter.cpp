@@ -3,11 +3,13 @@
 // MIT License
 
 #include <MicroOcpp/Core/FilesystemAdapter.h>
+#include <MicroOcpp/Core/FilesystemUtils.h>
 #include <MicroOcpp/Core/ConfigurationOptions.h> //FilesystemOpt
 #include <MicroOcpp/Core/Memory.h>
 #include <MicroOcpp/Debug.h>
 
 #include <cstring>
+#include <algorithm>
 
 /*
  * Platform specific implementations. Currently supported:
@@ -15,15 +17,13 @@
  *     - Arduino SPIFFS
  *     - ESP-IDF SPIFFS
  *     - POSIX-like API (tested on Ubuntu 20.04)
- * Plus a filesystem index decorator working with any of the above
+ * Plus a filesystem index decorator, a filename prefix decorator and a group commit decorator working with any of the above
  * 
  * You can add support for other file systems by passing a custom adapter to mocpp_initialize(...)
  */
 
 #if MO_ENABLE_FILE_INDEX
 
-#include <algorithm>
-
 namespace MicroOcpp {
 
 class FilesystemAdapterIndex;
@@ -36,8 +36,8 @@ private:
 
     size_t written = 0;
 public:
-    IndexedFileAdapter(FilesystemAdapterIndex& index, const char *fn, std::unique_ptr<FileAdapter> file)
-            : MemoryManaged("FilesystemIndex"), index(index), file(std::move(file)) {
+    IndexedFileAdapter(FilesystemAdapterIndex& index, const char *fn, std::unique_ptr<FileAdapter> file, size_t written = 0)
+            : MemoryManaged("FilesystemIndex"), index(index), file(std::move(file)), written(written) {
         snprintf(this->fn, sizeof(this->fn), "%s", fn);
     }
 
@@ -122,7 +122,7 @@ public:
     std::unique_ptr<FileAdapter> open(const char *path, const char *mode) {
         if (!strcmp(mode, "r")) {
             return filesystem->open(path, "r");
-        } else if (!strcmp(mode, "w")) {
+        } else if (!strcmp(mode, "w") || !strcmp(mode, "a")) {
 
             if (strlen(path) < sizeof(MO_FILENAME_PREFIX) - 1) {
                 MO_DBG_ERR("invalid fn");
@@ -131,7 +131,7 @@ public:
 
             const char *fn = path + sizeof(MO_FILENAME_PREFIX) - 1;
 
-            auto file = filesystem->open(path, "w");
+            auto file = filesystem->open(path, mode);
             if (!file) {
                 return nullptr;
             }
@@ -147,11 +147,13 @@ public:
                 return nullptr;
             }
 
-            entry->size = 0; //write always empties the file
+            if (!strcmp(mode, "w")) {
+                entry->size = 0; //write always empties the file
+            }
 
-            return std::unique_ptr<IndexedFileAdapter>(new IndexedFileAdapter(*this, entry->fname.c_str(), std::move(file)));
+            return std::unique_ptr<IndexedFileAdapter>(new IndexedFileAdapter(*this, entry->fname.c_str(), std::move(file), entry->size));
         } else {
-            MO_DBG_ERR("only support r or w");
+            MO_DBG_ERR("only support r, w or a");
             return nullptr;
         }
     }
@@ -169,6 +171,32 @@ public:
         return filesystem->remove(path);
     }
 
+    bool rename(const char *from, const char *to) override {
+        if (strlen(from) < sizeof(MO_FILENAME_PREFIX) - 1 || strlen(to) < sizeof(MO_FILENAME_PREFIX) - 1) {
+            MO_DBG_ERR("invalid fn");
+            return false;
+        }
+
+        if (!filesystem->rename(from, to)) {
+            return false;
+        }
+
+        const char *fnFrom = from + sizeof(MO_FILENAME_PREFIX) - 1;
+        const char *fnTo = to + sizeof(MO_FILENAME_PREFIX) - 1;
+        index.erase(std::remove_if(index.begin(), index.end(),
+            [fnTo] (const IndexEntry& el) -> bool {
+                return el.fname.compare(fnTo) == 0;
+            }), index.end());
+        if (auto entry = getEntryByFname(fnFrom)) {
+            entry->fname = makeString("FilesystemIndex", fnTo);
+        }
+        return true;
+    }
+
+    bool flush() override {
+        return filesystem->flush();
+    }
+
     int ftw_root(std::function<int(const char *fpath)> fn) {
         // allow fn to remove elements
         for (size_t it = 0; it < index.size();) {
@@ -388,6 +416,9 @@ public:
     bool remove(const char *fn) override {
         return USE_FS.remove(fn);
     };
+    bool rename(const char *from, const char *to) override {
+        return USE_FS.rename(from, to); //fails on SPIFFS if `to` exists
+    }
     int ftw_root(std::function<int(const char *fpath)> fn) override {
 #if MO_USE_FILEAPI == ARDUINO_LITTLEFS
         auto dir = USE_FS.open(MO_FILENAME_PREFIX);
@@ -551,6 +582,10 @@ public:
         return unlink(fn) == 0;
     }
 
+    bool rename(const char *from, const char *to) override {
+        return ::rename(from, to) == 0;
+    }
+
     int ftw_root(std::function<int(const char *fpath)> fn) override {
         //open MO root directory
         char dname [MO_MAX_PATH_SIZE];
@@ -731,6 +766,10 @@ public:
         return ::remove(fn) == 0;
     }
 
+    bool rename(const char *from, const char *to) override {
+        return ::rename(from, to) == 0;
+    }
+
     int ftw_root(std::function<int(const char *fpath)> fn) override {
         auto dir = opendir(MO_FILENAME_PREFIX); // use c_str() to convert the path string to a C-style string
         if (!dir) {
@@ -798,3 +837,395 @@ std::shared_ptr<FilesystemAdapter> makeDefaultFilesystemAdapter(FilesystemOpt co
 } //end namespace MicroOcpp
 
 #endif //switch-case MO_USE_FILEAPI
+
+namespace MicroOcpp {
+
+class FilesystemAdapterPrefixed : public FilesystemAdapter, public MemoryManaged {
+private:
+    std::shared_ptr<FilesystemAdapter> filesystem;
+    String prefix;
+
+    //translate MO_FILENAME_PREFIX "fn" into MO_FILENAME_PREFIX "<prefix>fn"
+    bool translate(const char *path, char *out) {
+        if (strncmp(path, MO_FILENAME_PREFIX, sizeof(MO_FILENAME_PREFIX) - 1)) {
+            MO_DBG_ERR("invalid path: %s", path);
+            return false;
+        }
+        const char *fn = path + sizeof(MO_FILENAME_PREFIX) - 1;
+        auto ret = snprintf(out, MO_MAX_PATH_SIZE, MO_FILENAME_PREFIX "%s%s", prefix.c_str(), fn);
+        if (ret < 0 || ret >= MO_MAX_PATH_SIZE) {
+            MO_DBG_ERR("fn error: %i", ret);
+            return false;
+        }
+        return true;
+    }
+public:
+    FilesystemAdapterPrefixed(std::shared_ptr<FilesystemAdapter> filesystem, const char *prefix) :
+            MemoryManaged("Filesystem"), filesystem(std::move(filesystem)), prefix(makeString(getMemoryTag(), prefix)) { }
+
+    int stat(const char *path, size_t *size) override {
+        char fpath [MO_MAX_PATH_SIZE];
+        if (!translate(path, fpath)) {
+            return -1;
+        }
+        return filesystem->stat(fpath, size);
+    }
+
+    std::unique_ptr<FileAdapter> open(const char *path, const char *mode) override {
+        char fpath [MO_MAX_PATH_SIZE];
+        if (!translate(path, fpath)) {
+            return nullptr;
+        }
+        return filesystem->open(fpath, mode);
+    }
+
+    bool remove(const char *path) override {
+        char fpath [MO_MAX_PATH_SIZE];
+        if (!translate(path, fpath)) {
+            return false;
+        }
+        return filesystem->remove(fpath);
+    }
+
+    bool rename(const char *from, const char *to) override {
+        char fpathFrom [MO_MAX_PATH_SIZE];
+        char fpathTo [MO_MAX_PATH_SIZE];
+        if (!translate(from, fpathFrom) || !translate(to, fpathTo)) {
+            return false;
+        }
+        return filesystem->rename(fpathFrom, fpathTo);
+    }
+
+    bool flush() override {
+        return filesystem->flush();
+    }
+
+    int ftw_root(std::function<int(const char *fpath)> fn) override {
+        return filesystem->ftw_root([this, &fn] (const char *fname) -> int {
+            if (strncmp(fname, prefix.c_str(), prefix.length())) {
+                return 0; //file of other instance, skip
+            }
+            return fn(fname + prefix.length());
+        });
+    }
+};
+
+std::shared_ptr<FilesystemAdapter> makePrefixedFilesystemAdapter(std::shared_ptr<FilesystemAdapter> filesystem, const char *prefix) {
+    if (!filesystem) {
+        return nullptr;
+    }
+
+    if (!prefix) {
+        prefix = "";
+    }
+
+    return std::allocate_shared<FilesystemAdapterPrefixed>(makeAllocator<FilesystemAdapterPrefixed>("Filesystem"), std::move(filesystem), prefix);
+}
+
+} //end namespace MicroOcpp
+
+namespace MicroOcpp {
+
+struct BufferedFile : public MemoryManaged {
+    String path;
+    String content;
+    bool append = false; //content is a pending tail of the file on the flash
+    bool removed = false; //tombstone: remove the file at the next flush()
+
+    BufferedFile(const char *path) : MemoryManaged("Filesystem"), path(makeString(getMemoryTag(), path)), content(makeString(getMemoryTag())) { }
+};
+
+class BufferedFileAdapter : public FileAdapter, public MemoryManaged {
+private:
+    std::shared_ptr<BufferedFile> file;
+    size_t pos = 0;
+public:
+    BufferedFileAdapter(std::shared_ptr<BufferedFile> file) : MemoryManaged("Filesystem"), file(std::move(file)) { }
+
+    size_t read(char *buf, size_t len) override {
+        size_t n = std::min(len, file->content.length() - pos);
+        memcpy(buf, file->content.data() + pos, n);
+        pos += n;
+        return n;
+    }
+
+    size_t write(const char *buf, size_t len) override {
+        file->content.append(buf, len);
+        return len;
+    }
+
+    size_t seek(size_t offset) override {
+        pos = std::min(offset, file->content.length());
+        return 0;
+    }
+
+    int read() override {
+        if (pos >= file->content.length()) {
+            return -1;
+        }
+        return (unsigned char) file->content[pos++];
+    }
+};
+
+//reads the file on the flash, followed by its pending tail
+class AppendedFileAdapter : public FileAdapter, public MemoryManaged {
+private:
+    std::unique_ptr<FileAdapter> base;
+    size_t baseSize;
+    BufferedFileAdapter tail;
+    size_t pos = 0;
+public:
+    AppendedFileAdapter(std::unique_ptr<FileAdapter> base, size_t baseSize, std::shared_ptr<BufferedFile> file) :
+            MemoryManaged("Filesystem"), base(std::move(base)), baseSize(this->base ? baseSize : 0), tail(std::move(file)) { }
+
+    size_t read(char *buf, size_t len) override {
+        size_t n = 0;
+        if (pos < baseSize) {
+            n = base->read(buf, std::min(len, baseSize - pos));
+            pos += n;
+            if (n == 0) {
+                pos = baseSize; //file on the flash shorter than expected
+            } else if (pos < baseSize) {
+                return n;
+            }
+        }
+        auto ntail = tail.read(buf + n, len - n);
+        pos += ntail;
+        return n + ntail;
+    }
+
+    size_t write(const char*, size_t) override {
+        return 0; //opened with "r"
+    }
+
+    size_t seek(size_t offset) override {
+        if (offset < baseSize) {
+            pos = offset;
+            tail.seek(0);
+            return base->seek(offset);
+        }
+        pos = baseSize;
+        return tail.seek(offset - baseSize);
+    }
+
+    int read() override {
+        if (pos < baseSize) {
+            int c = base->read();
+            if (c >= 0) {
+                pos++;
+                return c;
+            }
+            pos = baseSize; //file on the flash shorter than expected
+        }
+        return tail.read();
+    }
+};
+
+class FilesystemAdapterGroupCommit : public FilesystemAdapter, public MemoryManaged {
+private:
+    std::shared_ptr<FilesystemAdapter> filesystem;
+    Vector<std::shared_ptr<BufferedFile>> buffered; //files which have been changed since the last flush(), in the order of their first change
+
+    Vector<std::shared_ptr<BufferedFile>>::iterator find(const char *path) {
+        return std::find_if(buffered.begin(), buffered.end(), [path] (const std::shared_ptr<BufferedFile>& file) {
+            return file->path.compare(path) == 0;
+        });
+    }
+
+    //start the content of path over. Replaces a previous buffered content, tail or tombstone
+    std::shared_ptr<BufferedFile>& create(const char *path) {
+        auto file = find(path);
+        if (file != buffered.end()) {
+            (*file)->content.clear();
+            (*file)->append = false;
+            (*file)->removed = false;
+            return *file;
+        }
+        buffered.push_back(std::allocate_shared<BufferedFile>(makeAllocator<BufferedFile>(getMemoryTag()), path));
+        return buffered.back();
+    }
+
+    //tombstone path. Returns if the file existed
+    bool tombstone(const char *path) {
+        auto file = find(path);
+        if (file != buffered.end()) {
+            auto removed = *file;
+            bool existed = !removed->removed;
+            removed->content.clear();
+            removed->append = false;
+            removed->removed = true;
+            //if the file is created again, write it after the changes which have been made before the removal
+            buffered.erase(file);
+            buffered.push_back(std::move(removed));
+            return existed;
+        }
+        size_t size;
+        bool existed = filesystem->stat(path, &size) == 0;
+        if (existed) {
+            create(path)->removed = true;
+        }
+        return existed;
+    }
+public:
+    FilesystemAdapterGroupCommit(std::shared_ptr<FilesystemAdapter> filesystem) :
+            MemoryManaged("Filesystem"), filesystem(std::move(filesystem)), buffered(makeVector<std::shared_ptr<BufferedFile>>(getMemoryTag())) { }
+
+    ~FilesystemAdapterGroupCommit() {
+        flush();
+    }
+
+    int stat(const char *path, size_t *size) override {
+        auto file = find(path);
+        if (file != buffered.end()) {
+            if ((*file)->removed) {
+                return -1;
+            }
+            size_t baseSize = 0;
+            if ((*file)->append && filesystem->stat(path, &baseSize) != 0) {
+                baseSize = 0;
+            }
+            *size = baseSize + (*file)->content.length();
+            return 0;
+        }
+        return filesystem->stat(path, size);
+    }
+
+    std::unique_ptr<FileAdapter> open(const char *path, const char *mode) override {
+        if (!strcmp(mode, "w")) {
+            return std::unique_ptr<FileAdapter>(new BufferedFileAdapter(create(path)));
+        }
+
+        auto file = find(path);
+
+        if (!strcmp(mode, "a")) {
+            if (file == buffered.end()) {
+                //keep the appended data as pending tail
+                buffered.push_back(std::allocate_shared<BufferedFile>(makeAllocator<BufferedFile>(getMemoryTag()), path));
+                buffered.back()->append = true;
+                return std::unique_ptr<FileAdapter>(new BufferedFileAdapter(buffered.back()));
+            }
+            //appending to a removed file starts a new one
+            (*file)->removed = false;
+            auto ret = std::unique_ptr<FileAdapter>(new BufferedFileAdapter(*file));
+            ret->seek((*file)->content.length());
+            return ret;
+        }
+
+        if (file == buffered.end()) {
+            return filesystem->open(path, mode);
+        }
+
+        if ((*file)->removed) {
+            return nullptr;
+        }
+
+        if ((*file)->append) {
+            size_t baseSize = 0;
+            std::unique_ptr<FileAdapter> base;
+            if (filesystem->stat(path, &baseSize) == 0) {
+                base = filesystem->open(path, mode);
+            }
+            return std::unique_ptr<FileAdapter>(new AppendedFileAdapter(std::move(base), baseSize, *file));
+        }
+
+        return std::unique_ptr<FileAdapter>(new BufferedFileAdapter(*file));
+    }
+
+    bool remove(const char *path) override {
+        //applied after the pending writes, so that no write is lost when removing data which it supersedes
+        return tombstone(path);
+    }
+
+    bool rename(const char *from, const char *to) override {
+        auto file = find(from);
+        if (file == buffered.end() || (*file)->append) {
+            //on the flash. Commit the earlier changes first to keep the order
+            return flush() && filesystem->rename(from, to);
+        }
+
+        if ((*file)->removed) {
+            return false;
+        }
+
+        //move the pending content in RAM
+        auto moved = *file;
+        create(to)->content = std::move(moved->content);
+        tombstone(from);
+        return true;
+    }
+
+    bool flush() override {
+        //first the writes, then the removals. Otherwise a power loss in between could lose data which the removed files held
+        bool success = true;
+        for (auto file = buffered.begin(); file != buffered.end();) {
+            if ((*file)->removed) {
+                ++file;
+                continue;
+            }
+            auto content = *file;
+            bool written = false;
+            if (content->append) {
+                if (auto out = filesystem->open(content->path.c_str(), "a")) {
+                    written = out->write(content->content.data(), content->content.length()) == content->content.length();
+                }
+            } else {
+                written = FilesystemUtils::replaceFile(filesystem, content->path.c_str(), [&content] (FileAdapter& out) {
+                    return out.write(content->content.data(), content->content.length()) == content->content.length();
+                });
+            }
+            if (written) {
+                file = buffered.erase(file);
+            } else {
+                MO_DBG_ERR("could not flush %s", content->path.c_str());
+                success = false;
+                ++file; //retry at next flush()
+            }
+        }
+
+        if (success) {
+            for (auto& file : buffered) {
+                filesystem->remove(file->path.c_str()); //only tombstones left
+            }
+            buffered.clear();
+        }
+
+        return filesystem->flush() && success;
+    }
+
+    int ftw_root(std::function<int(const char *fpath)> fn) override {
+        auto ret = filesystem->ftw_root([this, &fn] (const char *fname) -> int {
+            char path [MO_MAX_PATH_SIZE];
+            auto written = snprintf(path, sizeof(path), MO_FILENAME_PREFIX "%s", fname);
+            if (written >= 0 && (size_t) written < sizeof(path) && find(path) != buffered.end()) {
+                return 0; //listed below, or removed
+            }
+            return fn(fname);
+        });
+        if (ret != 0) {
+            return ret;
+        }
+
+        //fn may remove files
+        auto pending = buffered;
+        for (auto& file : pending) {
+            if (file->removed || strncmp(file->path.c_str(), MO_FILENAME_PREFIX, sizeof(MO_FILENAME_PREFIX) - 1)) {
+                continue;
+            }
+            ret = fn(file->path.c_str() + sizeof(MO_FILENAME_PREFIX) - 1);
+            if (ret != 0) {
+                return ret;
+            }
+        }
+        return 0;
+    }
+};
+
+std::shared_ptr<FilesystemAdapter> makeGroupCommitFilesystemAdapter(std::shared_ptr<FilesystemAdapter> filesystem) {
+    if (!filesystem) {
+        return nullptr;
+    }
+
+    return std::allocate_shared<FilesystemAdapterGroupCommit>(makeAllocator<FilesystemAdapterGroupCommit>("Filesystem"), std::move(filesystem));
+}
+
+} //end namespace MicroOcpp
@@ -55,6 +55,11 @@
 #define MO_ENABLE_FILE_INDEX 0
 #endif
 
+//defer whole-file writes to one flush point at the end of Context::loop() (see makeGroupCommitFilesystemAdapter())
+#ifndef MO_ENABLE_GROUP_COMMIT
+#define MO_ENABLE_GROUP_COMMIT 0
+#endif
+
 namespace MicroOcpp {
 
 class FileAdapter {
@@ -71,9 +76,19 @@ class FilesystemAdapter {
 public:
     virtual ~FilesystemAdapter() = default;
     virtual int stat(const char *path, size_t *size) = 0;
-    virtual std::unique_ptr<FileAdapter> open(const char *fn, const char *mode) = 0;
+    virtual std::unique_ptr<FileAdapter> open(const char *fn, const char *mode) = 0; //mode: "r", "w" or "a" (append)
     virtual bool remove(const char *fn) = 0;
     virtual int ftw_root(std::function<int(const char *fpath)> fn) = 0; //enumerate the files in the mo_store root folder
+
+    /*
+     * Optional. Replace `to` with `from` in one step, so that a power loss leaves either the old or the new `to`.
+     * Returning false (e.g. if `to` exists and the filesystem can't replace it) makes FilesystemUtils::replaceFile()
+     * fall back to a shadow copy
+     */
+    virtual bool rename(const char* /*from*/, const char* /*to*/) {return false;}
+
+    //Optional. Write changes which the adapter has buffered. Context::loop() calls this at the end of each loop
+    virtual bool flush() {return true;}
 };
 
 /*
@@ -89,6 +104,31 @@ public:
  */
 std::shared_ptr<FilesystemAdapter> makeDefaultFilesystemAdapter(FilesystemOpt config);
 
+/*
+ * Decorator which prepends `prefix` to all filenames, e.g. MO_FILENAME_PREFIX "ocpp-config.jsn" becomes
+ * MO_FILENAME_PREFIX "cp1-ocpp-config.jsn" with prefix "cp1-". This way, multiple MO instances can share one
+ * filesystem (see mocpp_select_instance()). ftw_root only enumerates the files with the prefix
+ *
+ * Returns null if filesystem is null
+ */
+std::shared_ptr<FilesystemAdapter> makePrefixedFilesystemAdapter(std::shared_ptr<FilesystemAdapter> filesystem, const char *prefix);
+
+/*
+ * Decorator which keeps the files that are written with mode "w" or "a" in RAM until the next flush(). Repeated
+ * writes of the same file within one loop reach the flash only once, and all writes of the loop are done at one
+ * point: replaced files as crash-safe replacement (see FilesystemUtils::replaceFile()), appended data as one
+ * append. Removals are buffered too and applied after the writes, so data reaches the flash before the files
+ * which it supersedes disappear. Reads, stat and ftw_root see the buffered state. Renaming a file which is on the
+ * flash flushes first and then goes directly to `filesystem`. The destructor flushes
+ *
+ * mocpp_initialize() applies this decorator with the build flag MO_ENABLE_GROUP_COMMIT. The boot statistics bypass
+ * the batching: mocpp_initialize() and mocpp_deinitialize() flush right after storing them, so that a firmware
+ * which crashes before its first loop ends still counts as a failed boot (see BootStats::getBootFailureCount())
+ *
+ * Returns null if filesystem is null
+ */
+std::shared_ptr<FilesystemAdapter> makeGroupCommitFilesystemAdapter(std::shared_ptr<FilesystemAdapter> filesystem);
+
 } //end namespace MicroOcpp
 
 #endif
@@ -5,21 +5,40 @@
 #include <MicroOcpp/Core/FilesystemAdapter.h>
 #include <MicroOcpp/Core/FilesystemUtils.h>
 #include <MicroOcpp/Core/ConfigurationOptions.h> //FilesystemOpt
+#include <MicroOcpp/Platform.h>
 #include <MicroOcpp/Debug.h>
 
+#include <cstdio>
+#include <cstring>
+
 using namespace MicroOcpp;
 
-std::unique_ptr<JsonDoc> FilesystemUtils::loadJson(std::shared_ptr<FilesystemAdapter> filesystem, const char *fn, const char *memoryTag) {
-    if (!filesystem || !fn || *fn == '\0') {
-        MO_DBG_ERR("Format error");
-        return nullptr;
+#if MO_JSON_FILE_BUFSIZE > 0
+namespace {
+//buffer which is reused by all loadJson() calls of this thread. Freed on thread exit
+struct ReadBuffer {
+    char *buf = nullptr;
+    ~ReadBuffer() {
+        MO_FREE(buf);
     }
+};
+MO_THREAD_LOCAL ReadBuffer readBuf;
+} //end namespace
+
+void FilesystemUtils::freeReadBuffer() {
+    MO_FREE(readBuf.buf);
+    readBuf.buf = nullptr;
+}
+#else
+void FilesystemUtils::freeReadBuffer() {
+
+}
+#endif //MO_JSON_FILE_BUFSIZE > 0
+
+namespace {
+
+std::unique_ptr<JsonDoc> loadJsonFile(std::shared_ptr<FilesystemAdapter> filesystem, const char *fn, const char *memoryTag) {
 
-    if (strnlen(fn, MO_MAX_PATH_SIZE) >= MO_MAX_PATH_SIZE) {
-        MO_DBG_ERR("Fn too long: %.*s", MO_MAX_PATH_SIZE, fn);
-        return nullptr;
-    }
-    
     size_t fsize = 0;
     if (filesystem->stat(fn, &fsize) != 0) {
         MO_DBG_DEBUG("File does not exist: %s", fn);
@@ -38,6 +57,49 @@ std::unique_ptr<JsonDoc> FilesystemUtils::loadJson(std::shared_ptr<FilesystemAda
         return nullptr;
     }
 
+#if MO_JSON_FILE_BUFSIZE > 0
+    /*
+     * Small files: read the whole file into the reusable buffer, then measure the exact capacity of the document
+     * and deserialize it with a single allocation
+     */
+    if (fsize <= MO_JSON_FILE_BUFSIZE) {
+        if (!readBuf.buf) {
+            readBuf.buf = static_cast<char*>(MO_MALLOC("FilesystemUtils", MO_JSON_FILE_BUFSIZE));
+        }
+
+        size_t len = 0;
+        while (readBuf.buf && len < fsize) {
+            size_t ret = file->read(readBuf.buf + len, fsize - len);
+            if (ret == 0) {
+                break;
+            }
+            len += ret;
+        }
+
+        if (readBuf.buf && len == fsize) {
+            size_t capacity = measureJsonCapacity(readBuf.buf, len);
+            if (capacity > MO_MAX_JSON_CAPACITY) {
+                MO_DBG_ERR("Error deserializing file %s: %s", fn, DeserializationError(DeserializationError::NoMemory).c_str());
+                return nullptr;
+            }
+
+            auto doc = makeJsonDoc(memoryTag, capacity);
+            auto err = deserializeJson(*doc, static_cast<const char*>(readBuf.buf), len); //const input: copy the strings into doc
+            if (err) {
+                MO_DBG_ERR("Error deserializing file %s: %s", fn, err.c_str());
+                //skip this file
+                return nullptr;
+            }
+
+            MO_DBG_DEBUG("Loaded JSON file: %s", fn);
+            return doc;
+        }
+
+        //fall back to streaming
+        file->seek(0);
+    }
+#endif //MO_JSON_FILE_BUFSIZE > 0
+
     size_t capacity_init = (3 * fsize) / 2;
 
     //capacity = ceil capacity_init to the next power of two; should be at least 128
@@ -75,6 +137,49 @@ std::unique_ptr<JsonDoc> FilesystemUtils::loadJson(std::shared_ptr<FilesystemAda
     return doc;
 }
 
+} //end namespace
+
+std::unique_ptr<JsonDoc> FilesystemUtils::loadJson(std::shared_ptr<FilesystemAdapter> filesystem, const char *fn, const char *memoryTag) {
+    if (!filesystem || !fn || *fn == '\0') {
+        MO_DBG_ERR("Format error");
+        return nullptr;
+    }
+
+    if (strnlen(fn, MO_MAX_PATH_SIZE) >= MO_MAX_PATH_SIZE) {
+        MO_DBG_ERR("Fn too long: %.*s", MO_MAX_PATH_SIZE, fn);
+        return nullptr;
+    }
+
+    char tmpFn [MO_MAX_PATH_SIZE];
+    size_t tmpSize;
+    if (printTmpFn(tmpFn, sizeof(tmpFn), fn) && filesystem->stat(tmpFn, &tmpSize) == 0) {
+        //a replaceFile() has been interrupted. If the temporary file is complete, it has the latest content
+        if (auto doc = loadJsonFile(filesystem, tmpFn, memoryTag)) {
+            MO_DBG_WARN("complete interrupted write of %s", fn);
+            if (!filesystem->rename(tmpFn, fn)) {
+                //write fn in place. The temporary file is the only complete copy until then, so don't rewrite it
+                bool written = false;
+                if (auto file = filesystem->open(fn, "w")) {
+                    ArduinoJsonFileAdapter fileWriter {file.get()};
+                    written = serializeJson(*doc, fileWriter) >= 2;
+                }
+                if (written) {
+                    filesystem->remove(tmpFn);
+                } else {
+                    MO_DBG_ERR("Could not write file %s", fn);
+                }
+            }
+            return doc;
+        }
+
+        //incomplete. fn is still intact
+        MO_DBG_WARN("discard interrupted write of %s", fn);
+        filesystem->remove(tmpFn);
+    }
+
+    return loadJsonFile(filesystem, fn, memoryTag);
+}
+
 bool FilesystemUtils::storeJson(std::shared_ptr<FilesystemAdapter> filesystem, const char *fn, const JsonDoc& doc) {
     if (!filesystem || !fn || *fn == '\0') {
         MO_DBG_ERR("Format error");
@@ -91,33 +196,70 @@ bool FilesystemUtils::storeJson(std::shared_ptr<FilesystemAdapter> filesystem, c
         return false;
     }
 
-    auto file = filesystem->open(fn, "w");
-    if (!file) {
-        MO_DBG_ERR("Could not open file %s", fn);
+    bool success = replaceFile(filesystem, fn, [&doc] (FileAdapter& file) {
+        ArduinoJsonFileAdapter fileWriter {&file};
+        return serializeJson(doc, fileWriter) >= 2;
+    });
+
+    if (!success) {
+        MO_DBG_ERR("Error writing file %s", fn);
         return false;
     }
 
-    ArduinoJsonFileAdapter fileWriter {file.get()};
+    MO_DBG_DEBUG("Wrote JSON file: %s", fn);
+    return true;
+}
 
-    size_t written = serializeJson(doc, fileWriter);
+bool FilesystemUtils::replaceFile(std::shared_ptr<FilesystemAdapter> filesystem, const char *fn, std::function<bool(FileAdapter& file)> write) {
 
-    if (written < 2) {
-        MO_DBG_ERR("Error writing file %s", fn);
-        size_t file_size = 0;
-        if (filesystem->stat(fn, &file_size) == 0) {
-            MO_DBG_DEBUG("Collect invalid file %s", fn);
-            filesystem->remove(fn);
-        }
+    char tmpFn [MO_MAX_PATH_SIZE];
+    if (!printTmpFn(tmpFn, sizeof(tmpFn), fn)) {
+        MO_DBG_WARN("no space for temporary file of %s. Write in place", fn);
+        auto file = filesystem->open(fn, "w");
+        return file && write(*file);
+    }
+
+    bool written = false;
+    if (auto file = filesystem->open(tmpFn, "w")) {
+        written = write(*file);
+    } //close before replacing fn
+
+    if (!written) {
+        MO_DBG_ERR("Could not write file %s", tmpFn);
+        filesystem->remove(tmpFn);
         return false;
     }
 
-    MO_DBG_DEBUG("Wrote JSON file: %s", fn);
+    if (filesystem->rename(tmpFn, fn)) {
+        return true;
+    }
+
+    //no atomic rename on this filesystem. Write fn in place, the temporary file keeps the new content meanwhile
+    written = false;
+    if (auto file = filesystem->open(fn, "w")) {
+        written = write(*file);
+    }
+
+    if (!written) {
+        MO_DBG_ERR("Could not write file %s", fn);
+        return false; //the next loadJson() recovers from the temporary file
+    }
+
+    filesystem->remove(tmpFn);
     return true;
 }
 
+bool FilesystemUtils::printTmpFn(char *out, size_t size, const char *fn) {
+    const char *name = strrchr(fn, '/');
+    name = name ? name + 1 : fn;
+    auto ret = snprintf(out, size, "%.*s~%s", (int) (name - fn), fn, name);
+    return ret >= 0 && (size_t) ret < size;
+}
+
 bool FilesystemUtils::remove_if(std::shared_ptr<FilesystemAdapter> filesystem, std::function<bool(const char*)> pred) {
     auto ret = filesystem->ftw_root([filesystem, pred] (const char *fpath) {
-        if (pred(fpath)) {
+        //temporary files of replaceFile() go with the file which they replace
+        if (pred(fpath[0] == '~' ? fpath + 1 : fpath)) {
 
             char fn [MO_MAX_PATH_SIZE] = {'\0'};
             auto ret = snprintf(fn, MO_MAX_PATH_SIZE, MO_FILENAME_PREFIX "%s", fpath);
@@ -10,6 +10,11 @@
 #include <ArduinoJson.h>
 #include <memory>
 
+//files up to this size are read into a reusable buffer and deserialized into a JsonDoc of exactly the needed capacity. 0 = stream all files
+#ifndef MO_JSON_FILE_BUFSIZE
+#define MO_JSON_FILE_BUFSIZE 2048
+#endif
+
 namespace MicroOcpp {
 
 class ArduinoJsonFileAdapter {
@@ -38,10 +43,22 @@ public:
 namespace FilesystemUtils {
 
 std::unique_ptr<JsonDoc> loadJson(std::shared_ptr<FilesystemAdapter> filesystem, const char *fn, const char *memoryTag = nullptr);
-bool storeJson(std::shared_ptr<FilesystemAdapter> filesystem, const char *fn, const JsonDoc& doc);
+bool storeJson(std::shared_ptr<FilesystemAdapter> filesystem, const char *fn, const JsonDoc& doc); //crash-safe, see replaceFile()
+
+/*
+ * Replace the file fn so that a power loss leaves either the old or the new content. write() writes the new
+ * content into a temporary file which then replaces fn via FilesystemAdapter::rename(). Filesystems without
+ * rename get fn written in place after the temporary file is complete, which serves as shadow copy in between.
+ * loadJson() completes an interrupted replacement
+ */
+bool replaceFile(std::shared_ptr<FilesystemAdapter> filesystem, const char *fn, std::function<bool(FileAdapter& file)> write);
+
+bool printTmpFn(char *out, size_t size, const char *fn); //temporary file of replaceFile(): "~" in front of the file name
 
 bool remove_if(std::shared_ptr<FilesystemAdapter> filesystem, std::function<bool(const char*)> pred);
 
+void freeReadBuffer(); //free the buffer of loadJson() of the calling thread. It is allocated again with the next loadJson(). Other threads free their buffers on exit
+
 }
 
 }
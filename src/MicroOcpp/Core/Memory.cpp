@@ -3,37 +3,56 @@
 // MIT License
 
 #include <MicroOcpp/Core/Memory.h>
+#include <MicroOcpp/Core/SlabAllocator.h>
 #include <MicroOcpp/Debug.h>
 
 #if MO_OVERRIDE_ALLOCATION && MO_ENABLE_HEAP_PROFILER
 
-#include <map>
+#include <algorithm>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if MO_ENABLE_MULTI_INSTANCE
+#include <mutex>
+#endif
+
+static_assert((MO_HEAP_PROFILER_MAXBLOCKS & (MO_HEAP_PROFILER_MAXBLOCKS - 1)) == 0, "MO_HEAP_PROFILER_MAXBLOCKS must be a power of 2");
+static_assert((MO_HEAP_PROFILER_MAXTAGS & (MO_HEAP_PROFILER_MAXTAGS - 1)) == 0, "MO_HEAP_PROFILER_MAXTAGS must be a power of 2");
+
+#define MO_MEM_NOTAGGER 0xFFFF //block hasn't been tagged by an object yet
 
 namespace MicroOcpp {
 namespace Memory {
 
-struct MemBlockInfo {
-    void* tagger_ptr = nullptr;
-    std::string tag;
-    size_t size = 0;
+#if MO_ENABLE_MULTI_INSTANCE
+std::mutex memMutex; //the instances may allocate from different threads
+#define MO_MEM_LOCK() std::lock_guard<std::mutex> memLock(MicroOcpp::Memory::memMutex)
+#else
+#define MO_MEM_LOCK() (void)0
+#endif
 
-    MemBlockInfo(void* ptr, const char *tag, size_t size) : size{size} {
-        updateTag(ptr, tag);
-    }
+/*
+ * The profiler tables live outside of the statistics: they are allocated with the system malloc once and have a
+ * fixed capacity. Both are open addressing hash tables with linear probing
+ */
 
-    void updateTag(void* ptr, const char *tag);
+struct MemBlockInfo {
+    void *ptr = nullptr; //nullptr = empty slot
+    uint32_t size = 0; //accounted size. With sampling, the block size multiplied with the sample rate
+    TagId tagId = 0; //0 = untagged
+    uint16_t taggerOffset = MO_MEM_NOTAGGER; //offset of the object which has set the tag. Outer objects win
 };
 
-std::map<void*,MemBlockInfo> memBlocks; //key: memory address of malloc'd block
+MemBlockInfo *memBlocks = nullptr;
+size_t memBlocksCount = 0;
 
 struct MemTagInfo {
+    char *tag = nullptr; //nullptr = empty slot
+    uint32_t hash = 0;
     size_t current_size = 0;
     size_t max_size = 0;
 
-    MemTagInfo(size_t size) {
-        operator+=(size);
-    }
-
     void operator+=(size_t size) {
         current_size += size;
         max_size = std::max(max_size, current_size);
@@ -52,34 +71,188 @@ struct MemTagInfo {
     }
 };
 
-std::map<std::string,MemTagInfo> memTags;
+MemTagInfo *memTags = nullptr; //tag ID = slot index + 1
+size_t memTagsCount = 0;
 
 size_t memTotal, memTotalMax;
+size_t untaggedCount, untaggedSize;
+size_t untrackedCount; //blocks which didn't fit into memBlocks and are missing in the statistics
+
+unsigned int sampleRate = MO_HEAP_PROFILER_SAMPLE_RATE;
+unsigned int sampleCounter = 0;
+
+size_t blockIndex(void *ptr) {
+    uint32_t h = (uint32_t) ((uintptr_t) ptr >> 3);
+    h ^= h >> 16;
+    h *= 0x7feb352dU;
+    h ^= h >> 15;
+    return h & (MO_HEAP_PROFILER_MAXBLOCKS - 1);
+}
+
+bool initBlocks() {
+    if (!memBlocks) {
+        memBlocks = static_cast<MemBlockInfo*>(calloc(MO_HEAP_PROFILER_MAXBLOCKS, sizeof(MemBlockInfo)));
+    }
+    return memBlocks != nullptr;
+}
+
+MemBlockInfo *findBlock(void *ptr) {
+    for (size_t i = blockIndex(ptr);; i = (i + 1) & (MO_HEAP_PROFILER_MAXBLOCKS - 1)) {
+        if (memBlocks[i].ptr == ptr) {
+            return &memBlocks[i];
+        } else if (!memBlocks[i].ptr) {
+            return nullptr;
+        }
+    }
+}
+
+//remove the slot and move the following entries of the probe sequence up, so that no tombstones are needed
+void eraseBlock(MemBlockInfo *block) {
+    const size_t mask = MO_HEAP_PROFILER_MAXBLOCKS - 1;
+    size_t hole = block - memBlocks;
+    for (size_t i = (hole + 1) & mask; memBlocks[i].ptr; i = (i + 1) & mask) {
+        size_t home = blockIndex(memBlocks[i].ptr);
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            memBlocks[hole] = memBlocks[i];
+            hole = i;
+        }
+    }
+    memBlocks[hole] = MemBlockInfo();
+    memBlocksCount--;
+}
 
-void MemBlockInfo::updateTag(void* ptr, const char *tag) {
+//return the ID of the concatenation of tag and tag_suffix. Adds the tag if it's unknown. Returns 0 if the tag table is full
+TagId internTagLocked(const char *tag, const char *tag_suffix) {
     if (!tag) {
-        return;
+        tag = "";
+    }
+    if (!tag_suffix) {
+        tag_suffix = "";
+    }
+
+    uint32_t hash = 2166136261U; //FNV-1a
+    size_t len = 0;
+    for (const char *c = tag; *c; c++, len++) {
+        hash = (hash ^ (unsigned char) *c) * 16777619U;
+    }
+    size_t suffix_len = 0;
+    for (const char *c = tag_suffix; *c; c++, suffix_len++) {
+        hash = (hash ^ (unsigned char) *c) * 16777619U;
     }
-    if (tagger_ptr == nullptr || ptr < tagger_ptr) {
-        MO_DBG_VERBOSE("update tag from %s to %s, ptr from %p to %p", this->tag.c_str(), tag, tagger_ptr, ptr);
 
-        auto tagInfo = memTags.find(this->tag);
-        if (tagInfo != memTags.end()) {
-            tagInfo->second -= size;
+    if (len + suffix_len == 0) {
+        return 0;
+    }
+
+    if (!memTags) {
+        memTags = static_cast<MemTagInfo*>(calloc(MO_HEAP_PROFILER_MAXTAGS, sizeof(MemTagInfo)));
+        if (!memTags) {
+            return 0;
         }
+    }
 
-        tagInfo = memTags.find(tag);
-        if (tagInfo != memTags.end()) {
-            tagInfo->second += size;
-        } else {
-            memTags.emplace(tag, size);
+    for (size_t i = hash & (MO_HEAP_PROFILER_MAXTAGS - 1);; i = (i + 1) & (MO_HEAP_PROFILER_MAXTAGS - 1)) {
+        auto& tagInfo = memTags[i];
+        if (!tagInfo.tag) {
+            if (memTagsCount + 1 >= MO_HEAP_PROFILER_MAXTAGS) {
+                MO_DBG_WARN("tag table full (see MO_HEAP_PROFILER_MAXTAGS)");
+                return 0;
+            }
+            char *name = static_cast<char*>(malloc(len + suffix_len + 1)); //heap profiler bypasses custom malloc to not count into the statistics
+            if (!name) {
+                return 0;
+            }
+            memcpy(name, tag, len);
+            memcpy(name + len, tag_suffix, suffix_len + 1);
+            tagInfo.tag = name;
+            tagInfo.hash = hash;
+            memTagsCount++;
+            return (TagId) (i + 1);
+        } else if (tagInfo.hash == hash && !strncmp(tagInfo.tag, tag, len) && !strcmp(tagInfo.tag + len, tag_suffix)) {
+            return (TagId) (i + 1);
         }
+    }
+}
+
+void addToTag(TagId tagId, size_t size) {
+    if (tagId) {
+        memTags[tagId - 1] += size;
+    } else {
+        untaggedCount++;
+        untaggedSize += size;
+    }
+}
 
-        tagger_ptr = ptr;
-        this->tag = tag;
+void removeFromTag(TagId tagId, size_t size) {
+    if (tagId) {
+        memTags[tagId - 1] -= size;
+    } else {
+        untaggedCount--;
+        untaggedSize -= size;
     }
 }
 
+void updateTag(MemBlockInfo& block, size_t taggerOffset, TagId tagId) {
+    if (!tagId) {
+        return;
+    }
+    if (block.taggerOffset == MO_MEM_NOTAGGER || taggerOffset < block.taggerOffset) {
+        MO_DBG_VERBOSE("update tag from %u to %u (%s), offset from %u to %zu", block.tagId, tagId, memTags[tagId - 1].tag, block.taggerOffset, taggerOffset);
+
+        removeFromTag(block.tagId, block.size);
+        addToTag(tagId, block.size);
+
+        block.tagId = tagId;
+        block.taggerOffset = (uint16_t) taggerOffset;
+    }
+}
+
+void addBlock(void *ptr, TagId tagId, size_t size) {
+
+    if (sampleRate > 1) {
+        if (++sampleCounter < sampleRate) {
+            return;
+        }
+        sampleCounter = 0;
+        size *= sampleRate;
+    }
+
+    if (!initBlocks() || memBlocksCount + 1 > (MO_HEAP_PROFILER_MAXBLOCKS * 3) / 4) {
+        untrackedCount++;
+        return;
+    }
+
+    size_t i = blockIndex(ptr);
+    while (memBlocks[i].ptr) {
+        i = (i + 1) & (MO_HEAP_PROFILER_MAXBLOCKS - 1);
+    }
+
+    auto& block = memBlocks[i];
+    block.ptr = ptr;
+    block.size = (uint32_t) std::min(size, (size_t) UINT32_MAX);
+    block.tagId = 0;
+    block.taggerOffset = MO_MEM_NOTAGGER;
+    memBlocksCount++;
+
+    addToTag(0, block.size);
+    updateTag(block, 0, tagId);
+
+    memTotal += block.size;
+    memTotalMax = std::max(memTotalMax, memTotal);
+}
+
+TagId internTag(const char *tag, const char *tag_suffix) {
+    if (!tag && !tag_suffix) {
+        return 0;
+    }
+    MO_MEM_LOCK();
+    return internTagLocked(tag, tag_suffix);
+}
+
+const char *getTag(TagId tagId) {
+    return tagId ? memTags[tagId - 1].tag : nullptr; //slots of the tag table never change after they have been filled
+}
+
 } //namespace Memory
 } //namespace MicroOcpp
 
@@ -93,6 +266,54 @@ namespace Memory {
 void* (*malloc_override)(size_t);
 void (*free_override)(void*);
 
+void *hostMalloc(size_t size) {
+    if (malloc_override) {
+        return malloc_override(size);
+    } else {
+        return malloc(size);
+    }
+}
+
+void hostFree(void *ptr) {
+    if (free_override) {
+        free_override(ptr);
+    } else {
+        free(ptr);
+    }
+}
+
+void *allocate(size_t size) {
+    #if MO_ENABLE_SLAB_ALLOCATOR
+    if (auto ptr = slabMalloc(size)) {
+        return ptr;
+    }
+    #endif
+    return hostMalloc(size);
+}
+
+void deallocate(void *ptr) {
+    #if MO_ENABLE_SLAB_ALLOCATOR
+    if (slabFree(ptr)) {
+        return;
+    }
+    #endif
+    hostFree(ptr);
+}
+
+#if MO_ENABLE_HEAP_PROFILER
+void *mallocTagged(TagId tagId, size_t size) {
+    MO_DBG_VERBOSE("malloc %zu B (%s)", size, tagId ? getTag(tagId) : "unspecified");
+
+    void *ptr = allocate(size);
+
+    if (ptr) {
+        MO_MEM_LOCK();
+        addBlock(ptr, tagId, size);
+    }
+    return ptr;
+}
+#endif //MO_ENABLE_HEAP_PROFILER
+
 }
 }
 
@@ -104,24 +325,13 @@ void mo_mem_set_malloc_free(void* (*malloc_override)(size_t), void (*free_overri
 }
 
 void *mo_mem_malloc(const char *tag, size_t size) {
-    MO_DBG_VERBOSE("malloc %zu B (%s)", size, tag ? tag : "unspecified");
-
-    void *ptr;
-    if (malloc_override) {
-        ptr = malloc_override(size);
-    } else {
-        ptr = malloc(size);
-    }
-
     #if MO_ENABLE_HEAP_PROFILER
-    if (ptr) {
-        memBlocks.emplace(ptr, MemBlockInfo(ptr, tag, size));
+    return mallocTagged(internTag(tag), size);
+    #else
+    MO_DBG_VERBOSE("malloc %zu B (%s)", size, tag ? tag : "unspecified");
 
-        memTotal += size;
-        memTotalMax = std::max(memTotalMax, memTotal);
-    }
+    return allocate(size);
     #endif
-    return ptr;
 }
 
 void mo_mem_free(void* ptr) {
@@ -129,27 +339,17 @@ void mo_mem_free(void* ptr) {
 
     #if MO_ENABLE_HEAP_PROFILER
     if (ptr) {
+        MO_MEM_LOCK();
 
-        auto blockInfo = memBlocks.find(ptr);
-        if (blockInfo != memBlocks.end()) {
-            auto tagInfo = memTags.find(blockInfo->second.tag);
-            if (tagInfo != memTags.end()) {
-                tagInfo->second -= blockInfo->second.size;
-            }
-            memTotal -= blockInfo->second.size;
-        }
-
-        if (blockInfo != memBlocks.end()) {
-            memBlocks.erase(blockInfo);
+        if (auto block = memBlocks ? findBlock(ptr) : nullptr) {
+            removeFromTag(block->tagId, block->size);
+            memTotal -= block->size;
+            eraseBlock(block);
         }
     }
     #endif
 
-    if (free_override) {
-        free_override(ptr);
-    } else {
-        free(ptr);
-    }
+    deallocate(ptr);
 }
 
 #endif //MO_OVERRIDE_ALLOCATION
@@ -157,20 +357,43 @@ void mo_mem_free(void* ptr) {
 #if MO_OVERRIDE_ALLOCATION && MO_ENABLE_HEAP_PROFILER
 
 void mo_mem_deinit() {
-    memBlocks.clear();
-    memTags.clear();
+    MO_MEM_LOCK();
+    //keep the tag registry, the tag IDs of the remaining objects must stay valid
+    if (memTags) {
+        for (size_t i = 0; i < MO_HEAP_PROFILER_MAXTAGS; i++) {
+            memTags[i].current_size = 0;
+            memTags[i].max_size = 0;
+        }
+    }
+    free(memBlocks);
+    memBlocks = nullptr;
+    memBlocksCount = 0;
+    memTotal = 0;
+    memTotalMax = 0;
+    untaggedCount = 0;
+    untaggedSize = 0;
+    untrackedCount = 0;
 }
 
 void mo_mem_reset() {
     MO_DBG_DEBUG("Reset all maximum values to current values");
+    MO_MEM_LOCK();
 
-    for (auto tagInfo = (memTags).begin(); tagInfo != memTags.end(); ++tagInfo) {
-        tagInfo->second.reset();
+    if (memTags) {
+        for (size_t i = 0; i < MO_HEAP_PROFILER_MAXTAGS; i++) {
+            memTags[i].reset();
+        }
     }
 
     memTotalMax = memTotal;
 }
 
+void mo_mem_set_sample_rate(unsigned int rate) {
+    MO_MEM_LOCK();
+    sampleRate = rate > 1 ? rate : 1;
+    sampleCounter = 0;
+}
+
 void mo_mem_set_tag(void *ptr, const char *tag) {
     MO_DBG_VERBOSE("set tag (%s)", tag ? tag : "unspecified");
 
@@ -178,108 +401,90 @@ void mo_mem_set_tag(void *ptr, const char *tag) {
         return;
     }
 
-    bool hasTagged = false;
+    setTag(ptr, internTag(tag));
+}
+
+void MicroOcpp::Memory::setTag(void *ptr, TagId tagId) {
+    if (!tagId) {
+        return;
+    }
+
+    MO_MEM_LOCK();
+
+    if (!memBlocks) {
+        return;
+    }
 
-    if (tag) {
-        auto foundBlock = memBlocks.upper_bound(ptr);
-        if (foundBlock != memBlocks.begin()) {
-            --foundBlock;
+    /*
+     * The tagged object is either at the start of a block, or a base class or member close to the start. Look up
+     * the block start in steps of the pointer size. Blocks which don't contain ptr are skipped
+     */
+    for (size_t offset = 0; offset <= MO_HEAP_PROFILER_TAG_MAXOFFSET; offset += sizeof(void*)) {
+        if ((uintptr_t) ptr < offset) {
+            break;
         }
-        if (foundBlock != memBlocks.end() &&
-                (unsigned char*)ptr - (unsigned char*)foundBlock->first < (std::ptrdiff_t)foundBlock->second.size) {
-            foundBlock->second.updateTag(ptr, tag);
-            hasTagged = true;
+        auto block = findBlock((unsigned char*) ptr - offset);
+        if (block && offset < block->size) {
+            updateTag(*block, offset, tagId);
+            return;
         }
     }
 
-    if (!hasTagged) {
-        MO_DBG_VERBOSE("memory area doesn't apply");
-    }
+    MO_DBG_VERBOSE("memory area doesn't apply");
 }
 
 void mo_mem_print_stats() {
+    MO_MEM_LOCK();
 
     MO_CONSOLE_PRINTF("\n *** Heap usage statistics ***\n");
 
-    size_t size = 0;
-
-    size_t untagged = 0, untagged_size = 0;
-
-    for (const auto& heapEntry : memBlocks) {
-        size += heapEntry.second.size;
-        #if MO_DBG_LEVEL >= MO_DL_VERBOSE
-        {
-            MO_CONSOLE_PRINTF("@%p - %zu B (%s)\n", heapEntry.first, heapEntry.second.size, heapEntry.second.tag.c_str());
-        }
-        #endif
-
-        if (heapEntry.second.tag.empty()) {
-            untagged ++;
-            untagged_size += heapEntry.second.size;
-        }
-    }
-
-    std::map<std::string, size_t> tags;
-    for (const auto& heapEntry : memBlocks) {
-        auto foundTag = tags.find(heapEntry.second.tag);
-        if (foundTag != tags.end()) {
-            foundTag->second += heapEntry.second.size;
-        } else {
-            tags.emplace(heapEntry.second.tag, heapEntry.second.size);
-        }
-    }
-
     size_t size_control = 0;
 
-    for (const auto& tag : tags) {
-        size_control += tag.second;
-        #if MO_DBG_LEVEL >= MO_DL_VERBOSE
-        {
-            MO_CONSOLE_PRINTF("%s - %zu B\n", tag.first.c_str(), tag.second);
+    if (memTags) {
+        for (size_t i = 0; i < MO_HEAP_PROFILER_MAXTAGS; i++) {
+            if (memTags[i].tag) {
+                size_control += memTags[i].current_size;
+                MO_CONSOLE_PRINTF("%s - %zu B (max. %zu B)\n", memTags[i].tag, memTags[i].current_size, memTags[i].max_size);
+            }
         }
-        #endif
-    }
-
-    size_t size_control2 = 0;
-    for (const auto& tag : memTags) {
-        size_control2 += tag.second.current_size;
-        MO_CONSOLE_PRINTF("%s - %zu B (max. %zu B)\n", tag.first.c_str(), tag.second.current_size, tag.second.max_size);
     }
 
-    MO_CONSOLE_PRINTF(" *** Summary ***\nBlocks: %zu\nTags: %zu\nCurrent usage: %zu B\nMaximum usage: %zu B\n", memBlocks.size(), memTags.size(), memTotal, memTotalMax);
+    MO_CONSOLE_PRINTF(" *** Summary ***\nBlocks: %zu\nTags: %zu\nCurrent usage: %zu B\nMaximum usage: %zu B\n", memBlocksCount, memTagsCount, memTotal, memTotalMax);
     #if MO_DBG_LEVEL >= MO_DL_DEBUG
     {
-        MO_CONSOLE_PRINTF(" *** Debug information ***\nTotal blocks (control value 1): %zu B\nTags (control value): %zu\nTotal tagged (control value 2): %zu B\nTotal tagged (control value 3): %zu B\nUntagged: %zu\nTotal untagged: %zu B\n", size, tags.size(), size_control, size_control2, untagged, untagged_size);
+        MO_CONSOLE_PRINTF(" *** Debug information ***\nTotal tagged (control value): %zu B\nUntagged: %zu\nTotal untagged: %zu B\nUntracked: %zu\nSample rate: %u\n", size_control, untaggedCount, untaggedSize, untrackedCount, sampleRate);
     }
     #endif
 }
 
 int mo_mem_write_stats_json(char *buf, size_t size) {
+    MO_MEM_LOCK();
     DynamicJsonDocument doc {size * 2};
 
     doc["total_current"] = memTotal;
     doc["total_max"] = memTotalMax;
-    doc["total_blocks"] = memBlocks.size();
+    doc["total_blocks"] = memBlocksCount;
 
     JsonArray by_tag = doc.createNestedArray("by_tag");
-    for (const auto& tag : memTags) {
-        JsonObject entry = by_tag.createNestedObject();
-        entry["tag"] = tag.first.c_str();
-        entry["current"] = tag.second.current_size;
-        entry["max"] = tag.second.max_size;
-    }
-
-    size_t untagged = 0, untagged_size = 0;
-
-    for (const auto& heapEntry : memBlocks) {
-        if (heapEntry.second.tag.empty()) {
-            untagged ++;
-            untagged_size += heapEntry.second.size;
+    if (memTags) {
+        for (size_t i = 0; i < MO_HEAP_PROFILER_MAXTAGS; i++) {
+            if (memTags[i].tag) {
+                JsonObject entry = by_tag.createNestedObject();
+                entry["tag"] = (const char*) memTags[i].tag;
+                entry["current"] = memTags[i].current_size;
+                entry["max"] = memTags[i].max_size;
+            }
         }
     }
 
-    doc["untagged_blocks"] = untagged;
-    doc["untagged_size"] = untagged_size;
+    doc["untagged_blocks"] = untaggedCount;
+    doc["untagged_size"] = untaggedSize;
+    doc["untracked_blocks"] = untrackedCount;
+    doc["sample_rate"] = sampleRate;
+
+    #if MO_ENABLE_SLAB_ALLOCATOR
+    writeSlabStats(doc.createNestedObject("slabs"));
+    #endif
 
     if (doc.overflowed()) {
         MO_DBG_ERR("exceeded JSON capacity");
@@ -325,4 +530,96 @@ std::unique_ptr<JsonDoc> makeJsonDoc(const char *tag, size_t capacity) {
 #endif
 }
 
+JsonArena::JsonArena(const char *tag, size_t maxCapacity) : tag(tag), maxCapacity(maxCapacity), doc(initJsonDoc(tag)) {
+
+}
+
+void JsonArena::setMaxCapacity(size_t maxCapacity) {
+    this->maxCapacity = maxCapacity;
+    release();
+}
+
+size_t JsonArena::getMaxCapacity() const {
+    return maxCapacity;
+}
+
+JsonDoc& JsonArena::acquire(size_t capacity) {
+    if (doc.capacity() > maxCapacity) {
+        doc = initJsonDoc(tag); //left over from a large document which hasn't been released
+    }
+
+    //allocate the full arena at once, so that it doesn't grow step by step with the message sizes
+    size_t target = capacity > maxCapacity ? capacity : maxCapacity;
+    if (doc.capacity() < target) {
+        doc = initJsonDoc(tag, target);
+    } else {
+        doc.clear();
+    }
+    return doc;
+}
+
+void JsonArena::release() {
+    if (doc.capacity() > maxCapacity) {
+        doc = initJsonDoc(tag);
+    } else {
+        doc.clear();
+    }
+}
+
+size_t measureJsonCapacity(const char *json, size_t length) {
+
+    size_t slots = 0; //array elements and object members
+    size_t strSize = 0; //accumulated JSON_STRING_SIZE of all strings, including keys
+
+    bool inString = false;
+    bool escaped = false;
+    bool containerBegin = false; //last token was '[' or '{'. If the container isn't empty, it has one more element than commas
+    size_t strBegin = 0;
+
+    for (size_t i = 0; i < length && json[i] != '\0'; i++) {
+        char c = json[i];
+
+        if (inString) {
+            if (escaped) {
+                escaped = false;
+            } else if (c == '\\') {
+                escaped = true;
+            } else if (c == '\"') {
+                strSize += JSON_STRING_SIZE(i - strBegin);
+                inString = false;
+            }
+            continue;
+        }
+
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+            continue;
+        }
+
+        if (containerBegin) {
+            containerBegin = false;
+            if (c != ']' && c != '}') {
+                slots++;
+            }
+        }
+
+        switch (c) {
+            case '\"':
+                inString = true;
+                strBegin = i + 1;
+                break;
+            case '[':
+            case '{':
+                containerBegin = true;
+                break;
+            case ',':
+                slots++;
+                break;
+            default:
+                break;
+        }
+    }
+
+    return JSON_ARRAY_SIZE(slots) + strSize;
+}
+
 }
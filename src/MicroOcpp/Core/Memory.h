@@ -19,6 +19,26 @@
 #define MO_ENABLE_HEAP_PROFILER 0
 #endif
 
+//number of slots of the heap profiler for tracking the allocated blocks. Must be a power of 2. Up to 3/4 are used
+#ifndef MO_HEAP_PROFILER_MAXBLOCKS
+#define MO_HEAP_PROFILER_MAXBLOCKS 1024
+#endif
+
+//number of distinct memory tags which the heap profiler can tell apart. Must be a power of 2
+#ifndef MO_HEAP_PROFILER_MAXTAGS
+#define MO_HEAP_PROFILER_MAXTAGS 512
+#endif
+
+//track only every N-th allocation and extrapolate the sizes. 1 = track all allocations
+#ifndef MO_HEAP_PROFILER_SAMPLE_RATE
+#define MO_HEAP_PROFILER_SAMPLE_RATE 1
+#endif
+
+//max distance of a tagged object (see MemoryManaged) from the start of its block. Objects further inside are ignored
+#ifndef MO_HEAP_PROFILER_TAG_MAXOFFSET
+#define MO_HEAP_PROFILER_TAG_MAXOFFSET 64
+#endif
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -45,6 +65,7 @@ void mo_mem_free(void* ptr);
 
 void mo_mem_deinit(); //release allocated memory and deinit
 void mo_mem_reset(); //reset maximum heap occuption
+void mo_mem_set_sample_rate(unsigned int rate); //track only every rate-th allocation (see MO_HEAP_PROFILER_SAMPLE_RATE)
 
 void mo_mem_set_tag(void *ptr, const char *tag);
 
@@ -99,14 +120,41 @@ void mo_mem_free_ext(void* ptr);
 
 #if MO_OVERRIDE_ALLOCATION
 
+#include <stdint.h>
 #include <string.h>
 
 namespace MicroOcpp {
 
+namespace Memory {
+
+//malloc and free of the host system, see mo_mem_set_malloc_free()
+void *hostMalloc(size_t size);
+void hostFree(void *ptr);
+
+} //namespace Memory
+
+#if MO_ENABLE_HEAP_PROFILER
+namespace Memory {
+
+/*
+ * Registry of the memory tags. Each distinct tag string is stored once and identified by a small ID, so that
+ * objects and allocators only carry the ID. IDs and tag strings stay valid until the end of the program, also
+ * across mo_mem_deinit(). ID 0 = no tag
+ */
+using TagId = uint16_t;
+
+TagId internTag(const char *tag, const char *tag_suffix = nullptr); //returns 0 if both are nullptr or if the registry is full
+const char *getTag(TagId tagId); //nullptr for 0
+void *mallocTagged(TagId tagId, size_t size); //MO_MALLOC without the tag lookup
+void setTag(void *ptr, TagId tagId); //mo_mem_set_tag without the tag lookup
+
+} //namespace Memory
+#endif
+
 class MemoryManaged {
 private:
     #if MO_ENABLE_HEAP_PROFILER
-    char *tag = nullptr;
+    Memory::TagId tagId = 0;
     #endif
 protected:
     void updateMemoryTag(const char *src1, const char *src2 = nullptr) {
@@ -115,21 +163,13 @@ protected:
             //empty source does not update tag
             return;
         }
-        char src [64];
-        snprintf(src, sizeof(src), "%s%s", src1 ? src1 : "", src2 ? src2 : "");
-        if (tag) {
-            if (!strcmp(src, tag)) {
-                //nothing to do
-                return;
-            }
-            MO_FREE(tag);
-            tag = nullptr;
+        auto newTagId = Memory::internTag(src1, src2);
+        if (newTagId == tagId) {
+            //nothing to do
+            return;
         }
-        size_t size = strlen(src) + 1;
-        tag = static_cast<char*>(malloc(size)); //heap profiler bypasses custom malloc to not count into the statistics
-        memset(tag, 0, size);
-        snprintf(tag, size, "%s", src);
-        mo_mem_set_tag(this, tag);
+        tagId = newTagId;
+        Memory::setTag(this, tagId);
         #else
         (void)src1;
         (void)src2;
@@ -137,7 +177,7 @@ protected:
     }
     const char *getMemoryTag() const {
         #if MO_ENABLE_HEAP_PROFILER
-        return tag;
+        return Memory::getTag(tagId);
         #else
         return nullptr;
         #endif
@@ -156,23 +196,21 @@ public:
         #endif
     }
 
-    MemoryManaged(MemoryManaged&& other) {
-        #if MO_ENABLE_HEAP_PROFILER
-        tag = other.tag;
-        other.tag = nullptr;
-        #endif
-    }
-
-    ~MemoryManaged() {
+    MemoryManaged(const MemoryManaged& other) {
         #if MO_ENABLE_HEAP_PROFILER
-        MO_FREE(tag);
-        tag = nullptr;
+        if (other.tagId) {
+            tagId = other.tagId;
+            Memory::setTag(this, tagId);
+        }
         #endif
     }
 
     void operator=(const MemoryManaged& other) {
         #if MO_ENABLE_HEAP_PROFILER
-        updateMemoryTag(other.tag);
+        if (other.tagId && other.tagId != tagId) {
+            tagId = other.tagId;
+            Memory::setTag(this, tagId);
+        }
         #endif
     }
 };
@@ -182,44 +220,24 @@ struct Allocator {
 
     Allocator(const char *tag = nullptr, const char *tag_suffix = nullptr) {
         #if MO_ENABLE_HEAP_PROFILER
-        updateMemoryTag(tag, tag_suffix);
+        if (tag || tag_suffix) {
+            tagId = Memory::internTag(tag, tag_suffix);
+        }
         #endif
     }
 
     template<class U>
     Allocator(const Allocator<U>& other) {
         #if MO_ENABLE_HEAP_PROFILER
-        updateMemoryTag(other.tag);
+        tagId = other.tagId;
         #endif
     }
 
-    Allocator(const Allocator& other) {
-        #if MO_ENABLE_HEAP_PROFILER
-        updateMemoryTag(other.tag);
-        #endif
-    }
-
-    //template<class U>
-    //Allocator(Allocator<U>&& other) {
-    Allocator(Allocator&& other) {
-        #if MO_ENABLE_HEAP_PROFILER
-        updateMemoryTag(other.tag); //ignore move semantics for allocators as it simplifies moving std::vector<T, Allocator<T>>. This is okay because the Allocator's state is only the memory tag which is not exclusively owned
-        #endif
-    }
-
-    ~Allocator() {
-        #if MO_ENABLE_HEAP_PROFILER
-        if (tag) {
-            //MO_FREE(tag);
-            free(tag);
-            tag = nullptr;
-        }
-        #endif
-    }
+    Allocator(const Allocator& other) = default;
 
     T *allocate(size_t count) {
         #if MO_ENABLE_HEAP_PROFILER
-            return static_cast<T*>(MO_MALLOC(tag, sizeof(T) * count));
+            return static_cast<T*>(Memory::mallocTagged(tagId, sizeof(T) * count));
         #else
             return static_cast<T*>(MO_MALLOC(nullptr, sizeof(T) * count));
         #endif
@@ -231,13 +249,7 @@ struct Allocator {
 
     bool operator==(const Allocator<T>& other) {
         #if MO_ENABLE_HEAP_PROFILER
-        if (!tag && !other.tag) {
-            return true;
-        } else if (tag && other.tag) {
-            return !strcmp(tag, other.tag);
-        } else {
-            return false;
-        }
+        return tagId == other.tagId;
         #else
         return true;
         #endif
@@ -250,29 +262,7 @@ struct Allocator {
     typedef T value_type;
 
     #if MO_ENABLE_HEAP_PROFILER
-    char *tag = nullptr;
-
-    void updateMemoryTag(const char *src1, const char *src2 = nullptr) {
-        if (!src1 && !src2) {
-            //empty source does not update tag
-            return;
-        }
-        char src [64];
-        snprintf(src, sizeof(src), "%s%s", src1 ? src1 : "", src2 ? src2 : "");
-        if (tag) {
-            if (!strcmp(src, tag)) {
-                //nothing to do
-                return;
-            }
-            //MO_FREE(tag);
-            free(tag);
-            tag = nullptr;
-        }
-        size_t size = strlen(src) + 1;
-        tag = static_cast<char*>(malloc(size));
-        memset(tag, 0, size);
-        snprintf(tag, size, "%s", src);
-    }
+    Memory::TagId tagId = 0;
     #endif
 };
 
@@ -294,63 +284,23 @@ Vector<T> makeVector(const char *tag) {
 class ArduinoJsonAllocator {
 private:
     #if MO_ENABLE_HEAP_PROFILER
-    char *tag = nullptr;
-
-    void updateMemoryTag(const char *src1, const char *src2 = nullptr) {
-        if (!src1 && !src2) {
-            //empty source does not update tag
-            return;
-        }
-        char src [64];
-        snprintf(src, sizeof(src), "%s%s", src1 ? src1 : "", src2 ? src2 : "");
-        if (tag) {
-            if (!strcmp(src, tag)) {
-                //nothing to do
-                return;
-            }
-            MO_FREE(tag);
-            tag = nullptr;
-        }
-        size_t size = strlen(src) + 1;
-        //tag = static_cast<char*>(MO_MALLOC("HeapProfilerInternal", size));
-        tag = static_cast<char*>(malloc(size));
-        memset(tag, 0, size);
-        snprintf(tag, size, "%s", src);
-    }
+    Memory::TagId tagId = 0;
     #endif
 public:
 
     ArduinoJsonAllocator(const char *tag = nullptr, const char *tag_suffix = nullptr) {
         #if MO_ENABLE_HEAP_PROFILER
-        updateMemoryTag(tag, tag_suffix);
-        #endif
-    }
-
-    ArduinoJsonAllocator(const ArduinoJsonAllocator& other) {
-        #if MO_ENABLE_HEAP_PROFILER
-        updateMemoryTag(other.tag);
-        #endif
-    }
-
-    ArduinoJsonAllocator(ArduinoJsonAllocator&& other) {
-        #if MO_ENABLE_HEAP_PROFILER
-        tag = other.tag;
-        other.tag = nullptr;
-        #endif
-    }
-
-    ~ArduinoJsonAllocator() {
-        #if MO_ENABLE_HEAP_PROFILER
-        if (tag) {
-            MO_FREE(tag);
-            tag = nullptr;
+        if (tag || tag_suffix) {
+            tagId = Memory::internTag(tag, tag_suffix);
         }
         #endif
     }
 
+    ArduinoJsonAllocator(const ArduinoJsonAllocator& other) = default;
+
     void *allocate(size_t size) {
         #if MO_ENABLE_HEAP_PROFILER
-            return MO_MALLOC(tag, size);
+            return Memory::mallocTagged(tagId, size);
         #else
             return MO_MALLOC(nullptr, size);
         #endif
@@ -438,6 +388,40 @@ String makeString(const char *tag, const char *val = nullptr);
 JsonDoc initJsonDoc(const char *tag, size_t capacity = 0);
 std::unique_ptr<JsonDoc> makeJsonDoc(const char *tag, size_t capacity = 0);
 
+/*
+ * Determine a JsonDoc capacity which is sufficient to deserialize the input. This is done in one pass over the
+ * input without tokenizing it fully and without allocating memory. The result is an upper bound: it counts one
+ * slot per array element and object member and the raw length of all strings (escape sequences and string
+ * deduplication only save memory). If the input is not well-formed JSON, the result is undefined but finite
+ */
+size_t measureJsonCapacity(const char *json, size_t length);
+
+//default capacity which the RequestQueue keeps for its outgoing and incoming messages (see JsonArena). 0 = no reuse
+#ifndef MO_JSON_ARENA_SIZE
+#define MO_JSON_ARENA_SIZE 1024
+#endif
+
+/*
+ * JsonDoc which is reused for a sequence of short-lived documents, like the messages which the RequestQueue sends
+ * and receives. Instead of allocating a JsonDoc per document and freeing it afterwards, the arena allocates its
+ * memory once and clears it for the next document. The arena keeps at most maxCapacity; documents which need more
+ * memory allocate it temporarily until release(). maxCapacity = 0 disables the reuse
+ */
+class JsonArena {
+private:
+    const char *tag;
+    size_t maxCapacity;
+    JsonDoc doc;
+public:
+    JsonArena(const char *tag, size_t maxCapacity);
+
+    void setMaxCapacity(size_t maxCapacity);
+    size_t getMaxCapacity() const;
+
+    JsonDoc& acquire(size_t capacity = 0); //returns the cleared JsonDoc with at least `capacity`
+    void release(); //done with the current document. Frees the memory beyond maxCapacity
+};
+
 }
 
 #endif //__cplusplus
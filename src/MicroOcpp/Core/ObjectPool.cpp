@@ -0,0 +1,100 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#include <MicroOcpp/Core/ObjectPool.h>
+#include <MicroOcpp/Core/Memory.h>
+#include <MicroOcpp/Platform.h>
+
+#include <stdlib.h>
+
+#if MO_ENABLE_MULTI_INSTANCE
+#include <mutex>
+namespace MicroOcpp {
+namespace ObjectPoolLock {
+std::mutex& mutex() {
+    static std::mutex poolMutex; //the instances may create objects from different threads
+    return poolMutex;
+}
+} //end namespace ObjectPoolLock
+} //end namespace MicroOcpp
+#define MO_POOL_LOCK() std::lock_guard<std::mutex> poolLock(MicroOcpp::ObjectPoolLock::mutex())
+#else
+#define MO_POOL_LOCK() (void)0
+#endif
+
+using namespace MicroOcpp;
+
+namespace {
+ObjectPool *pools = nullptr;
+}
+
+ObjectPool::ObjectPool(const char *tag, size_t blockSize) : tag(tag), blockSize(blockSize < sizeof(FreeBlock) ? sizeof(FreeBlock) : blockSize) {
+    MO_POOL_LOCK();
+    nextPool = pools;
+    pools = this;
+}
+
+ObjectPool::~ObjectPool() {
+    shrink();
+
+    MO_POOL_LOCK();
+    for (ObjectPool **pool = &pools; *pool; pool = &(*pool)->nextPool) {
+        if (*pool == this) {
+            *pool = nextPool;
+            break;
+        }
+    }
+}
+
+void *ObjectPool::allocate(size_t size) {
+    if (size == blockSize) {
+        MO_POOL_LOCK();
+        if (freeList) {
+            FreeBlock *block = freeList;
+            freeList = block->next;
+            freeCount--;
+            return block;
+        }
+    }
+    return MO_MALLOC(tag, size);
+}
+
+void ObjectPool::release(void *ptr, size_t size) {
+    if (!ptr) {
+        return;
+    }
+    if (size == blockSize) {
+        MO_POOL_LOCK();
+        if (freeCount < MO_OBJECT_POOL_SIZE) {
+            FreeBlock *block = static_cast<FreeBlock*>(ptr);
+            block->next = freeList;
+            freeList = block;
+            freeCount++;
+            return;
+        }
+    }
+    MO_FREE(ptr);
+}
+
+void ObjectPool::shrink() {
+    FreeBlock *blocks;
+    {
+        MO_POOL_LOCK();
+        blocks = freeList;
+        freeList = nullptr;
+        freeCount = 0;
+    }
+    while (blocks) {
+        FreeBlock *next = blocks->next;
+        MO_FREE(blocks);
+        blocks = next;
+    }
+}
+
+void ObjectPool::shrinkAll() {
+    //no instance is running at this point, so no pool is being created or destroyed concurrently
+    for (ObjectPool *pool = pools; pool; pool = pool->nextPool) {
+        pool->shrink();
+    }
+}
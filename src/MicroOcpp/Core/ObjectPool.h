@@ -0,0 +1,88 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#ifndef MO_OBJECTPOOL_H
+#define MO_OBJECTPOOL_H
+
+//recycle the memory of objects which are created for every message, instead of returning it to the heap
+#ifndef MO_ENABLE_OBJECT_POOL
+#define MO_ENABLE_OBJECT_POOL 1
+#endif
+
+#include <stddef.h>
+
+//max number of free blocks which each pool keeps for reuse
+#ifndef MO_OBJECT_POOL_SIZE
+#define MO_OBJECT_POOL_SIZE 4
+#endif
+
+namespace MicroOcpp {
+
+/*
+ * Cache of free memory blocks of one object type. Classes which are allocated on the message hot path use it in
+ * their class-specific operator new and delete: deleted objects put their memory into the pool and new objects
+ * take it from there, so that in steady state, creating and deleting these objects doesn't touch the heap anymore.
+ *
+ * Objects of a different size than the pool's block size (e.g. derived classes) bypass the pool. Blocks come from
+ * MO_MALLOC, so that the heap profiler accounts them to the tag of the pool
+ */
+class ObjectPool {
+private:
+    const char *tag;
+    size_t blockSize;
+
+    struct FreeBlock {
+        FreeBlock *next;
+    };
+    FreeBlock *freeList = nullptr;
+    size_t freeCount = 0;
+
+    ObjectPool *nextPool = nullptr; //list of all pools
+public:
+    ObjectPool(const char *tag, size_t blockSize);
+    ~ObjectPool();
+
+    void *allocate(size_t size);
+    void release(void *ptr, size_t size);
+
+    void shrink(); //return all free blocks to the heap
+
+    static void shrinkAll(); //shrink all pools. Called by mocpp_deinitialize() after the last instance
+};
+
+} //end namespace MicroOcpp
+
+/*
+ * Define class-specific operator new and delete of CLASS which use a pool. Usage: declare
+ *
+ *     static void *operator new(size_t size);
+ *     static void operator delete(void *ptr, size_t size);
+ *
+ * in the class and put MO_OBJECT_POOL_DEFINE(CLASS) into the corresponding .cpp file
+ */
+#if MO_ENABLE_OBJECT_POOL
+#define MO_OBJECT_POOL_DEFINE(CLASS)                                                \
+    namespace {                                                                     \
+    MicroOcpp::ObjectPool& objectPool_##CLASS() {                                   \
+        static MicroOcpp::ObjectPool pool (#CLASS, sizeof(CLASS));                  \
+        return pool;                                                                \
+    }                                                                               \
+    }                                                                               \
+    void *CLASS::operator new(size_t size) {                                        \
+        return objectPool_##CLASS().allocate(size);                                 \
+    }                                                                               \
+    void CLASS::operator delete(void *ptr, size_t size) {                           \
+        objectPool_##CLASS().release(ptr, size);                                    \
+    }
+#else
+#define MO_OBJECT_POOL_DEFINE(CLASS)                                                \
+    void *CLASS::operator new(size_t size) {                                        \
+        return MO_MALLOC(#CLASS, size);                                             \
+    }                                                                               \
+    void CLASS::operator delete(void *ptr, size_t) {                                \
+        MO_FREE(ptr);                                                               \
+    }
+#endif //MO_ENABLE_OBJECT_POOL
+
+#endif
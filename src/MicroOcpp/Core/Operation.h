@@ -26,6 +26,28 @@ namespace MicroOcpp {
 
 std::unique_ptr<JsonDoc> createEmptyDocument();
 
+/*
+ * Identifies the state which an outgoing request reports to the server. A queued request is superseded by a newer
+ * request with the same key, e.g. the StatusNotification of a connector by a more recent StatusNotification of the
+ * same connector. Then the queues only keep the newer request
+ */
+struct CoalescingKey {
+    enum class Type : uint8_t {
+        None, //not coalescable
+        StatusNotification,
+        MeterValues
+    };
+    Type type = Type::None;
+    int id = 0; //e.g. connectorId or evseId
+    int subId = 0; //e.g. connectorId of v201 EVSE
+
+    CoalescingKey() = default;
+    CoalescingKey(Type type, int id, int subId = 0) : type(type), id(id), subId(subId) { }
+
+    bool isNone() const {return type == Type::None;}
+    bool operator==(const CoalescingKey& other) const {return type == other.type && id == other.id && subId == other.subId;}
+};
+
 class Operation {
 public:
     Operation();
@@ -66,6 +88,12 @@ public:
     virtual const char *getErrorCode() {return nullptr;} //nullptr means no error
     virtual const char *getErrorDescription() {return "";}
     virtual std::unique_ptr<JsonDoc> getErrorDetails() {return createEmptyDocument();}
+
+    /*
+     * Outgoing requests only: return a key if a queued request of this operation can be dropped when a newer
+     * request with the same key is queued (see CoalescingKey)
+     */
+    virtual CoalescingKey getCoalescingKey() {return CoalescingKey();}
 };
 
 } //end namespace MicroOcpp
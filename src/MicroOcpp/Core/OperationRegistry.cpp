@@ -7,35 +7,97 @@
 #include <MicroOcpp/Core/Request.h>
 #include <MicroOcpp/Core/OcppError.h>
 #include <MicroOcpp/Debug.h>
-#include <algorithm>
+#include <string.h>
 
 using namespace MicroOcpp;
 
-OperationRegistry::OperationRegistry() : registry(makeVector<OperationCreator>("OperationRegistry")) {
+#define MO_OPREG_INDEX_MINSIZE 16 //initial number of hash table slots. Must be a power of 2
 
+namespace {
+
+//FNV-1a
+uint32_t hashOperationType(const char *operationType) {
+    uint32_t hash = 2166136261U;
+    for (const char *c = operationType; *c; c++) {
+        hash ^= (uint8_t) *c;
+        hash *= 16777619U;
+    }
+    return hash;
 }
 
-OperationCreator *OperationRegistry::findCreator(const char *operationType) {
-    for (auto it = registry.begin(); it != registry.end(); ++it) {
-        if (!strcmp(it->operationType, operationType)) {
-            return &*it;
+} //end namespace
+
+OperationRegistry::OperationRegistry() : registry(makeVector<OperationCreator>("OperationRegistry")), index(makeVector<uint16_t>("OperationRegistry")) {
+
+}
+
+void OperationRegistry::rebuildIndex(size_t capacity) {
+    index.assign(capacity, 0);
+    for (size_t i = 0; i < registry.size(); i++) {
+        size_t slot = registry[i].hash & (capacity - 1);
+        while (index[slot]) {
+            slot = (slot + 1) & (capacity - 1);
+        }
+        index[slot] = (uint16_t) (i + 1);
+    }
+}
+
+OperationCreator *OperationRegistry::findCreator(const char *operationType, uint32_t hash) {
+    if (index.empty()) {
+        return nullptr;
+    }
+    size_t mask = index.size() - 1;
+    for (size_t slot = hash & mask; index[slot]; slot = (slot + 1) & mask) {
+        auto& entry = registry[index[slot] - 1];
+        if (entry.hash == hash && !strcmp(entry.operationType, operationType)) {
+            return &entry;
         }
     }
     return nullptr;
 }
 
+OperationCreator *OperationRegistry::findCreator(const char *operationType) {
+    return findCreator(operationType, hashOperationType(operationType));
+}
+
 void OperationRegistry::registerOperation(const char *operationType, std::function<Operation*()> creator) {
-    registry.erase(std::remove_if(registry.begin(), registry.end(),
-                [operationType] (const OperationCreator& el) {
-                    return !strcmp(operationType, el.operationType);
-                }),
-            registry.end());
-    
+
+    uint32_t hash = hashOperationType(operationType);
+
     OperationCreator entry;
     entry.operationType = operationType;
+    entry.hash = hash;
     entry.creator = creator;
 
-    registry.push_back(entry);
+    if (auto existing = findCreator(operationType, hash)) {
+        //replace the former registration, including its listeners
+        *existing = std::move(entry);
+        MO_DBG_DEBUG("registered operation %s", operationType);
+        return;
+    }
+
+    if (registry.size() >= UINT16_MAX) {
+        MO_DBG_ERR("too many operations");
+        return;
+    }
+
+    registry.push_back(std::move(entry));
+
+    //keep the load factor of the hash table at 50% or less
+    size_t capacity = index.empty() ? MO_OPREG_INDEX_MINSIZE : index.size();
+    while (capacity < 2 * registry.size()) {
+        capacity *= 2;
+    }
+    if (capacity != index.size()) {
+        rebuildIndex(capacity);
+    } else {
+        size_t mask = capacity - 1;
+        size_t slot = hash & mask;
+        while (index[slot]) {
+            slot = (slot + 1) & mask;
+        }
+        index[slot] = (uint16_t) registry.size();
+    }
 
     MO_DBG_DEBUG("registered operation %s", operationType);
 }
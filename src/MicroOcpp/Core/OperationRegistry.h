@@ -5,6 +5,7 @@
 #ifndef MO_OPERATIONREGISTRY_H
 #define MO_OPERATIONREGISTRY_H
 
+#include <stdint.h>
 #include <functional>
 #include <memory>
 #include <MicroOcpp/Core/Memory.h>
@@ -17,14 +18,22 @@ class Request;
 
 struct OperationCreator {
     const char *operationType {nullptr};
+    uint32_t hash {0}; //hash of operationType
     std::function<Operation*()> creator {nullptr};
     OnReceiveReqListener onRequest {nullptr};
     OnSendConfListener onResponse {nullptr};
 };
 
+/*
+ * Maps the operation names of incoming CALLs to their creators. The lookup is an open-addressing hash table over
+ * the registered operations, so that dispatching a CALL doesn't depend on the number of enabled operations
+ */
 class OperationRegistry {
 private:
-    Vector<OperationCreator> registry;
+    Vector<OperationCreator> registry; //in order of registration
+    Vector<uint16_t> index; //hash table with linear probing. Slot value = position in registry + 1, 0 = empty slot
+    void rebuildIndex(size_t capacity);
+    OperationCreator *findCreator(const char *operationType, uint32_t hash);
     OperationCreator *findCreator(const char *operationType);
 
 public:
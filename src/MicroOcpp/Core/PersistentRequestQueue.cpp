@@ -0,0 +1,534 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#include <MicroOcpp/Core/PersistentRequestQueue.h>
+
+#if MO_ENABLE_PERSISTENT_REQUEST_QUEUE
+
+#include <limits>
+#include <stdlib.h>
+#include <string.h>
+
+#include <MicroOcpp/Core/Connection.h>
+#include <MicroOcpp/Core/FilesystemUtils.h>
+#include <MicroOcpp/Core/Operation.h>
+#include <MicroOcpp/Core/Request.h>
+#include <MicroOcpp/Operations/CustomOperation.h>
+#include <MicroOcpp/Debug.h>
+
+using namespace MicroOcpp;
+
+namespace MicroOcpp {
+
+bool isPersistentOperationType(const char *operationType) {
+    return !strcmp(operationType, "StatusNotification") ||
+            !strcmp(operationType, "SecurityEventNotification") ||
+            !strcmp(operationType, "MeterValues");
+}
+
+} //end namespace MicroOcpp
+
+namespace {
+
+bool printSegmentFn(char *fn, size_t size, unsigned int seg) {
+    auto ret = snprintf(fn, size, MO_FILENAME_PREFIX MO_REQUEST_SEGMENT_FN_PREFIX "%u.jsn", seg);
+    if (ret < 0 || (size_t) ret >= size) {
+        MO_DBG_ERR("fn error: %i", ret);
+        return false;
+    }
+    return true;
+}
+
+//records with CoalescingKey begin with {"ckey":[type,id,subId], so that load() can restore the keys without deserializing the records
+#define MO_REQUEST_CKEY_PREFIX "{\"ckey\":["
+
+bool parseRecordKey(const char *line, CoalescingKey& key) {
+    if (strncmp(line, MO_REQUEST_CKEY_PREFIX, sizeof(MO_REQUEST_CKEY_PREFIX) - 1)) {
+        return false;
+    }
+    const char *p = line + sizeof(MO_REQUEST_CKEY_PREFIX) - 1;
+    long vals [3];
+    for (size_t i = 0; i < 3; i++) {
+        char *end = nullptr;
+        vals[i] = strtol(p, &end, 10);
+        if (end == p || *end != (i < 2 ? ',' : ']')) {
+            return false;
+        }
+        p = end + 1;
+    }
+    key = CoalescingKey((CoalescingKey::Type) vals[0], (int) vals[1], (int) vals[2]);
+    return !key.isNone();
+}
+
+} //end namespace
+
+PersistentRequestQueue::PersistentRequestQueue(Connection& connection, std::shared_ptr<FilesystemAdapter> filesystem)
+        : MemoryManaged("PersistentRequestQueue"), connection(connection), filesystem(filesystem), latestRecords(makeVector<LatestRecord>(getMemoryTag())) {
+
+}
+
+PersistentRequestQueue::~PersistentRequestQueue() = default;
+
+bool PersistentRequestQueue::load() {
+
+    bool found = false;
+    unsigned int segMin = std::numeric_limits<unsigned int>::max();
+    unsigned int segMax = 0;
+
+    filesystem->ftw_root([&found, &segMin, &segMax] (const char *fname) -> int {
+        if (strncmp(fname, MO_REQUEST_SEGMENT_FN_PREFIX, sizeof(MO_REQUEST_SEGMENT_FN_PREFIX) - 1)) {
+            return 0; //not a segment file, continue
+        }
+        const char *numBegin = fname + sizeof(MO_REQUEST_SEGMENT_FN_PREFIX) - 1;
+        char *numEnd = nullptr;
+        unsigned long seg = strtoul(numBegin, &numEnd, 10);
+        if (numEnd == numBegin || strcmp(numEnd, ".jsn") || seg >= std::numeric_limits<unsigned int>::max()) {
+            return 0; //not a segment file, continue
+        }
+        found = true;
+        segMin = std::min(segMin, (unsigned int) seg);
+        segMax = std::max(segMax, (unsigned int) seg);
+        return 0;
+    });
+
+    tailSealed = false;
+
+    if (!found) {
+        segBegin = segEnd = 0;
+        headRecord = tailRecords = 0;
+        return true;
+    }
+
+    segBegin = segMin;
+    segEnd = segMax + 1;
+
+    //count records in tail segment
+    tailRecords = 0;
+    char fn [MO_MAX_PATH_SIZE];
+    if (printSegmentFn(fn, sizeof(fn), segEnd - 1)) {
+        if (auto file = filesystem->open(fn, "r")) {
+            int c, last = '\n';
+            while ((c = file->read()) >= 0) {
+                if (c == '\n') {
+                    tailRecords++;
+                }
+                last = c;
+            }
+            if (last != '\n') {
+                //an append has been interrupted. Further records would be appended to the incomplete one
+                MO_DBG_WARN("incomplete record in %s. Continue in new segment", fn);
+                tailSealed = true;
+            }
+        }
+    }
+
+    //restore the position of the next record to send
+    headRecord = 0;
+    size_t msize = 0;
+    if (filesystem->stat(MO_FILENAME_PREFIX MO_REQUEST_HEAD_FN, &msize) == 0) {
+        auto doc = FilesystemUtils::loadJson(filesystem, MO_FILENAME_PREFIX MO_REQUEST_HEAD_FN, getMemoryTag());
+        if (doc && ((*doc)["seg"] | (segBegin + 1)) == segBegin) {
+            headRecord = (*doc)["rec"] | 0;
+        }
+    }
+
+    //restore the CoalescingKeys of the backlog
+    latestRecords.clear();
+    for (unsigned int seg = segBegin; seg != segEnd; seg++) {
+        if (!printSegmentFn(fn, sizeof(fn), seg)) {
+            continue;
+        }
+        auto file = filesystem->open(fn, "r");
+        if (!file) {
+            continue;
+        }
+        char prefix [64]; //enough for the ckey prefix
+        size_t prefixLen = 0;
+        size_t rec = 0;
+        int c;
+        while ((c = file->read()) >= 0) {
+            if (c == '\n') {
+                prefix[prefixLen] = '\0';
+                CoalescingKey key;
+                if (parseRecordKey(prefix, key)) {
+                    updateLatestRecord(key, seg, rec);
+                }
+                prefixLen = 0;
+                rec++;
+            } else if (prefixLen < sizeof(prefix) - 1) {
+                prefix[prefixLen++] = (char) c;
+            }
+        }
+    }
+
+    MO_DBG_DEBUG("loaded backlog: segments %u - %u, head %zu, tail %zu", segBegin, segEnd - 1, headRecord, tailRecords);
+    return true;
+}
+
+bool PersistentRequestQueue::hasBacklog() {
+    return segBegin != segEnd;
+}
+
+bool PersistentRequestQueue::isOffline() {
+    if (connection.isConnected()) {
+        wasConnected = true;
+        return false;
+    }
+    return wasConnected; //before the first connection, the WebSocket may still be connecting
+}
+
+void PersistentRequestQueue::loop() {
+
+    volatileQueue.loop();
+
+    //the RAM queue doesn't survive reboots. Secure it while offline
+    if (isOffline()) {
+        spillVolatile();
+    }
+}
+
+unsigned int PersistentRequestQueue::getFrontRequestOpNr() {
+
+    auto opNr = volatileQueue.getFrontRequestOpNr();
+    if (opNr != NoOperation) {
+        return opNr;
+    }
+
+    if (replayInFlight) {
+        return NoOperation; //replay one by one: wait until the front record is committed
+    }
+
+    while (!replayFront && hasBacklog()) {
+        if (segBegin + 1 == segEnd && headRecord >= tailRecords) {
+            break; //all records sent
+        }
+        if (headRecord >= MO_REQUEST_SEGMENT_MAXRECORDS) {
+            dropFrontSegment(); //segment completed
+            continue;
+        }
+        CoalescingKey key;
+        bool endOfSegment = false;
+        replayFront = loadRecord(segBegin, headRecord, key, endOfSegment);
+        if (!replayFront && endOfSegment && segBegin + 1 != segEnd) {
+            //segment has been sealed before it was full
+            dropFrontSegment();
+            continue;
+        }
+        if (!replayFront) {
+            MO_DBG_ERR("skip corrupt record %u-%zu", segBegin, headRecord);
+            commitRecord(segBegin, headRecord);
+        } else if (isSuperseded(key, segBegin, headRecord)) {
+            MO_DBG_DEBUG("skip superseded record %u-%zu", segBegin, headRecord);
+            replayFront.reset();
+            commitRecord(segBegin, headRecord);
+        }
+    }
+
+    if (!replayFront) {
+        return NoOperation;
+    }
+
+    return 1; //same priority as the default queue of the RequestQueue
+}
+
+std::unique_ptr<Request> PersistentRequestQueue::fetchFrontRequest() {
+
+    if (volatileQueue.getFrontRequestOpNr() != NoOperation) {
+        return volatileQueue.fetchFrontRequest();
+    }
+
+    if (getFrontRequestOpNr() == NoOperation) {
+        return nullptr;
+    }
+
+    replayInFlight = true;
+    return std::move(replayFront);
+}
+
+bool PersistentRequestQueue::allowsPipelining() {
+    return volatileQueue.getFrontRequestOpNr() != NoOperation;
+}
+
+bool PersistentRequestQueue::pushRequestBack(std::unique_ptr<Request> request) {
+
+    if (!hasBacklog() && !isOffline() && !volatileQueue.isFull()) {
+        //fast path: online or still connecting, and no backlog. Keep in RAM
+        return volatileQueue.pushRequestBack(std::move(request));
+    }
+
+    spillVolatile(); //the RAM queue is older than the new request and must come first in the backlog
+
+    if (!appendRecord(*request)) {
+        MO_DBG_ERR("could not store %s. Keep in RAM", request->getOperationType());
+        return volatileQueue.pushRequestBack(std::move(request));
+    }
+
+    return true;
+}
+
+size_t PersistentRequestQueue::getQueueDepth() {
+    size_t depth = volatileQueue.getQueueDepth();
+    size_t segCount = segEnd - segBegin;
+    if (segCount == 1) {
+        depth += tailRecords - headRecord;
+    } else if (segCount > 1) {
+        depth += (MO_REQUEST_SEGMENT_MAXRECORDS - headRecord) + (segCount - 2) * MO_REQUEST_SEGMENT_MAXRECORDS + tailRecords;
+    }
+    return depth;
+}
+
+size_t PersistentRequestQueue::getBacklogSegments() {
+    return segEnd - segBegin;
+}
+
+void PersistentRequestQueue::spillVolatile() {
+    if (hasBacklog() && volatileQueue.getFrontRequestOpNr() != NoOperation) {
+        return; //there is already a backlog which is newer than the RAM queue (only if storing failed before)
+    }
+    while (volatileQueue.getFrontRequestOpNr() != NoOperation) {
+        auto request = volatileQueue.fetchFrontRequest();
+        if (!appendRecord(*request)) {
+            MO_DBG_ERR("could not store %s", request->getOperationType());
+            volatileQueue.pushRequestFront(std::move(request));
+            break;
+        }
+    }
+}
+
+/*
+ * Record format: one JSON object per line
+ *
+ *     {"type":"SecurityEventNotification","payload":{"type":"StartupOfTheDevice", ... }}\n
+ *
+ * Records of requests with CoalescingKey lead with the key:
+ *
+ *     {"ckey":[1,1,0],"type":"StatusNotification","payload":{"connectorId":1, ... }}\n
+ */
+bool PersistentRequestQueue::appendRecord(Request& request) {
+
+    auto payload = request.getOperation()->createReq();
+    if (!payload) {
+        MO_DBG_ERR("cannot create payload");
+        return false;
+    }
+
+    bool newSegment = false;
+    size_t prevTailRecords = tailRecords;
+    bool prevTailSealed = tailSealed;
+    if (!hasBacklog() || tailRecords >= MO_REQUEST_SEGMENT_MAXRECORDS || tailSealed) {
+        if (segEnd - segBegin >= MO_REQUEST_SEGMENT_MAXCOUNT) {
+            MO_DBG_WARN("backlog full. Drop oldest segment");
+            dropFrontSegment();
+        }
+        if (!hasBacklog()) {
+            headRecord = 0;
+        }
+        segEnd++;
+        tailRecords = 0;
+        tailSealed = false;
+        newSegment = true;
+    }
+
+    char fn [MO_MAX_PATH_SIZE];
+    if (!printSegmentFn(fn, sizeof(fn), segEnd - 1)) {
+        return false;
+    }
+
+    auto key = request.getOperation()->getCoalescingKey();
+
+    auto record = makeString(getMemoryTag(), "{");
+    if (!key.isNone()) {
+        char ckey [48];
+        snprintf(ckey, sizeof(ckey), "\"ckey\":[%i,%i,%i],", (int) key.type, key.id, key.subId);
+        record += ckey;
+    }
+    record += "\"type\":\"";
+    record += request.getOperationType();
+    record += "\",\"payload\":";
+    serializeJson(*payload, record);
+    record += "}\n";
+
+    bool success = false;
+    if (auto file = filesystem->open(fn, "a")) {
+        success = file->write(record.c_str(), record.length()) == record.length();
+    }
+
+    if (!success) {
+        MO_DBG_ERR("cannot write %s", fn);
+        if (newSegment) {
+            filesystem->remove(fn);
+            segEnd--;
+            tailRecords = prevTailRecords;
+            tailSealed = prevTailSealed;
+            if (!hasBacklog()) {
+                segBegin = segEnd = 0;
+            }
+        }
+        return false;
+    }
+
+    if (!key.isNone()) {
+        updateLatestRecord(key, segEnd - 1, tailRecords);
+    }
+
+    tailRecords++;
+    return true;
+}
+
+void PersistentRequestQueue::updateLatestRecord(const CoalescingKey& key, unsigned int seg, size_t rec) {
+    for (auto& latest : latestRecords) {
+        if (latest.key == key) {
+            latest.seg = seg;
+            latest.rec = rec;
+            return;
+        }
+    }
+    latestRecords.push_back(LatestRecord{key, seg, rec});
+}
+
+bool PersistentRequestQueue::isSuperseded(const CoalescingKey& key, unsigned int seg, size_t rec) {
+    if (key.isNone()) {
+        return false;
+    }
+    for (auto& latest : latestRecords) {
+        if (latest.key == key) {
+            return latest.seg > seg || (latest.seg == seg && latest.rec > rec);
+        }
+    }
+    return false;
+}
+
+std::unique_ptr<Request> PersistentRequestQueue::loadRecord(unsigned int seg, size_t rec, CoalescingKey& key, bool& endOfSegment) {
+
+    char fn [MO_MAX_PATH_SIZE];
+    if (!printSegmentFn(fn, sizeof(fn), seg)) {
+        return nullptr;
+    }
+
+    auto file = filesystem->open(fn, "r");
+    if (!file) {
+        MO_DBG_ERR("cannot open %s", fn);
+        return nullptr;
+    }
+
+    //skip to record
+    int c = 0;
+    for (size_t i = 0; i < rec && c >= 0; ) {
+        c = file->read();
+        if (c == '\n') {
+            i++;
+        }
+    }
+
+    if (c < 0) {
+        endOfSegment = true;
+        return nullptr;
+    }
+
+    auto line = makeString(getMemoryTag());
+    while ((c = file->read()) >= 0 && c != '\n') {
+        if (line.length() >= MO_MAX_JSON_CAPACITY) {
+            MO_DBG_ERR("record exceeds MO_MAX_JSON_CAPACITY");
+            return nullptr;
+        }
+        line.push_back((char) c);
+    }
+
+    if (c != '\n') {
+        MO_DBG_ERR("incomplete record");
+        endOfSegment = true; //an incomplete record can only be at the end
+        return nullptr;
+    }
+
+    std::shared_ptr<JsonDoc> doc = makeJsonDoc(getMemoryTag(), measureJsonCapacity(line.c_str(), line.length()));
+    auto err = deserializeJson(*doc, line.c_str(), line.length());
+    if (err || !(*doc)["type"].is<const char*>() || !(*doc)["payload"].is<JsonObject>()) {
+        MO_DBG_ERR("record deserialization error: %s", err.c_str());
+        return nullptr;
+    }
+
+    parseRecordKey(line.c_str(), key);
+
+    auto memoryTag = getMemoryTag();
+    auto request = makeRequest(new Ocpp16::CustomOperation((*doc)["type"],
+        [doc, memoryTag] () {
+            auto payload = makeJsonDoc(memoryTag, doc->memoryUsage());
+            *payload = (*doc)["payload"];
+            return payload;
+        },
+        [] (JsonObject) { }));
+
+    request->setOnReceiveConfListener([this, seg, rec] (JsonObject) {
+        commitRecord(seg, rec);
+    });
+    request->setOnReceiveErrorListener([this, seg, rec] (const char*, const char*, JsonObject) {
+        commitRecord(seg, rec); //rejected by the server. Don't try again
+    });
+    request->setOnTimeoutListener([this, seg, rec] () {
+        if (seg == segBegin && rec == headRecord) {
+            replayInFlight = false; //send again
+        }
+    });
+
+    return request;
+}
+
+void PersistentRequestQueue::commitRecord(unsigned int seg, size_t rec) {
+    if (seg != segBegin || rec != headRecord) {
+        return; //record has been dropped in the meantime
+    }
+
+    replayInFlight = false;
+    headRecord++;
+
+    if (headRecord >= MO_REQUEST_SEGMENT_MAXRECORDS || (segBegin + 1 == segEnd && headRecord >= tailRecords)) {
+        //segment completed (the tail segment is completed when all its records have been sent)
+        dropFrontSegment();
+    } else {
+        storeHead();
+    }
+}
+
+void PersistentRequestQueue::storeHead() {
+    auto doc = initJsonDoc(getMemoryTag(), JSON_OBJECT_SIZE(2));
+    doc["seg"] = segBegin;
+    doc["rec"] = headRecord;
+    if (!FilesystemUtils::storeJson(filesystem, MO_FILENAME_PREFIX MO_REQUEST_HEAD_FN, doc)) {
+        MO_DBG_ERR("cannot store head");
+    }
+}
+
+void PersistentRequestQueue::dropFrontSegment() {
+    if (!hasBacklog()) {
+        return;
+    }
+
+    char fn [MO_MAX_PATH_SIZE];
+    if (printSegmentFn(fn, sizeof(fn), segBegin)) {
+        filesystem->remove(fn);
+    }
+
+    segBegin++;
+    headRecord = 0;
+    replayFront.reset();
+    replayInFlight = false;
+
+    if (!hasBacklog()) {
+        segBegin = segEnd = 0; //restart numbering
+        tailRecords = 0;
+        latestRecords.clear();
+        filesystem->remove(MO_FILENAME_PREFIX MO_REQUEST_HEAD_FN);
+    } else {
+        for (auto latest = latestRecords.begin(); latest != latestRecords.end(); ) {
+            if (latest->seg < segBegin) {
+                latest = latestRecords.erase(latest);
+            } else {
+                latest++;
+            }
+        }
+        storeHead();
+    }
+}
+
+#endif //MO_ENABLE_PERSISTENT_REQUEST_QUEUE
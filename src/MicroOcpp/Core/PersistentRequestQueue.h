@@ -0,0 +1,112 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#ifndef MO_PERSISTENTREQUESTQUEUE_H
+#define MO_PERSISTENTREQUESTQUEUE_H
+
+#include <MicroOcpp/Core/RequestQueue.h>
+#include <MicroOcpp/Core/FilesystemAdapter.h>
+#include <MicroOcpp/Core/Memory.h>
+
+#include <memory>
+
+#ifndef MO_ENABLE_PERSISTENT_REQUEST_QUEUE
+#define MO_ENABLE_PERSISTENT_REQUEST_QUEUE 0
+#endif
+
+#if MO_ENABLE_PERSISTENT_REQUEST_QUEUE
+
+//number of requests per segment file
+#ifndef MO_REQUEST_SEGMENT_MAXRECORDS
+#define MO_REQUEST_SEGMENT_MAXRECORDS 10
+#endif
+
+//max number of segment files. If exceeded, the oldest segment is dropped
+#ifndef MO_REQUEST_SEGMENT_MAXCOUNT
+#define MO_REQUEST_SEGMENT_MAXCOUNT 20
+#endif
+
+#define MO_REQUEST_SEGMENT_FN_PREFIX "reqq-"
+#define MO_REQUEST_HEAD_FN "reqq.jsn"
+
+namespace MicroOcpp {
+
+class Connection;
+
+/*
+ * Outgoing queue for messages which must not get lost during offline periods, like StatusNotifications,
+ * SecurityEventNotifications and triggered MeterValues.
+ *
+ * While online, requests are kept in RAM like in the VolatileRequestQueue. When the connection is lost after it has
+ * been established, or when the RAM queue is full, the requests are serialized and appended to segment files on
+ * the flash. Until the first connection after boot, the requests stay in RAM. The
+ * backlog survives reboots and is replayed in order after the BootNotification has been accepted (the
+ * PreBootQueue blocks all other queues before). The RAM usage is bounded by the RAM queue and one replayed
+ * request, regardless of the size of the backlog.
+ *
+ * Requests which are moved to the flash lose their callbacks. After the replay, their responses are discarded.
+ *
+ * Records on the flash are coalesced like in the VolatileRequestQueue: a record which is superseded by a newer record
+ * with the same CoalescingKey is skipped during the replay.
+ */
+class PersistentRequestQueue : public RequestEmitter, public MemoryManaged {
+private:
+    Connection& connection;
+    std::shared_ptr<FilesystemAdapter> filesystem;
+
+    VolatileRequestQueue volatileQueue; //requests which are queued while online and before any backlog. Always older than the backlog
+
+    //backlog on flash: segment files [segBegin, segEnd)
+    unsigned int segBegin = 0;
+    unsigned int segEnd = 0;
+    size_t headRecord = 0; //index of the next record to send in segment segBegin
+    size_t tailRecords = 0; //number of records in segment segEnd - 1
+    bool tailSealed = false; //segment segEnd - 1 ends with an incomplete record. Append to a new segment
+
+    bool wasConnected = false; //the connection has been established since boot
+    bool isOffline(); //connection lost after it has been established
+
+    std::unique_ptr<Request> replayFront; //front record of the backlog, loaded from flash
+    bool replayInFlight = false; //front record has been fetched and awaits its response
+
+    struct LatestRecord {
+        CoalescingKey key;
+        unsigned int seg;
+        size_t rec;
+    };
+    Vector<LatestRecord> latestRecords; //position of the newest record per CoalescingKey in the backlog
+    void updateLatestRecord(const CoalescingKey& key, unsigned int seg, size_t rec);
+    bool isSuperseded(const CoalescingKey& key, unsigned int seg, size_t rec);
+
+    bool hasBacklog();
+    bool appendRecord(Request& request);
+    void spillVolatile();
+    std::unique_ptr<Request> loadRecord(unsigned int seg, size_t rec, CoalescingKey& key, bool& endOfSegment);
+    void commitRecord(unsigned int seg, size_t rec);
+    void storeHead();
+    void dropFrontSegment();
+public:
+    PersistentRequestQueue(Connection& connection, std::shared_ptr<FilesystemAdapter> filesystem);
+    ~PersistentRequestQueue();
+
+    bool load(); //recover backlog from flash
+
+    void loop();
+
+    unsigned int getFrontRequestOpNr() override;
+    std::unique_ptr<Request> fetchFrontRequest() override;
+    bool allowsPipelining() override; //pipeline the RAM queue; the backlog is replayed one by one
+    size_t getQueueDepth() override; //RAM queue and records on flash
+
+    bool pushRequestBack(std::unique_ptr<Request> request);
+
+    size_t getBacklogSegments(); //number of segment files on flash
+};
+
+bool isPersistentOperationType(const char *operationType); //if requests of this type should be queued in the PersistentRequestQueue
+
+} //end namespace MicroOcpp
+
+#endif //MO_ENABLE_PERSISTENT_REQUEST_QUEUE
+#endif
@@ -14,8 +14,10 @@
 #include <MicroOcpp/Platform.h>
 #include <MicroOcpp/Debug.h>
 
+#include <string.h>
+
 namespace MicroOcpp {
-    unsigned int g_randSeed = 1394827383;
+    MO_THREAD_LOCAL unsigned int g_randSeed = 1394827383; //per thread, the instances may loop on different threads
 
     void writeRandomNonsecure(unsigned char *buf, size_t len) {
         g_randSeed += mocpp_tick_ms();
@@ -30,13 +32,34 @@ namespace MicroOcpp {
 
 using namespace MicroOcpp;
 
-Request::Request(std::unique_ptr<Operation> msg) : MemoryManaged("Request.", msg->getOperationType()), messageID(makeString(getMemoryTag())), operation(std::move(msg)) {
+static_assert(MO_REQUEST_MSGID_MAXLEN >= 36, "MO_REQUEST_MSGID_MAXLEN must fit a UUID");
+
+MO_OBJECT_POOL_DEFINE(Request)
+MO_OBJECT_POOL_DEFINE(RequestListeners)
+
+Request::Request(std::unique_ptr<Operation> msg) : MemoryManaged("Request.", msg->getOperationType()), operation(std::move(msg)) {
     timeout_start = mocpp_tick_ms();
     debugRequest_start = mocpp_tick_ms();
 }
 
 Request::~Request(){
+    MO_FREE(messageIDLong);
+}
 
+//prepare the output JsonDoc for the message. Keep its memory if it is large enough (see JsonArena)
+void Request::reuseJsonDoc(JsonDoc& out, size_t capacity) {
+    if (out.capacity() >= capacity) {
+        out.clear();
+    } else {
+        out = initJsonDoc(getMemoryTag(), capacity);
+    }
+}
+
+RequestListeners& Request::getListeners() {
+    if (!listeners) {
+        listeners.reset(new RequestListeners());
+    }
+    return *listeners;
 }
 
 Operation *Request::getOperation(){
@@ -45,6 +68,20 @@ Operation *Request::getOperation(){
 
 void Request::setTimeout(unsigned long timeout) {
     this->timeout_period = timeout;
+    this->timeout_adaptive = false;
+}
+
+void Request::setTimeoutAdaptive(unsigned long maxTimeout) {
+    this->timeout_adaptive = true;
+    this->timeout_adaptive_max = maxTimeout;
+}
+
+bool Request::isTimeoutAdaptive() {
+    return timeout_adaptive;
+}
+
+unsigned long Request::getTimeoutAdaptiveMax() {
+    return timeout_adaptive_max;
 }
 
 bool Request::isTimeoutExceeded() {
@@ -52,26 +89,42 @@ bool Request::isTimeoutExceeded() {
 }
 
 void Request::executeTimeout() {
-    if (!timed_out) {
-        onTimeoutListener();
-        onAbortListener();
+    if (!timed_out && listeners) {
+        if (listeners->onTimeout) {
+            listeners->onTimeout();
+        }
+        if (listeners->onAbort) {
+            listeners->onAbort();
+        }
     }
     timed_out = true;
 }
 
-void Request::setMessageID(const char *id){
-    if (!messageID.empty()){
+bool Request::setMessageID(const char *id){
+    if (*messageID){
         MO_DBG_ERR("messageID already defined");
     }
-    messageID = id;
+    size_t len = strlen(id);
+    if (len > MO_REQUEST_MSGID_MAXLEN) {
+        //longer than OCPP-J allows. Accept it anyway, but store it on the heap
+        MO_DBG_WARN("messageID exceeds %u characters", (unsigned int) MO_REQUEST_MSGID_MAXLEN);
+        MO_FREE(messageIDLong);
+        messageIDLong = static_cast<char*>(MO_MALLOC(getMemoryTag(), len + 1));
+        if (!messageIDLong) {
+            MO_DBG_ERR("OOM");
+            return false;
+        }
+        memcpy(messageIDLong, id, len + 1);
+        return true;
+    }
+    memcpy(messageID, id, len + 1);
+    return true;
 }
 
 Request::CreateRequestResult Request::createRequest(JsonDoc& requestJson) {
 
-    if (messageID.empty()) {
-        char uuid [37] = {'\0'};
-        generateUUID(uuid, 37);
-        messageID = uuid;
+    if (!*messageID) {
+        generateUUID(messageID, sizeof(messageID));
     }
 
     /*
@@ -85,11 +138,11 @@ Request::CreateRequestResult Request::createRequest(JsonDoc& requestJson) {
     /*
      * Create OCPP-J Remote Procedure Call header
      */
-    size_t json_buffsize = JSON_ARRAY_SIZE(4) + (messageID.length() + 1) + requestPayload->capacity();
-    requestJson = initJsonDoc(getMemoryTag(), json_buffsize);
+    size_t json_buffsize = JSON_ARRAY_SIZE(4) + (strlen(messageID) + 1) + requestPayload->capacity();
+    reuseJsonDoc(requestJson, json_buffsize);
 
     requestJson.add(MESSAGE_TYPE_CALL);                    //MessageType
-    requestJson.add(messageID);                      //Unique message ID
+    requestJson.add((char*) messageID);              //Unique message ID (copied into requestJson)
     requestJson.add(operation->getOperationType());  //Action
     requestJson.add(*requestPayload);                      //Payload
 
@@ -118,7 +171,7 @@ bool Request::receiveResponse(JsonArray response){
     /*
      * check if messageIDs match. If yes, continue with this function. If not, return false for message not consumed
      */
-    if (messageID.compare(response[1].as<const char*>())){
+    if (strcmp(messageID, response[1] | "")){
         return false;
     }
 
@@ -135,7 +188,9 @@ bool Request::receiveResponse(JsonArray response){
         /*
         * Hand the payload over to the onReceiveConf Callback
         */
-        onReceiveConfListener(payload);
+        if (listeners && listeners->onReceiveConf) {
+            listeners->onReceiveConf(payload);
+        }
 
         /*
         * return true as this message has been consumed
@@ -151,9 +206,13 @@ bool Request::receiveResponse(JsonArray response){
         JsonObject errorDetails = response[4];
         bool abortOperation = operation->processErr(errorCode, errorDescription, errorDetails);
 
-        if (abortOperation) {
-            onReceiveErrorListener(errorCode, errorDescription, errorDetails);
-            onAbortListener();
+        if (abortOperation && listeners) {
+            if (listeners->onReceiveError) {
+                listeners->onReceiveError(errorCode, errorDescription, errorDetails);
+            }
+            if (listeners->onAbort) {
+                listeners->onAbort();
+            }
         }
 
         return abortOperation;
@@ -171,7 +230,9 @@ bool Request::receiveRequest(JsonArray request) {
         return false;
     }
   
-    setMessageID(request[1].as<const char*>());
+    if (!setMessageID(request[1].as<const char*>())) {
+        return false;
+    }
     
     /*
      * Hand the payload over to the Request object
@@ -182,7 +243,9 @@ bool Request::receiveRequest(JsonArray request) {
     /*
      * Hand the payload over to the first Callback. It is a callback that notifies the client that request has been processed in the OCPP-library
      */
-    onReceiveReqListener(payload);
+    if (listeners && listeners->onReceiveReq) {
+        listeners->onReceiveReq(payload);
+    }
 
     return true; //success
 }
@@ -203,14 +266,14 @@ Request::CreateResponseResult Request::createResponse(JsonDoc& response) {
          * Create OCPP-J Remote Procedure Call header
          */
         size_t json_buffsize = JSON_ARRAY_SIZE(3) + payload->capacity();
-        response = initJsonDoc(getMemoryTag(), json_buffsize);
+        reuseJsonDoc(response, json_buffsize);
 
         response.add(MESSAGE_TYPE_CALLRESULT);   //MessageType
-        response.add(messageID.c_str());            //Unique message ID
+        response.add(getMessageID());      //Unique message ID
         response.add(*payload);              //Payload
 
-        if (onSendConfListener) {
-            onSendConfListener(payload->as<JsonObject>());
+        if (listeners && listeners->onSendConf) {
+            listeners->onSendConf(payload->as<JsonObject>());
         }
     } else {
         //operation failure. Send error message instead
@@ -224,10 +287,10 @@ Request::CreateResponseResult Request::createResponse(JsonDoc& response) {
          */
         size_t json_buffsize = JSON_ARRAY_SIZE(5)
                     + errorDetails->capacity();
-        response = initJsonDoc(getMemoryTag(), json_buffsize);
+        reuseJsonDoc(response, json_buffsize);
 
         response.add(MESSAGE_TYPE_CALLERROR);   //MessageType
-        response.add(messageID.c_str());            //Unique message ID
+        response.add(getMessageID());      //Unique message ID
         response.add(errorCode);
         response.add(errorDescription);
         response.add(*errorDetails);              //Error description
@@ -238,7 +301,7 @@ Request::CreateResponseResult Request::createResponse(JsonDoc& response) {
 
 void Request::setOnReceiveConfListener(OnReceiveConfListener onReceiveConf){
     if (onReceiveConf)
-        onReceiveConfListener = onReceiveConf;
+        getListeners().onReceiveConf = onReceiveConf;
 }
 
 /**
@@ -246,33 +309,37 @@ void Request::setOnReceiveConfListener(OnReceiveConfListener onReceiveConf){
  */
 void Request::setOnReceiveReqListener(OnReceiveReqListener onReceiveReq){
     if (onReceiveReq)
-        onReceiveReqListener = onReceiveReq;
+        getListeners().onReceiveReq = onReceiveReq;
 }
 
 void Request::setOnSendConfListener(OnSendConfListener onSendConf){
     if (onSendConf)
-        onSendConfListener = onSendConf;
+        getListeners().onSendConf = onSendConf;
 }
 
 void Request::setOnTimeoutListener(OnTimeoutListener onTimeout) {
     if (onTimeout)
-        onTimeoutListener = onTimeout;
+        getListeners().onTimeout = onTimeout;
 }
 
 void Request::setOnReceiveErrorListener(OnReceiveErrorListener onReceiveError) {
     if (onReceiveError)
-        onReceiveErrorListener = onReceiveError;
+        getListeners().onReceiveError = onReceiveError;
 }
 
 void Request::setOnAbortListener(OnAbortListener onAbort) {
     if (onAbort)
-        onAbortListener = onAbort;
+        getListeners().onAbort = onAbort;
 }
 
 const char *Request::getOperationType() {
     return operation ? operation->getOperationType() : "UNDEFINED";
 }
 
+const char *Request::getMessageID() {
+    return messageIDLong ? messageIDLong : messageID;
+}
+
 void Request::setRequestSent() {
     requestSent = true;
 }
@@ -14,27 +14,46 @@
 #include <MicroOcpp/Core/RequestCallbacks.h>
 
 #include <MicroOcpp/Core/Memory.h>
+#include <MicroOcpp/Core/ObjectPool.h>
+
+//max length of message IDs. OCPP-J limits them to 36 characters
+#ifndef MO_REQUEST_MSGID_MAXLEN
+#define MO_REQUEST_MSGID_MAXLEN 36
+#endif
 
 namespace MicroOcpp {
 
 class Operation;
 class Model;
 
+//listeners of a Request. Only allocated if at least one of them is set
+struct RequestListeners {
+    OnReceiveConfListener onReceiveConf;
+    OnReceiveReqListener onReceiveReq;
+    OnSendConfListener onSendConf;
+    OnTimeoutListener onTimeout;
+    OnReceiveErrorListener onReceiveError;
+    OnAbortListener onAbort;
+
+    static void *operator new(size_t size);
+    static void operator delete(void *ptr, size_t size);
+};
+
 class Request : public MemoryManaged {
 private:
-    String messageID;
+    char messageID [MO_REQUEST_MSGID_MAXLEN + 1] = {'\0'};
+    char *messageIDLong = nullptr; //incoming message IDs which exceed MO_REQUEST_MSGID_MAXLEN
     std::unique_ptr<Operation> operation;
-    void setMessageID(const char *id);
-    OnReceiveConfListener onReceiveConfListener = [] (JsonObject payload) {};
-    OnReceiveReqListener onReceiveReqListener = [] (JsonObject payload) {};
-    OnSendConfListener onSendConfListener = [] (JsonObject payload) {};
-    OnTimeoutListener onTimeoutListener = [] () {};
-    OnReceiveErrorListener onReceiveErrorListener = [] (const char *code, const char *description, JsonObject details) {};
-    OnAbortListener onAbortListener = [] () {};
+    bool setMessageID(const char *id);
+    std::unique_ptr<RequestListeners> listeners;
+    RequestListeners& getListeners();
+    void reuseJsonDoc(JsonDoc& out, size_t capacity);
 
     unsigned long timeout_start = 0;
     unsigned long timeout_period = 40000;
     bool timed_out = false;
+    bool timeout_adaptive = true;
+    unsigned long timeout_adaptive_max = 0;
     
     unsigned long debugRequest_start = 0;
 
@@ -45,9 +64,24 @@ public:
 
     ~Request();
 
+    //Requests are created for every message. Their memory is recycled by an ObjectPool
+    static void *operator new(size_t size);
+    static void operator delete(void *ptr, size_t size);
+
     Operation *getOperation();
 
-    void setTimeout(unsigned long timeout); //0 = disable timeout
+    void setTimeout(unsigned long timeout); //0 = disable timeout. Fixed timeout since creation, disables adaptive timeout
+
+    /*
+     * Adaptive timeout (default): after sending, the RequestQueue waits for the response according to the measured
+     * round-trip times of this operation type (see RttEstimator). Before sending, the timeout since creation applies.
+     * Calling setTimeout() disables the adaptive timeout, call this function afterwards to enable it again.
+     * maxTimeout: upper bound of the response wait time in ms. 0 = RttEstimator limit only
+     */
+    void setTimeoutAdaptive(unsigned long maxTimeout = 0);
+    bool isTimeoutAdaptive();
+    unsigned long getTimeoutAdaptiveMax();
+
     bool isTimeoutExceeded();
     void executeTimeout(); //call Timeout Listener
     void setOnTimeoutListener(OnTimeoutListener onTimeout);
@@ -114,6 +148,8 @@ public:
 
     const char *getOperationType();
 
+    const char *getMessageID(); //empty before createRequest() or receiveRequest()
+
     void setRequestSent();
     bool isRequestSent();
 };
@@ -9,7 +9,8 @@
 #include <MicroOcpp/Core/Connection.h>
 #include <MicroOcpp/Core/OcppError.h>
 #include <MicroOcpp/Core/OperationRegistry.h>
-#include <MicroOcpp/Operations/StatusNotification.h>
+#include <MicroOcpp/Core/PersistentRequestQueue.h>
+#include <MicroOcpp/Platform.h>
 
 #include <MicroOcpp/Debug.h>
 
@@ -17,7 +18,7 @@ size_t removePayload(const char *src, size_t src_size, char *dst, size_t dst_siz
 
 using namespace MicroOcpp;
 
-VolatileRequestQueue::VolatileRequestQueue() : MemoryManaged("VolatileRequestQueue") {
+VolatileRequestQueue::VolatileRequestQueue(bool coalesce) : MemoryManaged("VolatileRequestQueue"), coalesce(coalesce) {
 
 }
 
@@ -28,30 +29,41 @@ void VolatileRequestQueue::loop() {
     /*
      * Drop timed out operations
      */
-    size_t i = 0;
-    while (i < len) {
-        size_t index = (front + i) % MO_REQUEST_CACHE_MAXSIZE;
-        auto& request = requests[index];
+    for (size_t i = 0; i < len; i++) {
+        auto& request = requests[(front + i) % MO_REQUEST_CACHE_MAXSIZE];
 
-        if (request->isTimeoutExceeded()) {
+        if (request && request->isTimeoutExceeded()) {
             MO_DBG_INFO("operation timeout: %s", request->getOperationType());
             request->executeTimeout();
+            request.reset();
+        }
+    }
 
-            if (index == front) {
-                requests[front].reset();
-                front = (front + 1) % MO_REQUEST_CACHE_MAXSIZE;
-                len--;
-            } else {
-                requests[index].reset();
-                for (size_t i = (index + MO_REQUEST_CACHE_MAXSIZE - front) % MO_REQUEST_CACHE_MAXSIZE; i < len - 1; i++) {
-                    requests[(front + i) % MO_REQUEST_CACHE_MAXSIZE] = std::move(requests[(front + i + 1) % MO_REQUEST_CACHE_MAXSIZE]);
-                }
-                len--;
-            }
-        } else {
-            i++;
+    trimFront();
+}
+
+void VolatileRequestQueue::trimFront() {
+    while (len > 0 && !requests[front]) {
+        front = (front + 1) % MO_REQUEST_CACHE_MAXSIZE;
+        len--;
+    }
+}
+
+void VolatileRequestQueue::compact() {
+    size_t compactLen = 0;
+    for (size_t i = 0; i < len; i++) {
+        size_t index = (front + i) % MO_REQUEST_CACHE_MAXSIZE;
+        if (!requests[index]) {
+            continue;
+        }
+        size_t dst = (front + compactLen) % MO_REQUEST_CACHE_MAXSIZE;
+        if (dst != index) {
+            requests[dst] = std::move(requests[index]);
+            keys[dst] = keys[index];
         }
+        compactLen++;
     }
+    len = compactLen;
 }
 
 unsigned int VolatileRequestQueue::getFrontRequestOpNr() {
@@ -70,41 +82,47 @@ std::unique_ptr<Request> VolatileRequestQueue::fetchFrontRequest() {
     std::unique_ptr<Request> result = std::move(requests[front]);
     front = (front + 1) % MO_REQUEST_CACHE_MAXSIZE;
     len--;
+    trimFront();
 
     MO_DBG_VERBOSE("front %zu len %zu", front, len);
 
     return result;
 }
 
+bool VolatileRequestQueue::allowsPipelining() {
+    return true;
+}
+
+size_t VolatileRequestQueue::getQueueDepth() {
+    size_t depth = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (requests[(front + i) % MO_REQUEST_CACHE_MAXSIZE]) {
+            depth++;
+        }
+    }
+    return depth;
+}
+
 bool VolatileRequestQueue::pushRequestBack(std::unique_ptr<Request> request) {
 
-    // Don't queue up multiple StatusNotification messages for the same connectorId
-    #if 0 // Leads to ASAN failure when executed by Unit test suite (CustomOperation is casted to StatusNotification)
-    if (strcmp(request->getOperationType(), "StatusNotification") == 0)
-    {
-        size_t i = 0;
-        while (i < len) {
-            size_t index = (front + i) % MO_REQUEST_CACHE_MAXSIZE;
+    auto key = coalesce && request->getOperation() ? request->getOperation()->getCoalescingKey() : CoalescingKey();
 
-            if (strcmp(requests[index]->getOperationType(), "StatusNotification")!= 0)
-            {
-                i++;
-                continue;
-            }
-            auto new_status_notification = static_cast<Ocpp16::StatusNotification*>(request->getOperation());
-            auto old_status_notification = static_cast<Ocpp16::StatusNotification*>(requests[index]->getOperation());
-            if (old_status_notification->getConnectorId() == new_status_notification->getConnectorId()) {
+    // Don't queue up multiple messages which report the same state, e.g. StatusNotifications for the same connectorId
+    if (!key.isNone()) {
+        for (size_t i = 0; i < len; i++) {
+            size_t index = (front + i) % MO_REQUEST_CACHE_MAXSIZE;
+            if (requests[index] && keys[index] == key) {
+                MO_DBG_DEBUG("drop superseded %s", requests[index]->getOperationType());
                 requests[index].reset();
-                for (size_t i = (index + MO_REQUEST_CACHE_MAXSIZE - front) % MO_REQUEST_CACHE_MAXSIZE; i < len - 1; i++) {
-                    requests[(front + i) % MO_REQUEST_CACHE_MAXSIZE] = std::move(requests[(front + i + 1) % MO_REQUEST_CACHE_MAXSIZE]);
-                }
-                len--;
-            } else {
-                i++;
+                break; //there is at most one queued request per key
             }
         }
+        trimFront();
+    }
+
+    if (len >= MO_REQUEST_CACHE_MAXSIZE) {
+        compact();
     }
-    #endif
 
     if (len >= MO_REQUEST_CACHE_MAXSIZE) {
         MO_DBG_INFO("Drop cached operation (cache full): %s", requests[front]->getOperationType());
@@ -114,13 +132,35 @@ bool VolatileRequestQueue::pushRequestBack(std::unique_ptr<Request> request) {
         len--;
     }
 
-    requests[(front + len) % MO_REQUEST_CACHE_MAXSIZE] = std::move(request);
+    size_t back = (front + len) % MO_REQUEST_CACHE_MAXSIZE;
+    requests[back] = std::move(request);
+    keys[back] = key;
     len++;
     return true;
 }
 
+bool VolatileRequestQueue::pushRequestFront(std::unique_ptr<Request> request) {
+    if (len >= MO_REQUEST_CACHE_MAXSIZE) {
+        compact();
+    }
+    if (len >= MO_REQUEST_CACHE_MAXSIZE) {
+        return false;
+    }
+
+    front = (front + MO_REQUEST_CACHE_MAXSIZE - 1) % MO_REQUEST_CACHE_MAXSIZE;
+    keys[front] = coalesce && request->getOperation() ? request->getOperation()->getCoalescingKey() : CoalescingKey();
+    requests[front] = std::move(request);
+    len++;
+    return true;
+}
+
+bool VolatileRequestQueue::isFull() {
+    return getQueueDepth() >= MO_REQUEST_CACHE_MAXSIZE;
+}
+
 RequestQueue::RequestQueue(Connection& connection, OperationRegistry& operationRegistry)
-            : MemoryManaged("RequestQueue"), connection(connection), operationRegistry(operationRegistry) {
+            : MemoryManaged("RequestQueue"), connection(connection), operationRegistry(operationRegistry),
+              recvQueue(false), txArena("RequestQueue", MO_JSON_ARENA_SIZE), rxArena("RequestQueue", MO_JSON_ARENA_SIZE) {
 
     ReceiveTXTcallback callback = [this] (const char *payload, size_t length) {
         return this->receiveMessage(payload, length);
@@ -134,13 +174,34 @@ RequestQueue::RequestQueue(Connection& connection, OperationRegistry& operationR
 
 void RequestQueue::loop() {
 
+    sentInLoop = false;
+
     /*
-     * Check if front request timed out
+     * Check if sent requests timed out
      */
-    if (sendReqFront && sendReqFront->isTimeoutExceeded()) {
-        MO_DBG_INFO("operation timeout: %s", sendReqFront->getOperationType());
-        sendReqFront->executeTimeout();
-        sendReqFront.reset();
+    for (size_t i = 0; i < MO_REQUEST_PIPELINE_MAXSIZE; i++) {
+        auto& sendReq = sendReqs[i].request;
+        if (!sendReq) {
+            continue;
+        }
+
+        bool timeout = false;
+        if (sendReqs[i].responseTimeout && sendReq->isRequestSent()) {
+            //adaptive timeout: wait for the response according to the measured RTT
+            timeout = mocpp_tick_ms() - sendReqs[i].sentAt >= sendReqs[i].responseTimeout;
+            if (timeout) {
+                rttEstimator.onTimeout(sendReq->getOperationType());
+            }
+        } else {
+            timeout = sendReq->isTimeoutExceeded();
+        }
+
+        if (timeout) {
+            MO_DBG_INFO("operation timeout: %s", sendReq->getOperationType());
+            sendReq->executeTimeout();
+            sendReq.reset();
+            sendReqs[i].emitter = nullptr;
+        }
     }
 
     if (recvReqFront && recvReqFront->isTimeoutExceeded()) {
@@ -151,85 +212,219 @@ void RequestQueue::loop() {
 
     defaultSendQueue.loop();
 
+#if MO_ENABLE_PERSISTENT_REQUEST_QUEUE
+    if (persistentSendQueue) {
+        persistentSendQueue->loop();
+    }
+#endif
+
     if (!connection.isConnected()) {
         return;
     }
 
     /**
-     * Send and dequeue a pending confirmation message, if existing
+     * Send and dequeue pending confirmation messages, if existing
      * 
-     * If a message has been sent, terminate this loop() function.
+     * Without confirmation budget: if a message has been sent, terminate this loop() function.
+     * With confirmation budget: send confirmations until the budget is used up and continue with the requests.
      */
 
-    if (!recvReqFront) {
-        recvReqFront = recvQueue.fetchFrontRequest();
-    }
+    size_t confSent = 0;
+    unsigned long confStart = mocpp_tick_ms();
 
-    if (recvReqFront) {
+    while (true) {
+
+        if (!recvReqFront) {
+            recvReqFront = recvQueue.fetchFrontRequest();
+        }
 
-        auto response = initJsonDoc(getMemoryTag());
+        if (!recvReqFront) {
+            break;
+        }
+
+        auto& response = txArena.acquire();
         auto ret = recvReqFront->createResponse(response);
 
-        if (ret == Request::CreateResponseResult::Success) {
-            auto out = makeString(getMemoryTag());
-            serializeJson(response, out);
-    
-            bool success = connection.sendTXT(out.c_str(), out.length());
+        if (ret != Request::CreateResponseResult::Success) {
+            txArena.release();
+            break; //There will be another attempt to send this conf message in a future loop call
+        }
 
+        bool success = sendMessage(response);
+        txArena.release();
+        sentInLoop |= success;
+
+        if (!success || !confBudgetCount) {
             if (success) {
-                MO_DBG_TRAFFIC_OUT(out.c_str());
                 recvReqFront.reset();
             }
-
             return;
-        } //else: There will be another attempt to send this conf message in a future loop call
+        }
+
+        recvReqFront.reset();
+        confSent++;
+
+        if (confSent >= confBudgetCount ||
+                (confBudgetMs && mocpp_tick_ms() - confStart >= confBudgetMs)) {
+            break;
+        }
     }
 
     /**
      * Send pending req message
      */
 
-    if (!sendReqFront) {
+    //a request which has been fetched before but not sent yet takes precedence
+    SendReqSlot *sendReq = nullptr;
+    SendReqSlot *freeSlot = nullptr;
+    size_t inFlight = 0;
+    for (size_t i = 0; i < MO_REQUEST_PIPELINE_MAXSIZE; i++) {
+        if (!sendReqs[i].request) {
+            if (!freeSlot) {
+                freeSlot = &sendReqs[i];
+            }
+            continue;
+        }
+        inFlight++;
+        if (!sendReq && !sendReqs[i].request->isRequestSent()) {
+            sendReq = &sendReqs[i];
+        }
+    }
+
+    if (!sendReq && freeSlot && inFlight < pipelineWindow) {
 
-        unsigned int minOpNr = RequestEmitter::NoOperation;
-        size_t index = MO_NUM_REQUEST_QUEUES;
+        RequestScheduler::Candidate candidates [MO_NUM_REQUEST_QUEUES];
+        size_t count = 0;
         for (size_t i = 0; i < MO_NUM_REQUEST_QUEUES && sendQueues[i]; i++) {
             auto opNr = sendQueues[i]->getFrontRequestOpNr();
-            if (opNr < minOpNr) {
-                minOpNr = opNr;
-                index = i;
+            if (opNr == RequestEmitter::NoOperation) {
+                continue;
             }
+
+            //keep the order of the emitter's requests: the next request of an emitter may depend on the response of
+            //its previous request
+            bool blocked = false;
+            if (!sendQueues[i]->allowsPipelining()) {
+                for (size_t j = 0; j < MO_REQUEST_PIPELINE_MAXSIZE; j++) {
+                    if (sendReqs[j].request && sendReqs[j].emitter == sendQueues[i]) {
+                        blocked = true;
+                        break;
+                    }
+                }
+            }
+
+            candidates[count].emitter = sendQueues[i];
+            candidates[count].opNr = opNr;
+            candidates[count].blocked = blocked;
+            count++;
         }
 
-        if (index < MO_NUM_REQUEST_QUEUES) {
-            sendReqFront = sendQueues[index]->fetchFrontRequest();
+        //each round either fetches a request or marks one more candidate as blocked
+        for (size_t round = 0; round <= count; round++) {
+            size_t index = scheduler->select(candidates, count);
+            if (index >= count || candidates[index].blocked) {
+                break; //nothing to send, or the scheduler waits for the blocked emitter (e.g. to keep the OpNr order)
+            }
+
+            auto emitter = candidates[index].emitter;
+            freeSlot->request = emitter->fetchFrontRequest();
+            if (freeSlot->request) {
+                freeSlot->emitter = emitter;
+                sendReq = freeSlot;
+                scheduler->onFetched(emitter);
+                break;
+            }
+
+            candidates[index].blocked = true; //emitter doesn't provide its request yet, e.g. waiting for retry
         }
     }
 
-    if (sendReqFront && !sendReqFront->isRequestSent()) {
+    if (sendReq) {
 
-        auto request = initJsonDoc(getMemoryTag());
-        auto ret = sendReqFront->createRequest(request);
+        auto& request = txArena.acquire();
+        auto ret = sendReq->request->createRequest(request);
 
         if (ret == Request::CreateRequestResult::Success) {
 
             //send request
-            auto out = makeString(getMemoryTag());
-            serializeJson(request, out);
-
-            bool success = connection.sendTXT(out.c_str(), out.length());
+            bool success = sendMessage(request);
+            txArena.release();
 
             if (success) {
-                MO_DBG_TRAFFIC_OUT(out.c_str());
-                sendReqFront->setRequestSent(); //mask as sent and wait for response / timeout
+                sentInLoop = true;
+                sendReq->request->setRequestSent(); //mask as sent and wait for response / timeout
+                sendReq->sentAt = mocpp_tick_ms();
+                sendReq->responseTimeout = 0;
+                if (sendReq->request->isTimeoutAdaptive()) {
+                    sendReq->responseTimeout = rttEstimator.getTimeout(sendReq->request->getOperationType());
+                    auto maxTimeout = sendReq->request->getTimeoutAdaptiveMax();
+                    if (maxTimeout && maxTimeout < sendReq->responseTimeout) {
+                        sendReq->responseTimeout = maxTimeout;
+                    }
+                }
             }
 
             return;
         }
+
+        txArena.release();
+    }
+}
+
+unsigned long RequestQueue::getNextLoopDelay() {
+
+    unsigned long delay = std::numeric_limits<unsigned long>::max();
+
+    if (connection.isConnected() && (sentInLoop || recvReqFront || recvQueue.getFrontRequestOpNr() != RequestEmitter::NoOperation)) {
+        return 0;
+    }
+
+    unsigned long now = mocpp_tick_ms();
+    for (size_t i = 0; i < MO_REQUEST_PIPELINE_MAXSIZE; i++) {
+        if (sendReqs[i].request && sendReqs[i].request->isRequestSent() && sendReqs[i].responseTimeout) {
+            unsigned long elapsed = now - sendReqs[i].sentAt;
+            unsigned long remaining = sendReqs[i].responseTimeout > elapsed ? sendReqs[i].responseTimeout - elapsed : 0;
+            delay = std::min(delay, remaining);
+        }
     }
+
+    return delay;
+}
+
+/*
+ * Serialize the message and pass it to the connection. If the connection provides a TXT buffer, serialize
+ * directly into it. Otherwise, serialize into a temporary String and send it via sendTXT()
+ */
+bool RequestQueue::sendMessage(const JsonDoc& msg) {
+
+    size_t length = measureJson(msg);
+
+    if (char *buf = connection.leaseTXTBuffer(length + 1)) {
+        serializeJson(msg, buf, length + 1);
+        MO_DBG_TRAFFIC_OUT(buf); //print before committing; the connection may modify the buffer during sending
+        return connection.commitTXTBuffer(length);
+    }
+
+    auto out = makeString(getMemoryTag());
+    out.reserve(length);
+    serializeJson(msg, out);
+
+    bool success = connection.sendTXT(out.c_str(), out.length());
+
+    if (success) {
+        MO_DBG_TRAFFIC_OUT(out.c_str());
+    }
+
+    return success;
 }
 
 void RequestQueue::sendRequest(std::unique_ptr<Request> op){
+#if MO_ENABLE_PERSISTENT_REQUEST_QUEUE
+    if (persistentSendQueue && isPersistentOperationType(op->getOperationType())) {
+        persistentSendQueue->pushRequestBack(std::move(op));
+        return;
+    }
+#endif
     defaultSendQueue.pushRequestBack(std::move(op));
 }
 
@@ -256,6 +451,62 @@ void RequestQueue::setPreBootSendQueue(VolatileRequestQueue *preBootQueue) {
     addSendQueue(preBootQueue);
 }
 
+void RequestQueue::setPersistentSendQueue(PersistentRequestQueue *persistentQueue) {
+#if MO_ENABLE_PERSISTENT_REQUEST_QUEUE
+    this->persistentSendQueue = persistentQueue;
+    addSendQueue(persistentQueue);
+#else
+    MO_DBG_ERR("PersistentRequestQueue disabled");
+#endif
+}
+
+void RequestQueue::setPipelineWindow(size_t window) {
+    if (window < 1 || window > MO_REQUEST_PIPELINE_MAXSIZE) {
+        MO_DBG_ERR("pipeline window must be within 1 and %i", MO_REQUEST_PIPELINE_MAXSIZE);
+        return;
+    }
+    pipelineWindow = window;
+}
+
+size_t RequestQueue::getPipelineWindow() {
+    return pipelineWindow;
+}
+
+void RequestQueue::setConfirmationBudget(size_t maxCount, unsigned long maxTimeMs) {
+    confBudgetCount = maxCount;
+    confBudgetMs = maxTimeMs;
+}
+
+void RequestQueue::setScheduler(std::unique_ptr<RequestScheduler> scheduler) {
+    customScheduler = std::move(scheduler);
+    this->scheduler = customScheduler ? customScheduler.get() : &defaultScheduler;
+}
+
+RequestScheduler& RequestQueue::getScheduler() {
+    return *scheduler;
+}
+
+size_t RequestQueue::getSendQueueCount() {
+    size_t count = 0;
+    while (count < MO_NUM_REQUEST_QUEUES && sendQueues[count]) {
+        count++;
+    }
+    return count;
+}
+
+RequestEmitter *RequestQueue::getSendQueue(size_t index) {
+    return index < MO_NUM_REQUEST_QUEUES ? sendQueues[index] : nullptr;
+}
+
+RttEstimator& RequestQueue::getRttEstimator() {
+    return rttEstimator;
+}
+
+void RequestQueue::setJsonArenaSize(size_t capacity) {
+    txArena.setMaxCapacity(capacity);
+    rxArena.setMaxCapacity(capacity);
+}
+
 unsigned int RequestQueue::getNextOpNr() {
     return nextOpNr++;
 }
@@ -264,27 +515,18 @@ bool RequestQueue::receiveMessage(const char* payload, size_t length) {
 
     MO_DBG_TRAFFIC_IN((int) length, payload);
 
-    size_t capacity_init = (3 * length) / 2;
-
-    //capacity = ceil capacity_init to the next power of two; should be at least 128
+    /*
+     * Size the JsonDoc in a pre-scan of the input, so that the message is deserialized with exactly one
+     * allocation. If the message can't fit into MO_MAX_JSON_CAPACITY, don't parse it at all but go straight
+     * to the recovery of the RPC header below
+     */
+    size_t capacity = measureJsonCapacity(payload, length);
 
-    size_t capacity = 128;
-    while (capacity < capacity_init && capacity < MO_MAX_JSON_CAPACITY) {
-        capacity *= 2;
-    }
-    if (capacity > MO_MAX_JSON_CAPACITY) {
-        capacity = MO_MAX_JSON_CAPACITY;
-    }
-    
-    auto doc = initJsonDoc(getMemoryTag());
+    auto& doc = rxArena.acquire(capacity <= MO_MAX_JSON_CAPACITY ? capacity : 0);
     DeserializationError err = DeserializationError::NoMemory;
 
-    while (err == DeserializationError::NoMemory && capacity <= MO_MAX_JSON_CAPACITY) {
-
-        doc = initJsonDoc(getMemoryTag(), capacity);
+    if (capacity <= MO_MAX_JSON_CAPACITY) {
         err = deserializeJson(doc, payload, length);
-
-        capacity *= 2;
     }
 
     bool success = false;
@@ -317,7 +559,7 @@ bool RequestQueue::receiveMessage(const char* payload, size_t length) {
                 * If the input type is MESSAGE_TYPE_CALLRESULT, then abort the operation to avoid getting stalled.
                 */
 
-            doc = initJsonDoc(getMemoryTag(), 200);
+            rxArena.acquire(200);
             char onlyRpcHeader[200];
             size_t onlyRpcHeader_len = removePayload(payload, length, onlyRpcHeader, sizeof(onlyRpcHeader));
             DeserializationError err2 = deserializeJson(doc, onlyRpcHeader, onlyRpcHeader_len);
@@ -341,23 +583,35 @@ bool RequestQueue::receiveMessage(const char* payload, size_t length) {
             break;
     }
 
+    rxArena.release();
     return success;
 }
 
 /**
- * call conf() on each element of the queue. Start with first element. On successful message delivery,
- * delete the element from the list. Try all the pending OCPP Operations until the right one is found.
- * 
- * This function could result in improper behavior in Charging Stations, because messages are not
- * guaranteed to be received and therefore processed in the right order.
+ * Find the sent request with the same messageId as the response and pass the response to it. The request
+ * is completed afterwards. Responses which don't match any sent request are discarded.
+ *
+ * With pipelining enabled, the responses of different requests can be processed in a different order than
+ * the requests have been sent.
  */
 void RequestQueue::receiveResponse(JsonArray json) {
 
-    if (!sendReqFront || !sendReqFront->receiveResponse(json)) {
-        MO_DBG_WARN("Received response doesn't match pending operation");
+    const char *messageID = json[1] | "";
+
+    for (size_t i = 0; i < MO_REQUEST_PIPELINE_MAXSIZE; i++) {
+        auto& sendReq = sendReqs[i].request;
+        if (sendReq && sendReq->isRequestSent() && !strcmp(sendReq->getMessageID(), messageID)) {
+            rttEstimator.addSample(sendReq->getOperationType(), mocpp_tick_ms() - sendReqs[i].sentAt);
+            if (!sendReq->receiveResponse(json)) {
+                MO_DBG_WARN("Received response cannot be processed by operation");
+            }
+            sendReq.reset();
+            sendReqs[i].emitter = nullptr;
+            return;
+        }
     }
 
-    sendReqFront.reset();
+    MO_DBG_WARN("Received response doesn't match pending operation");
 }
 
 void RequestQueue::receiveRequest(JsonArray json) {
@@ -370,7 +624,10 @@ void RequestQueue::receiveRequest(JsonArray json) {
 }
 
 void RequestQueue::receiveRequest(JsonArray json, std::unique_ptr<Request> op) {
-    op->receiveRequest(json); //execute the operation
+    if (!op->receiveRequest(json)) { //execute the operation
+        MO_DBG_WARN("drop invalid request");
+        return;
+    }
     recvQueue.pushRequestBack(std::move(op)); //enqueue so loop() plans conf sending
 }
 
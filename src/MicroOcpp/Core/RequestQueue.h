@@ -9,6 +9,9 @@
 
 #include <MicroOcpp/Core/Connection.h>
 #include <MicroOcpp/Core/Memory.h>
+#include <MicroOcpp/Core/Operation.h>
+#include <MicroOcpp/Core/RequestScheduler.h>
+#include <MicroOcpp/Core/RttEstimator.h>
 
 #include <memory>
 #include <ArduinoJson.h>
@@ -17,8 +20,9 @@
 #define MO_REQUEST_CACHE_MAXSIZE 10
 #endif
 
-#ifndef MO_NUM_REQUEST_QUEUES
-#define MO_NUM_REQUEST_QUEUES 10
+//max number of outgoing requests which can await their response at the same time (see RequestQueue::setPipelineWindow())
+#ifndef MO_REQUEST_PIPELINE_MAXSIZE
+#define MO_REQUEST_PIPELINE_MAXSIZE 4
 #endif
 
 namespace MicroOcpp {
@@ -26,6 +30,7 @@ namespace MicroOcpp {
 class Connection;
 class OperationRegistry;
 class Request;
+class PersistentRequestQueue;
 
 class RequestEmitter {
 public:
@@ -33,21 +38,55 @@ public:
 
     virtual unsigned int getFrontRequestOpNr() = 0; //return OpNr of front request or NoOperation if queue is empty
     virtual std::unique_ptr<Request> fetchFrontRequest() = 0;
+
+    /*
+     * Return true if the next front request may be sent while a previous request of this emitter is still
+     * awaiting its response. Emitters whose requests depend on the outcome of the preceding request (e.g. the
+     * transaction queues) must keep the default, so that at most one of their requests is in flight at a time
+     */
+    virtual bool allowsPipelining() {return false;}
+
+    /*
+     * Scheduling hints for the RequestScheduler (see RequestScheduler.h). Emitters of the same request group
+     * (>= 0) are served in OpNr order, e.g. the tx messages and tx-related MeterValues of one connector.
+     * -1 = no group
+     */
+    virtual RequestPriority getRequestPriority() {return RequestPriority::Status;}
+    virtual int getRequestGroup() {return -1;}
+
+    //number of queued requests, including requests on the flash. For diagnostics and scheduling only
+    virtual size_t getQueueDepth() {return getFrontRequestOpNr() != NoOperation ? 1 : 0;}
 };
 
+/*
+ * Ring buffer of requests in RAM. If coalescing is enabled, a queued request with the same CoalescingKey is superseded
+ * when a new request is queued: it is dropped without executing its callbacks and the new request is queued at the
+ * back. Dropped requests leave an empty slot which is skipped when the front advances. Only queues of outgoing
+ * requests may coalesce; each incoming request must be answered
+ */
 class VolatileRequestQueue : public RequestEmitter, public MemoryManaged {
 private:
     std::unique_ptr<Request> requests [MO_REQUEST_CACHE_MAXSIZE];
-    size_t front = 0, len = 0;
+    CoalescingKey keys [MO_REQUEST_CACHE_MAXSIZE]; //CoalescingKey of requests[i], cached at push
+    size_t front = 0, len = 0; //len includes empty slots
+    const bool coalesce;
+
+    void trimFront(); //advance front over empty slots
+    void compact(); //close empty slots
 public:
-    VolatileRequestQueue();
+    VolatileRequestQueue(bool coalesce = true);
     ~VolatileRequestQueue();
     void loop();
 
     unsigned int getFrontRequestOpNr() override;
     std::unique_ptr<Request> fetchFrontRequest() override;
+    bool allowsPipelining() override; //queued requests are independent of each other
+    size_t getQueueDepth() override;
 
     bool pushRequestBack(std::unique_ptr<Request> request);
+    bool pushRequestFront(std::unique_ptr<Request> request); //put back a request which has been fetched before. Fails if full
+
+    bool isFull();
 };
 
 class RequestQueue : public MemoryManaged {
@@ -58,18 +97,42 @@ private:
     RequestEmitter* sendQueues [MO_NUM_REQUEST_QUEUES];
     VolatileRequestQueue defaultSendQueue;
     VolatileRequestQueue *preBootSendQueue = nullptr;
-    std::unique_ptr<Request> sendReqFront;
+    PersistentRequestQueue *persistentSendQueue = nullptr;
+
+    struct SendReqSlot {
+        std::unique_ptr<Request> request;
+        RequestEmitter *emitter = nullptr; //emitter which this request has been fetched from
+        unsigned long sentAt = 0; //time of sending
+        unsigned long responseTimeout = 0; //adaptive timeout after sending. 0 = timeout of the request since its creation
+    };
+    SendReqSlot sendReqs [MO_REQUEST_PIPELINE_MAXSIZE]; //requests which have been fetched and are being sent or await their response
+    size_t pipelineWindow = 1; //number of sendReqs in use. 1 = wait for each response before sending the next request
 
     VolatileRequestQueue recvQueue;
     std::unique_ptr<Request> recvReqFront;
 
+    RttEstimator rttEstimator;
+
+    OpNrScheduler defaultScheduler;
+    std::unique_ptr<RequestScheduler> customScheduler;
+    RequestScheduler *scheduler = &defaultScheduler;
+
+    size_t confBudgetCount = 0; //max number of confirmations per loop(). 0 = send one confirmation and no request in the same loop()
+    unsigned long confBudgetMs = 0; //max time for sending confirmations per loop(). 0 = no time limit
+
+    JsonArena txArena; //JsonDoc of the outgoing messages
+    JsonArena rxArena; //JsonDoc of the incoming messages
+
     bool receiveMessage(const char* payload, size_t length); //receive from  server: either a request or response
+    bool sendMessage(const JsonDoc& msg); //send to server: either a request or response
     void receiveRequest(JsonArray json);
     void receiveRequest(JsonArray json, std::unique_ptr<Request> op);
     void receiveResponse(JsonArray json);
 
     unsigned long sockTrackLastConnected = 0;
 
+    bool sentInLoop = false; //last loop() has sent a message, there may be more to send
+
     unsigned int nextOpNr = 10; //Nr 0 - 9 reservered for internal purposes
 public:
     RequestQueue() = delete;
@@ -79,12 +142,57 @@ public:
     RequestQueue(Connection& connection, OperationRegistry& operationRegistry);
 
     void loop(); //polls all reqQueues and decides which request to send (if any)
+    unsigned long getNextLoopDelay(); //time until loop() has work to do, not considering incoming messages
 
     void sendRequest(std::unique_ptr<Request> request); //send an OCPP operation request to the server; adds request to default queue
     void sendRequestPreBoot(std::unique_ptr<Request> request); //send an OCPP operation request to the server; adds request to preBootQueue
 
     void addSendQueue(RequestEmitter* sendQueue);
     void setPreBootSendQueue(VolatileRequestQueue *preBootQueue);
+    void setPersistentSendQueue(PersistentRequestQueue *persistentQueue); //sendRequest() queues StatusNotifications etc. here
+
+    /*
+     * Pipelining: allow up to `window` outgoing requests to await their response at the same time. Responses
+     * are matched by their messageId. Requests of the same RequestEmitter are still sent one after another
+     * unless the emitter allowsPipelining(). Valid range: 1 (default, no pipelining) to MO_REQUEST_PIPELINE_MAXSIZE
+     */
+    void setPipelineWindow(size_t window);
+    size_t getPipelineWindow();
+
+    /*
+     * Budgeted drain of the pending confirmations: loop() sends up to `maxCount` confirmations (CALLRESULTs
+     * and CALLERRORs), or stops earlier when `maxTimeMs` have passed (0 = no time limit). Then it continues
+     * with sending a request in the same loop() call.
+     *
+     * maxCount = 0 (default) keeps the original behavior: loop() sends at most one confirmation and only
+     * sends a request if no confirmation has been sent
+     */
+    void setConfirmationBudget(size_t maxCount, unsigned long maxTimeMs = 0);
+
+    /*
+     * Replace the scheduling policy which decides which RequestEmitter sends next. Default: OpNrScheduler
+     * (strict order of creation). nullptr restores the default
+     */
+    void setScheduler(std::unique_ptr<RequestScheduler> scheduler);
+    RequestScheduler& getScheduler();
+
+    //access the registered RequestEmitters, e.g. to read their queue depths
+    size_t getSendQueueCount();
+    RequestEmitter *getSendQueue(size_t index);
+
+    /*
+     * Round-trip times of the sent requests. Requests with adaptive timeout (default, see Request::setTimeoutAdaptive())
+     * time out when the response doesn't arrive within getRttEstimator().getTimeout(operationType). Configure the floor
+     * and ceiling with getRttEstimator().setTimeoutLimits()
+     */
+    RttEstimator& getRttEstimator();
+
+    /*
+     * Memory which is kept for serializing the outgoing and deserializing the incoming messages between the loop()
+     * calls, in bytes of JsonDoc capacity per direction. Larger messages allocate their JsonDoc temporarily.
+     * Default: MO_JSON_ARENA_SIZE. 0 = allocate and free a JsonDoc per message
+     */
+    void setJsonArenaSize(size_t capacity);
 
     unsigned int getNextOpNr();
 };
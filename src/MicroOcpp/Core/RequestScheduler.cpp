@@ -0,0 +1,152 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#include <MicroOcpp/Core/RequestScheduler.h>
+#include <MicroOcpp/Core/RequestQueue.h>
+#include <MicroOcpp/Debug.h>
+
+//virtual time increment of a request with weight 1
+#define MO_SCHEDULER_VTIME_UNIT 65536UL
+
+using namespace MicroOcpp;
+
+namespace {
+
+//wrap-around safe comparison of virtual times
+bool vtimeBefore(unsigned long a, unsigned long b) {
+    return (long) (a - b) < 0;
+}
+
+} //end namespace
+
+size_t OpNrScheduler::select(const Candidate *candidates, size_t count) {
+    size_t index = count;
+    unsigned int minOpNr = RequestEmitter::NoOperation;
+    for (size_t i = 0; i < count; i++) {
+        if (candidates[i].opNr < minOpNr) {
+            minOpNr = candidates[i].opNr;
+            index = i;
+        }
+    }
+    return index;
+}
+
+WeightedFairScheduler::WeightedFairScheduler() : MemoryManaged("RequestScheduler") {
+    classWeights[(size_t) RequestPriority::Boot] = 1; //not used, Boot is strictly preferred
+    classWeights[(size_t) RequestPriority::TxCritical] = 8;
+    classWeights[(size_t) RequestPriority::Status] = 4;
+    classWeights[(size_t) RequestPriority::Metering] = 2;
+    classWeights[(size_t) RequestPriority::Diagnostics] = 1;
+}
+
+void WeightedFairScheduler::setClassWeight(RequestPriority priority, unsigned int weight) {
+    if ((size_t) priority >= MO_NUM_REQUEST_PRIORITIES || weight < 1) {
+        MO_DBG_ERR("invalid args");
+        return;
+    }
+    classWeights[(size_t) priority] = weight;
+}
+
+void WeightedFairScheduler::setEmitterWeight(RequestEmitter *emitter, unsigned int weight) {
+    auto state = getEmitterState(emitter);
+    if (!state) {
+        MO_DBG_ERR("exceeded emitter capacity");
+        return;
+    }
+    state->weight = weight;
+}
+
+WeightedFairScheduler::EmitterState *WeightedFairScheduler::getEmitterState(RequestEmitter *emitter) {
+    for (size_t i = 0; i < MO_NUM_REQUEST_QUEUES; i++) {
+        if (emitterStates[i].emitter == emitter) {
+            return &emitterStates[i];
+        }
+        if (!emitterStates[i].emitter) {
+            emitterStates[i].emitter = emitter;
+            emitterStates[i].finish = vtime;
+            return &emitterStates[i];
+        }
+    }
+    return nullptr;
+}
+
+unsigned int WeightedFairScheduler::getWeight(EmitterState& state) {
+    if (state.weight) {
+        return state.weight;
+    }
+    size_t priority = (size_t) state.emitter->getRequestPriority();
+    return priority < MO_NUM_REQUEST_PRIORITIES ? classWeights[priority] : 1;
+}
+
+unsigned long WeightedFairScheduler::getStart(EmitterState& state) {
+    //an emitter which has been idle starts at the current virtual time, i.e. it can't save up credit
+    return vtimeBefore(state.finish, vtime) ? vtime : state.finish;
+}
+
+size_t WeightedFairScheduler::select(const Candidate *candidates, size_t count) {
+
+    //Boot class goes first, even if blocked
+    size_t boot = count;
+    for (size_t i = 0; i < count; i++) {
+        if (candidates[i].emitter->getRequestPriority() == RequestPriority::Boot &&
+                (boot >= count || candidates[i].opNr < candidates[boot].opNr)) {
+            boot = i;
+        }
+    }
+    if (boot < count) {
+        return boot;
+    }
+
+    size_t index = count;
+    unsigned long indexStart = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        auto& candidate = candidates[i];
+        if (candidate.blocked) {
+            continue;
+        }
+
+        //only the front emitter of a request group is eligible
+        int group = candidate.emitter->getRequestGroup();
+        bool groupFront = true;
+        if (group >= 0) {
+            for (size_t j = 0; j < count; j++) {
+                if (j != i && candidates[j].emitter->getRequestGroup() == group && candidates[j].opNr < candidate.opNr) {
+                    groupFront = false;
+                    break;
+                }
+            }
+        }
+        if (!groupFront) {
+            continue;
+        }
+
+        auto state = getEmitterState(candidate.emitter);
+        if (!state) {
+            MO_DBG_ERR("exceeded emitter capacity");
+            continue;
+        }
+        unsigned long start = getStart(*state);
+
+        if (index >= count ||
+                vtimeBefore(start, indexStart) ||
+                (start == indexStart && candidate.emitter->getRequestPriority() < candidates[index].emitter->getRequestPriority()) ||
+                (start == indexStart && candidate.emitter->getRequestPriority() == candidates[index].emitter->getRequestPriority() && candidate.opNr < candidates[index].opNr)) {
+            index = i;
+            indexStart = start;
+        }
+    }
+
+    return index;
+}
+
+void WeightedFairScheduler::onFetched(RequestEmitter *emitter) {
+    auto state = getEmitterState(emitter);
+    if (!state) {
+        return;
+    }
+    unsigned long start = getStart(*state);
+    state->finish = start + MO_SCHEDULER_VTIME_UNIT / getWeight(*state);
+    vtime = start;
+}
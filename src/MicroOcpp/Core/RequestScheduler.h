@@ -0,0 +1,102 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#ifndef MO_REQUESTSCHEDULER_H
+#define MO_REQUESTSCHEDULER_H
+
+#include <MicroOcpp/Core/Memory.h>
+
+#ifndef MO_NUM_REQUEST_QUEUES
+#define MO_NUM_REQUEST_QUEUES 10
+#endif
+
+namespace MicroOcpp {
+
+class RequestEmitter;
+
+/*
+ * Traffic class of a RequestEmitter. Lower values are preferred on ties
+ */
+enum class RequestPriority {
+    Boot,        //BootNotification and other PreBoot messages
+    TxCritical,  //transaction-related messages (StartTransaction, StopTransaction, TransactionEvent)
+    Status,      //StatusNotification, SecurityEventNotification and other messages of the default queue
+    Metering,    //MeterValues
+    Diagnostics  //DiagnosticsStatusNotification, FirmwareStatusNotification, etc.
+};
+#define MO_NUM_REQUEST_PRIORITIES 5
+
+/*
+ * Scheduling policy of the RequestQueue: decides which RequestEmitter may send the next request.
+ *
+ * On each send opportunity, the RequestQueue collects all emitters with a front request as candidates and
+ * calls select(). If the selected emitter doesn't provide a request (e.g. because it waits for the next retry),
+ * the RequestQueue marks it as blocked and calls select() again.
+ */
+class RequestScheduler {
+public:
+    struct Candidate {
+        RequestEmitter *emitter;
+        unsigned int opNr; //front OpNr of emitter
+        bool blocked; //emitter can't send now (doesn't allow pipelining and has a request in flight, or hasn't provided a request)
+    };
+
+    virtual ~RequestScheduler() = default;
+
+    //return the index of the candidate to fetch the next request from. If the selected candidate is blocked or the index is out of range, nothing is sent
+    virtual size_t select(const Candidate *candidates, size_t count) = 0;
+
+    //request has been fetched from this emitter
+    virtual void onFetched(RequestEmitter *emitter) { }
+};
+
+/*
+ * Default policy: send the request with the lowest OpNr, i.e. in order of creation. If the front emitter is
+ * blocked, nothing is sent
+ */
+class OpNrScheduler : public RequestScheduler {
+public:
+    size_t select(const Candidate *candidates, size_t count) override;
+};
+
+/*
+ * Weighted-fair policy: emitters share the send opportunities according to their weights, so that a long
+ * backlog of one emitter (e.g. the transactions of a connector after an offline period) doesn't starve the
+ * others. The weight of an emitter defaults to the weight of its RequestPriority class.
+ *
+ * Constraints which are kept:
+ *     - Boot class emitters are strictly preferred (the PreBootQueue blocks all other traffic until accepted)
+ *     - Emitters of the same request group (e.g. tx messages and tx meter values of the same connector) are
+ *       served in OpNr order
+ *     - Blocked emitters are skipped instead of blocking the others
+ * Ties are broken by priority class, then OpNr.
+ */
+class WeightedFairScheduler : public RequestScheduler, public MemoryManaged {
+private:
+    struct EmitterState {
+        RequestEmitter *emitter = nullptr;
+        unsigned int weight = 0; //0 = default weight of the priority class
+        unsigned long finish = 0; //virtual finish time of the last fetched request
+    };
+    EmitterState emitterStates [MO_NUM_REQUEST_QUEUES];
+
+    unsigned int classWeights [MO_NUM_REQUEST_PRIORITIES];
+
+    unsigned long vtime = 0; //virtual time: start time of the last fetched request
+
+    EmitterState *getEmitterState(RequestEmitter *emitter);
+    unsigned int getWeight(EmitterState& state);
+    unsigned long getStart(EmitterState& state);
+public:
+    WeightedFairScheduler();
+
+    void setClassWeight(RequestPriority priority, unsigned int weight); //weight >= 1
+    void setEmitterWeight(RequestEmitter *emitter, unsigned int weight); //weight >= 1; 0 = reset to class weight
+
+    size_t select(const Candidate *candidates, size_t count) override;
+    void onFetched(RequestEmitter *emitter) override;
+};
+
+} //end namespace MicroOcpp
+#endif
@@ -0,0 +1,110 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#include <string.h>
+#include <stdio.h>
+#include <limits>
+
+#include <MicroOcpp/Core/RttEstimator.h>
+#include <MicroOcpp/Debug.h>
+
+using namespace MicroOcpp;
+
+RttEstimator::RttEstimator() : MemoryManaged("RttEstimator") {
+
+}
+
+RttEstimator::Estimate *RttEstimator::getEstimate(const char *operationType, bool create) {
+    if (!operationType || !*operationType || strlen(operationType) >= MO_RTT_OPTYPE_MAXLEN) {
+        return nullptr;
+    }
+    for (size_t i = 0; i < MO_RTT_OPTYPES_MAX; i++) {
+        if (!strcmp(estimates[i].operationType, operationType)) {
+            return &estimates[i];
+        }
+        if (!*estimates[i].operationType) {
+            if (!create) {
+                return nullptr;
+            }
+            snprintf(estimates[i].operationType, sizeof(estimates[i].operationType), "%s", operationType);
+            return &estimates[i];
+        }
+    }
+    return nullptr;
+}
+
+void RttEstimator::update(Estimate& estimate, unsigned long rtt) {
+    if (estimate.samples == 0) {
+        estimate.srtt = rtt;
+        estimate.rttvar = rtt / 2;
+    } else {
+        unsigned long delta = estimate.srtt > rtt ? estimate.srtt - rtt : rtt - estimate.srtt;
+        estimate.rttvar = (3 * estimate.rttvar + delta) / 4;
+        estimate.srtt = (7 * estimate.srtt + rtt) / 8;
+    }
+    if (estimate.samples < std::numeric_limits<unsigned int>::max()) {
+        estimate.samples++;
+    }
+    estimate.backoff = 0;
+}
+
+unsigned long RttEstimator::computeTimeout(const Estimate& estimate) {
+    unsigned long rto = estimate.samples ? estimate.srtt + 4 * estimate.rttvar : MO_REQUEST_RTO_INITIAL;
+    if (rto < rtoMin) {
+        rto = rtoMin;
+    }
+    for (unsigned int i = 0; i < estimate.backoff && rto < rtoMax; i++) {
+        rto *= 2;
+    }
+    if (rto > rtoMax) {
+        rto = rtoMax;
+    }
+    return rto;
+}
+
+void RttEstimator::addSample(const char *operationType, unsigned long rtt) {
+    update(aggregate, rtt);
+    if (auto estimate = getEstimate(operationType, true)) {
+        update(*estimate, rtt);
+    }
+    MO_DBG_VERBOSE("RTT sample %s: %lu ms, RTO %lu ms", operationType, rtt, getTimeout(operationType));
+}
+
+void RttEstimator::onTimeout(const char *operationType) {
+    auto estimate = getEstimate(operationType, true);
+    if (!estimate) {
+        estimate = &aggregate;
+    }
+    if (estimate->backoff < 16) {
+        estimate->backoff++;
+    }
+    MO_DBG_DEBUG("RTO backoff %s: %lu ms", operationType, getTimeout(operationType));
+}
+
+unsigned long RttEstimator::getTimeout(const char *operationType) {
+    if (auto estimate = getEstimate(operationType, false)) {
+        return computeTimeout(*estimate);
+    }
+    if (*estimates[MO_RTT_OPTYPES_MAX - 1].operationType) {
+        return computeTimeout(aggregate); //operation types beyond MO_RTT_OPTYPES_MAX share the aggregate estimate
+    }
+    return computeTimeout(Estimate()); //first request of this type: initial timeout
+}
+
+unsigned long RttEstimator::getSmoothedRtt(const char *operationType) {
+    auto estimate = getEstimate(operationType, false);
+    if (!estimate || !estimate->samples) {
+        return aggregate.srtt;
+    }
+    return estimate->srtt;
+}
+
+void RttEstimator::setTimeoutLimits(unsigned long rtoMin, unsigned long rtoMax) {
+    if (rtoMin > rtoMax) {
+        MO_DBG_ERR("invalid args");
+        return;
+    }
+    this->rtoMin = rtoMin;
+    this->rtoMax = rtoMax;
+}
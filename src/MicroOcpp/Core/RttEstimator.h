@@ -0,0 +1,80 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#ifndef MO_RTTESTIMATOR_H
+#define MO_RTTESTIMATOR_H
+
+#include <stddef.h>
+
+#include <MicroOcpp/Core/Memory.h>
+
+//timeout before the first RTT sample (legacy fixed timeout)
+#ifndef MO_REQUEST_RTO_INITIAL
+#define MO_REQUEST_RTO_INITIAL 40000UL
+#endif
+
+//lower bound of the adaptive timeout. Covers the processing time of slow operations on the server side; lower it for fast links
+#ifndef MO_REQUEST_RTO_MIN
+#define MO_REQUEST_RTO_MIN 20000UL
+#endif
+
+//upper bound of the adaptive timeout, including the backoff after timeouts
+#ifndef MO_REQUEST_RTO_MAX
+#define MO_REQUEST_RTO_MAX 120000UL
+#endif
+
+//number of operation types which are tracked separately. Further types share the aggregate estimate
+#ifndef MO_RTT_OPTYPES_MAX
+#define MO_RTT_OPTYPES_MAX 8
+#endif
+
+#define MO_RTT_OPTYPE_MAXLEN 32
+
+namespace MicroOcpp {
+
+/*
+ * Round-trip time estimator with the retransmission timeout (RTO) computation of TCP (RFC 6298):
+ *
+ *     SRTT   <- 7/8 SRTT + 1/8 R
+ *     RTTVAR <- 3/4 RTTVAR + 1/4 |SRTT - R|
+ *     RTO    <- SRTT + 4 RTTVAR, clamped to [min, max]
+ *
+ * Each timeout doubles the RTO of the operation type until the next sample (exponential backoff). The estimate is
+ * kept per operation type, because the server's processing time differs between the operations (e.g. Heartbeat
+ * vs. StartTransaction). The first request of an operation type waits for MO_REQUEST_RTO_INITIAL, so that a slow
+ * operation doesn't inherit the short timeout of a fast one. Operation types beyond MO_RTT_OPTYPES_MAX share the
+ * aggregate estimate of all operations.
+ */
+class RttEstimator : public MemoryManaged {
+private:
+    struct Estimate {
+        char operationType [MO_RTT_OPTYPE_MAXLEN] = {'\0'}; //empty for the aggregate estimate
+        unsigned long srtt = 0; //ms
+        unsigned long rttvar = 0; //ms
+        unsigned int samples = 0;
+        unsigned int backoff = 0; //number of consecutive timeouts
+    };
+    Estimate aggregate;
+    Estimate estimates [MO_RTT_OPTYPES_MAX];
+
+    unsigned long rtoMin = MO_REQUEST_RTO_MIN;
+    unsigned long rtoMax = MO_REQUEST_RTO_MAX;
+
+    Estimate *getEstimate(const char *operationType, bool create);
+    void update(Estimate& estimate, unsigned long rtt);
+    unsigned long computeTimeout(const Estimate& estimate);
+public:
+    RttEstimator();
+
+    void addSample(const char *operationType, unsigned long rtt); //response received rtt ms after sending
+    void onTimeout(const char *operationType); //no response within getTimeout()
+
+    unsigned long getTimeout(const char *operationType); //wait time for the response in ms
+    unsigned long getSmoothedRtt(const char *operationType); //0 if no sample yet
+
+    void setTimeoutLimits(unsigned long rtoMin, unsigned long rtoMax); //floor and ceiling in ms
+};
+
+} //end namespace MicroOcpp
+#endif
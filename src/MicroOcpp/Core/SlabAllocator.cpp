@@ -0,0 +1,227 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#include <MicroOcpp/Core/SlabAllocator.h>
+
+#if MO_OVERRIDE_ALLOCATION && MO_ENABLE_SLAB_ALLOCATOR
+
+#include <MicroOcpp/Debug.h>
+
+#include <stdint.h>
+
+#if MO_ENABLE_MULTI_INSTANCE
+#include <mutex>
+namespace MicroOcpp {
+namespace SlabLock {
+std::mutex& mutex() {
+    static std::mutex slabMutex; //the instances may allocate from different threads
+    return slabMutex;
+}
+} //end namespace SlabLock
+} //end namespace MicroOcpp
+#define MO_SLAB_LOCK() std::lock_guard<std::mutex> slabLock(MicroOcpp::SlabLock::mutex())
+#else
+#define MO_SLAB_LOCK() (void)0
+#endif
+
+#define MO_SLAB_NCLASSES 5
+
+using namespace MicroOcpp;
+
+namespace {
+
+struct FreeBlock {
+    FreeBlock *next;
+};
+
+struct SizeClass {
+    size_t blockSize;
+    size_t nBlocks;
+    unsigned char *begin;
+    uint16_t *requestedSizes; //requested size per block
+    FreeBlock *freeList;
+    size_t used;
+    size_t maxUsed;
+    size_t requested; //sum of the requested sizes of the used blocks
+    size_t fallbacks; //allocations of this class which went to the heap
+};
+
+SizeClass classes [MO_SLAB_NCLASSES] = {
+    {16, MO_SLAB_BLOCKS_16, nullptr, nullptr, nullptr, 0, 0, 0, 0},
+    {32, MO_SLAB_BLOCKS_32, nullptr, nullptr, nullptr, 0, 0, 0, 0},
+    {64, MO_SLAB_BLOCKS_64, nullptr, nullptr, nullptr, 0, 0, 0, 0},
+    {128, MO_SLAB_BLOCKS_128, nullptr, nullptr, nullptr, 0, 0, 0, 0},
+    {256, MO_SLAB_BLOCKS_256, nullptr, nullptr, nullptr, 0, 0, 0, 0},
+};
+
+unsigned char *slabs = nullptr; //blocks of all classes, followed by the requestedSizes arrays
+unsigned char *slabsEnd = nullptr;
+size_t oversized = 0; //allocations larger than the largest class
+
+bool initSlabs() {
+    if (slabs) {
+        return true;
+    }
+
+    size_t blocksSize = 0, bookkeepingSize = 0;
+    for (size_t i = 0; i < MO_SLAB_NCLASSES; i++) {
+        blocksSize += classes[i].blockSize * classes[i].nBlocks;
+        bookkeepingSize += sizeof(uint16_t) * classes[i].nBlocks;
+    }
+
+    slabs = static_cast<unsigned char*>(Memory::hostMalloc(blocksSize + bookkeepingSize));
+    if (!slabs) {
+        MO_DBG_ERR("OOM");
+        return false;
+    }
+    slabsEnd = slabs + blocksSize;
+
+    unsigned char *block = slabs;
+    uint16_t *requestedSizes = reinterpret_cast<uint16_t*>(slabsEnd);
+    for (size_t i = 0; i < MO_SLAB_NCLASSES; i++) {
+        auto& sizeClass = classes[i];
+        sizeClass.begin = block;
+        sizeClass.requestedSizes = requestedSizes;
+        sizeClass.freeList = nullptr;
+        for (size_t j = sizeClass.nBlocks; j > 0; j--) {
+            auto freeBlock = reinterpret_cast<FreeBlock*>(block + (j - 1) * sizeClass.blockSize);
+            freeBlock->next = sizeClass.freeList;
+            sizeClass.freeList = freeBlock;
+        }
+        block += sizeClass.blockSize * sizeClass.nBlocks;
+        requestedSizes += sizeClass.nBlocks;
+    }
+
+    return true;
+}
+
+} //end namespace
+
+void *Memory::slabMalloc(size_t size) {
+    MO_SLAB_LOCK();
+
+    size_t c = 0;
+    while (c < MO_SLAB_NCLASSES && classes[c].blockSize < size) {
+        c++;
+    }
+
+    if (c >= MO_SLAB_NCLASSES) {
+        oversized++;
+        return nullptr;
+    }
+
+    if (!initSlabs()) {
+        return nullptr;
+    }
+
+    //take a block of the fitting class or of the next larger class
+    for (size_t i = c; i < MO_SLAB_NCLASSES && i <= c + 1; i++) {
+        auto& sizeClass = classes[i];
+        if (auto block = sizeClass.freeList) {
+            sizeClass.freeList = block->next;
+            sizeClass.requestedSizes[((unsigned char*) block - sizeClass.begin) / sizeClass.blockSize] = (uint16_t) size;
+            sizeClass.requested += size;
+            sizeClass.used++;
+            if (sizeClass.used > sizeClass.maxUsed) {
+                sizeClass.maxUsed = sizeClass.used;
+            }
+            return block;
+        }
+    }
+
+    classes[c].fallbacks++;
+    return nullptr;
+}
+
+bool Memory::slabFree(void *ptr) {
+    MO_SLAB_LOCK();
+
+    auto block = static_cast<unsigned char*>(ptr);
+    if (block < slabs || block >= slabsEnd) {
+        return false;
+    }
+
+    for (size_t i = 0; i < MO_SLAB_NCLASSES; i++) {
+        auto& sizeClass = classes[i];
+        if (block < sizeClass.begin + sizeClass.blockSize * sizeClass.nBlocks) {
+            size_t index = (block - sizeClass.begin) / sizeClass.blockSize;
+            sizeClass.requested -= sizeClass.requestedSizes[index];
+            sizeClass.used--;
+            auto freeBlock = reinterpret_cast<FreeBlock*>(block);
+            freeBlock->next = sizeClass.freeList;
+            sizeClass.freeList = freeBlock;
+            break;
+        }
+    }
+    return true;
+}
+
+void Memory::writeSlabStats(JsonObject out) {
+    MO_SLAB_LOCK();
+
+    size_t usedBytes = 0, requested = 0, fallbacks = 0;
+
+    JsonArray by_class = out.createNestedArray("by_class");
+    for (size_t i = 0; i < MO_SLAB_NCLASSES; i++) {
+        auto& sizeClass = classes[i];
+        JsonObject entry = by_class.createNestedObject();
+        entry["size"] = sizeClass.blockSize;
+        entry["blocks"] = sizeClass.nBlocks;
+        entry["used"] = sizeClass.used;
+        entry["max_used"] = sizeClass.maxUsed;
+        entry["requested"] = sizeClass.requested;
+        entry["fallbacks"] = sizeClass.fallbacks;
+
+        usedBytes += sizeClass.used * sizeClass.blockSize;
+        requested += sizeClass.requested;
+        fallbacks += sizeClass.fallbacks;
+    }
+
+    out["slab_size"] = (size_t) (slabsEnd - slabs);
+    out["used_size"] = usedBytes;
+    out["internal_fragmentation"] = usedBytes ? (100 * (usedBytes - requested)) / usedBytes : 0;
+    out["fallbacks"] = fallbacks;
+    out["oversized"] = oversized;
+}
+
+int mo_mem_write_slab_stats_json(char *buf, size_t size) {
+    DynamicJsonDocument doc {JSON_OBJECT_SIZE(6) + JSON_ARRAY_SIZE(MO_SLAB_NCLASSES) + MO_SLAB_NCLASSES * JSON_OBJECT_SIZE(6)};
+    Memory::writeSlabStats(doc.to<JsonObject>());
+
+    if (doc.overflowed()) {
+        MO_DBG_ERR("exceeded JSON capacity");
+        return -1;
+    }
+
+    return (int)serializeJson(doc, buf, size);
+}
+
+void mo_mem_slab_deinit() {
+    MO_SLAB_LOCK();
+
+    if (!slabs) {
+        return;
+    }
+
+    for (size_t i = 0; i < MO_SLAB_NCLASSES; i++) {
+        if (classes[i].used) {
+            MO_DBG_DEBUG("slabs still in use");
+            return;
+        }
+    }
+
+    Memory::hostFree(slabs);
+    slabs = nullptr;
+    slabsEnd = nullptr;
+    oversized = 0;
+    for (size_t i = 0; i < MO_SLAB_NCLASSES; i++) {
+        classes[i].begin = nullptr;
+        classes[i].requestedSizes = nullptr;
+        classes[i].freeList = nullptr;
+        classes[i].maxUsed = 0;
+        classes[i].fallbacks = 0;
+    }
+}
+
+#endif //MO_OVERRIDE_ALLOCATION && MO_ENABLE_SLAB_ALLOCATOR
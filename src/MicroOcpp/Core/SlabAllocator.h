@@ -0,0 +1,74 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#ifndef MO_SLABALLOCATOR_H
+#define MO_SLABALLOCATOR_H
+
+#include <MicroOcpp/Core/Memory.h>
+
+//serve the small allocations of MO_MALLOC from fixed size classes instead of the heap (requires MO_OVERRIDE_ALLOCATION)
+#ifndef MO_ENABLE_SLAB_ALLOCATOR
+#define MO_ENABLE_SLAB_ALLOCATOR 0
+#endif
+
+#if MO_OVERRIDE_ALLOCATION && MO_ENABLE_SLAB_ALLOCATOR
+
+//number of blocks of each size class. The slabs of all classes are allocated at once on the first MO_MALLOC
+#ifndef MO_SLAB_BLOCKS_16
+#define MO_SLAB_BLOCKS_16 64
+#endif
+
+#ifndef MO_SLAB_BLOCKS_32
+#define MO_SLAB_BLOCKS_32 64
+#endif
+
+#ifndef MO_SLAB_BLOCKS_64
+#define MO_SLAB_BLOCKS_64 48
+#endif
+
+#ifndef MO_SLAB_BLOCKS_128
+#define MO_SLAB_BLOCKS_128 32
+#endif
+
+#ifndef MO_SLAB_BLOCKS_256
+#define MO_SLAB_BLOCKS_256 16
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Occupancy of the size classes: for each class the number of blocks in use, the high-water mark, the requested
+ * bytes and the number of allocations which didn't find a free block and went to the heap. The internal
+ * fragmentation is the share of the used blocks which is not requested, in percent. Also part of
+ * mo_mem_write_stats_json() if the heap profiler is enabled
+ */
+int mo_mem_write_slab_stats_json(char *buf, size_t size);
+
+void mo_mem_slab_deinit(); //return the slabs to the heap if no block is in use anymore
+
+#ifdef __cplusplus
+} //extern "C"
+
+namespace MicroOcpp {
+namespace Memory {
+
+/*
+ * Size-class allocator for the small objects which MO creates and deletes all the time (Requests, SampledValues,
+ * Timestamps, JSON documents of small messages). Each class is a slab of equally sized blocks with a free list, so
+ * that these objects don't fragment the heap over a long uptime. Allocations which are larger than the largest
+ * class, or which find their class and the next larger class full, fall back to the heap
+ */
+void *slabMalloc(size_t size); //returns nullptr if the allocation must go to the heap
+bool slabFree(void *ptr); //returns false if ptr doesn't belong to the slabs
+
+void writeSlabStats(JsonObject out);
+
+} //namespace Memory
+} //namespace MicroOcpp
+#endif //__cplusplus
+
+#endif //MO_OVERRIDE_ALLOCATION && MO_ENABLE_SLAB_ALLOCATOR
+#endif
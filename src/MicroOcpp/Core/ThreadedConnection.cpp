@@ -0,0 +1,283 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#include <MicroOcpp/Core/ThreadedConnection.h>
+
+#if MO_ENABLE_THREADED_CONNECTION
+
+#include <MicroOcpp/Debug.h>
+
+#include <string.h>
+#include <chrono>
+
+#define MO_FRAME_WRAP ((size_t) -1) //frame header which tells the consumer to continue at the start of the buffer
+
+using namespace MicroOcpp;
+
+namespace {
+
+//size of a frame in the ring: header + payload + terminating zero, aligned to the header size
+size_t frameSize(size_t length) {
+    size_t size = sizeof(size_t) + length + 1;
+    return (size + sizeof(size_t) - 1) & ~(sizeof(size_t) - 1);
+}
+
+} //end namespace
+
+SpscFrameRing::SpscFrameRing(size_t capacity) : MemoryManaged("ThreadedConnection"), head{0}, tail{0} {
+    if ((capacity & (capacity - 1)) || capacity < 2 * sizeof(size_t)) {
+        MO_DBG_ERR("capacity must be a power of 2");
+        return;
+    }
+
+    buf = static_cast<char*>(MO_MALLOC(getMemoryTag(), capacity));
+    if (!buf) {
+        MO_DBG_ERR("OOM");
+        return;
+    }
+    this->capacity = capacity;
+}
+
+SpscFrameRing::~SpscFrameRing() {
+    MO_FREE(buf);
+}
+
+char *SpscFrameRing::reserve(size_t length) {
+    size_t size = frameSize(length);
+    if (size > capacity) {
+        return nullptr;
+    }
+
+    size_t pos = head.load(std::memory_order_relaxed);
+    size_t used = pos - tail.load(std::memory_order_acquire);
+
+    size_t offset = pos & (capacity - 1);
+    size_t pad = capacity - offset < size ? capacity - offset : 0; //frame doesn't fit before the end of the buffer
+
+    if (capacity - used < pad + size) {
+        return nullptr;
+    }
+
+    if (pad) {
+        //the consumer skips to the buffer start when it reads this header. It's published together with the frame
+        size_t wrap = MO_FRAME_WRAP;
+        memcpy(buf + offset, &wrap, sizeof(size_t));
+        pos += pad;
+        offset = 0;
+    }
+
+    reservedPos = pos;
+    return buf + offset + sizeof(size_t);
+}
+
+void SpscFrameRing::commit(size_t length) {
+    size_t offset = reservedPos & (capacity - 1);
+    memcpy(buf + offset, &length, sizeof(size_t));
+    buf[offset + sizeof(size_t) + length] = '\0';
+    head.store(reservedPos + frameSize(length), std::memory_order_release);
+}
+
+bool SpscFrameRing::push(const char *frame, size_t length) {
+    char *dst = reserve(length);
+    if (!dst) {
+        return false;
+    }
+    memcpy(dst, frame, length);
+    commit(length);
+    return true;
+}
+
+const char *SpscFrameRing::front(size_t *length) {
+    size_t pos = tail.load(std::memory_order_relaxed);
+    if (pos == head.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+
+    size_t offset = pos & (capacity - 1);
+    size_t frameLength;
+    memcpy(&frameLength, buf + offset, sizeof(size_t));
+
+    if (frameLength == MO_FRAME_WRAP) {
+        //the frame is at the buffer start. It has been published together with the wrap header
+        pos += capacity - offset;
+        tail.store(pos, std::memory_order_release);
+        offset = 0;
+        memcpy(&frameLength, buf, sizeof(size_t));
+    }
+
+    *length = frameLength;
+    return buf + offset + sizeof(size_t);
+}
+
+void SpscFrameRing::pop() {
+    size_t pos = tail.load(std::memory_order_relaxed);
+    size_t offset = pos & (capacity - 1);
+    size_t frameLength;
+    memcpy(&frameLength, buf + offset, sizeof(size_t));
+    tail.store(pos + frameSize(frameLength), std::memory_order_release);
+}
+
+bool SpscFrameRing::isEmpty() {
+    return tail.load(std::memory_order_relaxed) == head.load(std::memory_order_acquire);
+}
+
+ThreadedConnection::ThreadedConnection(Connection& connection, size_t ringSize) :
+        MemoryManaged("ThreadedConnection"), connection(connection), rxRing(ringSize), txRing(ringSize),
+        running{false}, connected{connection.isConnected()}, lastRecv{connection.getLastRecv()},
+        lastConnected{connection.getLastConnected()}, rxDropped{0}, txDropped{0} {
+
+}
+
+ThreadedConnection::~ThreadedConnection() {
+    running.store(false, std::memory_order_release);
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void ThreadedConnection::setOnReceive(std::function<void()> onReceive) {
+    if (thread.joinable()) {
+        MO_DBG_ERR("network thread already started");
+        return;
+    }
+    this->onReceive = onReceive;
+}
+
+void ThreadedConnection::run() {
+    while (running.load(std::memory_order_acquire)) {
+
+        connection.loop();
+
+        bool busy = false;
+
+        size_t length;
+        while (const char *frame = txRing.front(&length)) {
+            if (!connection.sendTXT(frame, length)) {
+                MO_DBG_WARN("send failed");
+                txDropped++;
+            }
+            txRing.pop();
+            busy = true;
+        }
+
+        connected.store(connection.isConnected(), std::memory_order_relaxed);
+        lastConnected.store(connection.getLastConnected(), std::memory_order_relaxed);
+
+        if (!busy) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(MO_THREADED_CONNECTION_POLL_MS));
+        }
+    }
+}
+
+void ThreadedConnection::loop() {
+    size_t length;
+    while (const char *frame = rxRing.front(&length)) {
+        if (receiveTXT) {
+            receiveTXT(frame, length);
+        }
+        rxRing.pop();
+    }
+}
+
+bool ThreadedConnection::sendTXT(const char *msg, size_t length) {
+    if (!txRing.push(msg, length)) {
+        MO_DBG_WARN("TX ring full");
+        txDropped++;
+        return false;
+    }
+    return true;
+}
+
+void ThreadedConnection::setReceiveTXTcallback(ReceiveTXTcallback &receiveTXT) {
+    this->receiveTXT = receiveTXT;
+
+    if (thread.joinable()) {
+        return;
+    }
+
+    //forward the incoming frames of the decorated Connection into the RX ring. Executed on the network thread
+    ReceiveTXTcallback pushRx = [this] (const char *payload, size_t length) -> bool {
+        if (!rxRing.push(payload, length)) {
+            MO_DBG_WARN("RX ring full");
+            rxDropped++;
+            return false;
+        }
+        lastRecv.store(mocpp_tick_ms(), std::memory_order_relaxed);
+        if (onReceive) {
+            onReceive();
+        }
+        return true;
+    };
+    connection.setReceiveTXTcallback(pushRx);
+
+    running.store(true, std::memory_order_release);
+    thread = std::thread([this] () {
+        run();
+    });
+}
+
+unsigned long ThreadedConnection::getLastRecv() {
+    return lastRecv.load(std::memory_order_relaxed);
+}
+
+unsigned long ThreadedConnection::getLastConnected() {
+    return lastConnected.load(std::memory_order_relaxed);
+}
+
+bool ThreadedConnection::isConnected() {
+    return connected.load(std::memory_order_relaxed);
+}
+
+char *ThreadedConnection::leaseTXTBuffer(size_t size) {
+    return txRing.reserve(size);
+}
+
+bool ThreadedConnection::commitTXTBuffer(size_t length) {
+    txRing.commit(length);
+    return true;
+}
+
+size_t ThreadedConnection::getRxDropped() {
+    return rxDropped.load();
+}
+
+size_t ThreadedConnection::getTxDropped() {
+    return txDropped.load();
+}
+
+LatencyInjector::LatencyInjector(Connection& connection, unsigned long latencyMs) :
+        MemoryManaged("ThreadedConnection"), connection(connection), latencyMs{latencyMs} {
+
+}
+
+void LatencyInjector::setLatency(unsigned long latencyMs) {
+    this->latencyMs.store(latencyMs);
+}
+
+void LatencyInjector::loop() {
+    connection.loop();
+}
+
+bool LatencyInjector::sendTXT(const char *msg, size_t length) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(latencyMs.load()));
+    return connection.sendTXT(msg, length);
+}
+
+void LatencyInjector::setReceiveTXTcallback(ReceiveTXTcallback &receiveTXT) {
+    connection.setReceiveTXTcallback(receiveTXT);
+}
+
+unsigned long LatencyInjector::getLastRecv() {
+    return connection.getLastRecv();
+}
+
+unsigned long LatencyInjector::getLastConnected() {
+    return connection.getLastConnected();
+}
+
+bool LatencyInjector::isConnected() {
+    return connection.isConnected();
+}
+
+#endif //MO_ENABLE_THREADED_CONNECTION
@@ -0,0 +1,139 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#ifndef MO_THREADEDCONNECTION_H
+#define MO_THREADEDCONNECTION_H
+
+//run the WebSocket I/O on a dedicated network thread (requires std::thread)
+#ifndef MO_ENABLE_THREADED_CONNECTION
+#define MO_ENABLE_THREADED_CONNECTION 0
+#endif
+
+#if MO_ENABLE_THREADED_CONNECTION
+
+#include <MicroOcpp/Core/Connection.h>
+#include <MicroOcpp/Core/Memory.h>
+
+#include <atomic>
+#include <thread>
+
+//capacity in bytes of each direction of the ThreadedConnection. Must be a power of 2 and fit the largest message
+#ifndef MO_THREADED_CONNECTION_RINGSIZE
+#define MO_THREADED_CONNECTION_RINGSIZE 32768
+#endif
+
+//sleep time of the network thread when there is nothing to send
+#ifndef MO_THREADED_CONNECTION_POLL_MS
+#define MO_THREADED_CONNECTION_POLL_MS 1
+#endif
+
+namespace MicroOcpp {
+
+/*
+ * Lock-free single-producer single-consumer ring of text frames. Each frame is stored contiguously with a length
+ * header and a terminating zero, so that both sides can work in place: the producer reserves space and writes the
+ * frame directly into the ring, the consumer reads the frame from the ring and releases it afterwards
+ */
+class SpscFrameRing : public MemoryManaged {
+private:
+    char *buf = nullptr;
+    size_t capacity = 0; //power of 2
+
+    std::atomic<size_t> head; //write position, only advanced by the producer
+    std::atomic<size_t> tail; //read position, only advanced by the consumer
+
+    size_t reservedPos = 0; //producer: position of the reserved frame header
+public:
+    SpscFrameRing(size_t capacity);
+    ~SpscFrameRing();
+
+    //producer
+    char *reserve(size_t length); //returns space for a frame of up to `length` bytes, or nullptr if the ring is full
+    void commit(size_t length); //publish the reserved frame with the actual length
+    bool push(const char *frame, size_t length);
+
+    //consumer
+    const char *front(size_t *length); //returns the next frame (zero-terminated) or nullptr if the ring is empty
+    void pop(); //release the front frame
+
+    bool isEmpty();
+};
+
+/*
+ * Connection decorator which moves the I/O of the decorated Connection onto a dedicated network thread. Slow
+ * TLS handshakes and writes then block the network thread instead of the OCPP logic in mocpp_loop().
+ *
+ * The network thread calls loop() of the decorated Connection and sends the outgoing frames. Incoming frames are
+ * passed to MO in loop() on the MO thread. Both directions are SpscFrameRings, so neither thread takes a lock.
+ * The decorated Connection must not be accessed by the host while the ThreadedConnection exists.
+ *
+ * If a direction is full, the frame is dropped. MO treats this like a message lost in the network
+ */
+class ThreadedConnection : public Connection, public MemoryManaged {
+private:
+    Connection& connection;
+
+    SpscFrameRing rxRing; //produced by network thread, consumed by MO thread
+    SpscFrameRing txRing; //produced by MO thread, consumed by network thread
+
+    ReceiveTXTcallback receiveTXT; //MO thread
+    std::function<void()> onReceive; //network thread
+
+    std::atomic<bool> running;
+    std::atomic<bool> connected;
+    std::atomic<unsigned long> lastRecv;
+    std::atomic<unsigned long> lastConnected;
+    std::atomic<size_t> rxDropped;
+    std::atomic<size_t> txDropped;
+
+    std::thread thread;
+
+    void run(); //network thread
+public:
+    ThreadedConnection(Connection& connection, size_t ringSize = MO_THREADED_CONNECTION_RINGSIZE);
+    ~ThreadedConnection(); //stops the network thread
+
+    /*
+     * Notify the host from the network thread when a frame has arrived, e.g. to wake up the MO thread in tickless
+     * mode (see mocpp_loop_next_deadline_ms()). Set before initializing MO
+     */
+    void setOnReceive(std::function<void()> onReceive);
+
+    void loop() override;
+    bool sendTXT(const char *msg, size_t length) override;
+    void setReceiveTXTcallback(ReceiveTXTcallback &receiveTXT) override;
+    unsigned long getLastRecv() override;
+    unsigned long getLastConnected() override;
+    bool isConnected() override;
+    char *leaseTXTBuffer(size_t size) override;
+    bool commitTXTBuffer(size_t length) override;
+
+    size_t getRxDropped(); //number of incoming frames which didn't fit into the ring
+    size_t getTxDropped(); //number of outgoing frames which didn't fit into the ring or which the decorated Connection rejected
+};
+
+/*
+ * Connection decorator for tests and benchmarks which simulates a slow network: each sendTXT() of the decorated
+ * Connection blocks the calling thread for `latencyMs`, like a slow TLS write
+ */
+class LatencyInjector : public Connection, public MemoryManaged {
+private:
+    Connection& connection;
+    std::atomic<unsigned long> latencyMs;
+public:
+    LatencyInjector(Connection& connection, unsigned long latencyMs);
+
+    void setLatency(unsigned long latencyMs);
+
+    void loop() override;
+    bool sendTXT(const char *msg, size_t length) override;
+    void setReceiveTXTcallback(ReceiveTXTcallback &receiveTXT) override;
+    unsigned long getLastRecv() override;
+    unsigned long getLastConnected() override;
+    bool isConnected() override;
+};
+
+} //end namespace MicroOcpp
+#endif //MO_ENABLE_THREADED_CONNECTION
+#endif
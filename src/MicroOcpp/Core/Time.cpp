@@ -11,107 +11,133 @@ namespace MicroOcpp {
 const Timestamp MIN_TIME = Timestamp(2010, 0, 0, 0, 0, 0);
 const Timestamp MAX_TIME = Timestamp(2037, 0, 0, 0, 0, 0);
 
-Timestamp::Timestamp() : MemoryManaged("Timestamp") {
-    
+namespace {
+
+//days since 1970-01-01 of the given date of the proleptic Gregorian calendar. month in [1, 12], day in [1, 31]
+int32_t daysFromCivil(int32_t year, int32_t month, int32_t day) {
+    year -= month <= 2;
+    int32_t era = (year >= 0 ? year : year - 399) / 400;
+    int32_t yoe = year - era * 400; //[0, 399]
+    int32_t doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1; //[0, 365], year starts in March
+    int32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy; //[0, 146096]
+    return era * 146097 + doe - 719468;
+}
+
+//inverse of daysFromCivil()
+void civilFromDays(int32_t days, int32_t& year, int32_t& month, int32_t& day) {
+    days += 719468;
+    int32_t era = (days >= 0 ? days : days - 146096) / 146097;
+    int32_t doe = days - era * 146097;
+    int32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int32_t mp = (5 * doy + 2) / 153;
+    day = doy - (153 * mp + 2) / 5 + 1;
+    month = mp < 10 ? mp + 3 : mp - 9;
+    year = yoe + era * 400 + (month <= 2);
+}
+
+//floor division, also for negative values
+int32_t floorDiv(int32_t a, int32_t b) {
+    return a / b - (a % b < 0);
 }
 
-Timestamp::Timestamp(const Timestamp& other) : MemoryManaged("Timestamp") {
-    *this = other;
+int32_t toEpochSeconds(int32_t year, int32_t month, int32_t day, int32_t hour, int32_t minute, int32_t second) {
+    year += floorDiv(month, 12);
+    month -= floorDiv(month, 12) * 12;
+    return (daysFromCivil(year, month + 1, 1) + day) * (24 * 3600) + hour * 3600 + minute * 60 + second;
 }
 
+/*
+ * Layout of the ISO 8601 date. 'D' marks a digit, any other character must match literally
+ */
+const char JSONDATE_FORMAT [] = "DDDD-DD-DDTDD:DD:DD";
+const size_t JSONDATE_FORMAT_LEN = sizeof(JSONDATE_FORMAT) - 1;
+
+int parseDigitPair(const char *in) {
+    return (in[0] - '0') * 10 + (in[1] - '0');
+}
+
+const uint8_t DAYS_IN_MONTH [12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+
+bool isLeapYear(int year) {
+    return year % 4 == 0 && (year % 100 != 0 || year % 400 == 0);
+}
+
+//two decimal digits per entry, so that the formatter writes a pair of digits per lookup
+const char DIGIT_PAIRS [] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+} //end namespace
+
 #if MO_ENABLE_TIMESTAMP_MILLISECONDS
     Timestamp::Timestamp(int16_t year, int16_t month, int16_t day, int32_t hour, int32_t minute, int32_t second, int32_t ms) :
-                MemoryManaged("Timestamp"), year(year), month(month), day(day), hour(hour), minute(minute), second(second), ms(ms) { }
+                time(toEpochSeconds(year, month, day, hour, minute, second)) {
+        addMilliseconds(ms);
+    }
 #else 
     Timestamp::Timestamp(int16_t year, int16_t month, int16_t day, int32_t hour, int32_t minute, int32_t second) :
-                MemoryManaged("Timestamp"), year(year), month(month), day(day), hour(hour), minute(minute), second(second) { }
+                time(toEpochSeconds(year, month, day, hour, minute, second)) { }
 #endif //MO_ENABLE_TIMESTAMP_MILLISECONDS
 
-int noDays(int month, int year) {
-    return (month == 0 || month == 2 || month == 4 || month == 6 || month == 7 || month == 9 || month == 11) ? 31 :
-            ((month == 3 || month == 5 || month == 8 || month == 10) ? 30 :
-            ((year % 4 == 0 && (year % 100 != 0 || year % 400 == 0)) ? 29 : 28));
-}
-
 bool Timestamp::setTime(const char *jsonDateString) {
 
-    const int JSONDATE_MINLENGTH = 19;
-
-    if (strlen(jsonDateString) < JSONDATE_MINLENGTH){
-        return false;
+    //single pass over the fixed part which validates all characters against the format. A terminating 0 of too
+    //short strings never matches
+    for (size_t i = 0; i < JSONDATE_FORMAT_LEN; i++) {
+        unsigned char c = (unsigned char) jsonDateString[i];
+        if (JSONDATE_FORMAT[i] == 'D' ? (unsigned int) (c - '0') > 9 : c != (unsigned char) JSONDATE_FORMAT[i]) {
+            return false;
+        }
     }
 
-    if (!isdigit(jsonDateString[0]) ||  //2
-        !isdigit(jsonDateString[1]) ||    //0
-        !isdigit(jsonDateString[2]) ||    //1
-        !isdigit(jsonDateString[3]) ||    //3
-        jsonDateString[4] != '-' ||       //-
-        !isdigit(jsonDateString[5]) ||    //0
-        !isdigit(jsonDateString[6]) ||    //2
-        jsonDateString[7] != '-' ||       //-
-        !isdigit(jsonDateString[8]) ||    //0
-        !isdigit(jsonDateString[9]) ||    //1
-        jsonDateString[10] != 'T' ||      //T
-        !isdigit(jsonDateString[11]) ||   //2
-        !isdigit(jsonDateString[12]) ||   //0
-        jsonDateString[13] != ':' ||      //:
-        !isdigit(jsonDateString[14]) ||   //5
-        !isdigit(jsonDateString[15]) ||   //3
-        jsonDateString[16] != ':' ||      //:
-        !isdigit(jsonDateString[17]) ||   //3
-        !isdigit(jsonDateString[18])) {   //2
-                                        //ignore subsequent characters
-        return false;
-    }
-    
-    int year  =  (jsonDateString[0] - '0') * 1000 +
-                (jsonDateString[1] - '0') * 100 +
-                (jsonDateString[2] - '0') * 10 +
-                (jsonDateString[3] - '0');
-    int month =  (jsonDateString[5] - '0') * 10 +
-                (jsonDateString[6] - '0') - 1;
-    int day   =  (jsonDateString[8] - '0') * 10 +
-                (jsonDateString[9] - '0') - 1;
-    int hour  =  (jsonDateString[11] - '0') * 10 +
-                (jsonDateString[12] - '0');
-    int minute = (jsonDateString[14] - '0') * 10 +
-                (jsonDateString[15] - '0');
-    int second = (jsonDateString[17] - '0') * 10 +
-                (jsonDateString[18] - '0');
-
-    //optional fractals
+    //optional fractals. Takes up to 3 digits, ignores further digits
     int ms = 0;
-    if (jsonDateString[19] == '.') {
-        if (isdigit(jsonDateString[20]) ||   //1
-            isdigit(jsonDateString[21]) ||   //2
-            isdigit(jsonDateString[22])) {
-            
-            ms  =  (jsonDateString[20] - '0') * 100 +
-                    (jsonDateString[21] - '0') * 10 +
-                    (jsonDateString[22] - '0');
-        } else {
+    const char *fraction = jsonDateString + JSONDATE_FORMAT_LEN;
+    if (*fraction == '.') {
+        fraction++;
+        int scale = 100;
+        size_t nDigits = 0;
+        for (; (unsigned int) (fraction[nDigits] - '0') <= 9; nDigits++) {
+            if (nDigits < 3) {
+                ms += (fraction[nDigits] - '0') * scale;
+                scale /= 10;
+            }
+        }
+        if (nDigits == 0) {
             return false;
         }
     }
 
+    int year   = parseDigitPair(jsonDateString) * 100 + parseDigitPair(jsonDateString + 2);
+    int month  = parseDigitPair(jsonDateString + 5) - 1;
+    int day    = parseDigitPair(jsonDateString + 8) - 1;
+    int hour   = parseDigitPair(jsonDateString + 11);
+    int minute = parseDigitPair(jsonDateString + 14);
+    int second = parseDigitPair(jsonDateString + 17);
+
     if (year < 1970 || year >= 2038 ||
         month < 0 || month >= 12 ||
-        day < 0 || day >= noDays(month, year) ||
-        hour < 0 || hour >= 24 ||
-        minute < 0 || minute >= 60 ||
-        second < 0 || second > 60 || //tolerate leap seconds -- (23:59:60) can be a valid time
-        ms < 0 || ms >= 1000) {
+        day < 0 || day >= DAYS_IN_MONTH[month] + (month == 1 && isLeapYear(year)) ||
+        hour >= 24 ||
+        minute >= 60 ||
+        second > 60) { //tolerate leap seconds -- (23:59:60) can be a valid time
         return false;
     }
 
-    this->year = year;
-    this->month = month;
-    this->day = day;
-    this->hour = hour;
-    this->minute = minute;
-    this->second = second;
+    this->time = toEpochSeconds(year, month, day, hour, minute, second);
 #if MO_ENABLE_TIMESTAMP_MILLISECONDS
     this->ms = ms;
+#else
+    (void)ms;
 #endif //MO_ENABLE_TIMESTAMP_MILLISECONDS
     
     return true;
@@ -120,30 +146,28 @@ bool Timestamp::setTime(const char *jsonDateString) {
 bool Timestamp::toJsonString(char *jsonDateString, size_t buffsize) const {
     if (buffsize < JSONDATE_LENGTH + 1) return false;
 
-    jsonDateString[0] = ((char) ((year / 1000) % 10)) + '0';
-    jsonDateString[1] = ((char) ((year / 100) % 10)) + '0';
-    jsonDateString[2] = ((char) ((year / 10) % 10))  + '0';
-    jsonDateString[3] = ((char) ((year / 1) % 10))  + '0';
-    jsonDateString[4] = '-';
-    jsonDateString[5] = ((char) (((month + 1) / 10) % 10))  + '0';
-    jsonDateString[6] = ((char) (((month + 1) / 1) % 10))  + '0';
-    jsonDateString[7] = '-';
-    jsonDateString[8] = ((char) (((day + 1) / 10) % 10))  + '0';
-    jsonDateString[9] = ((char) (((day + 1) / 1) % 10))  + '0';
-    jsonDateString[10] = 'T';
-    jsonDateString[11] = ((char) ((hour / 10) % 10))  + '0';
-    jsonDateString[12] = ((char) ((hour / 1) % 10))  + '0';
-    jsonDateString[13] = ':';
-    jsonDateString[14] = ((char) ((minute / 10) % 10))  + '0';
-    jsonDateString[15] = ((char) ((minute / 1) % 10))  + '0';
-    jsonDateString[16] = ':';
-    jsonDateString[17] = ((char) ((second / 10) % 10))  + '0';
-    jsonDateString[18] = ((char) ((second / 1) % 10))  + '0';
+    int32_t days = floorDiv(time, 24 * 3600);
+    int32_t secOfDay = time - days * (24 * 3600);
+
+    int32_t year, month, day;
+    civilFromDays(days, year, month, day);
+
+    auto writeDigits = [] (char *out, int32_t val) {
+        memcpy(out, DIGIT_PAIRS + 2 * val, 2);
+    };
+
+    memcpy(jsonDateString, "0000-00-00T00:00:00", JSONDATE_FORMAT_LEN);
+    writeDigits(jsonDateString, (year / 100) % 100);
+    writeDigits(jsonDateString + 2, year % 100);
+    writeDigits(jsonDateString + 5, month);
+    writeDigits(jsonDateString + 8, day);
+    writeDigits(jsonDateString + 11, secOfDay / 3600);
+    writeDigits(jsonDateString + 14, (secOfDay / 60) % 60);
+    writeDigits(jsonDateString + 17, secOfDay % 60);
 #if MO_ENABLE_TIMESTAMP_MILLISECONDS
     jsonDateString[19] = '.';
-    jsonDateString[20] = ((char) ((ms / 100) % 10))  + '0';
-    jsonDateString[21] = ((char) ((ms / 10) % 10))  + '0';
-    jsonDateString[22] = ((char) ((ms / 1) % 10))  + '0';
+    jsonDateString[20] = (char) ('0' + ms / 100);
+    writeDigits(jsonDateString + 21, ms % 100);
     jsonDateString[23] = 'Z';
     jsonDateString[24] = '\0';
 #else
@@ -155,55 +179,7 @@ bool Timestamp::toJsonString(char *jsonDateString, size_t buffsize) const {
 }
 
 Timestamp &Timestamp::operator+=(int secs) {
-
-    second += secs;
-
-    if (second >= 0 && second < 60) return *this;
-
-    minute += second / 60;
-    second %= 60;
-    if (second < 0) {
-        minute--;
-        second += 60;
-    }
-
-    if (minute >= 0 && minute < 60) return *this;
-
-    hour += minute / 60;
-    minute %= 60;
-    if (minute < 0) {
-        hour--;
-        minute += 60;
-    }
-
-    if (hour >= 0 && hour < 24) return *this;
-
-    day += hour / 24;
-    hour %= 24;
-    if (hour < 0) {
-        day--;
-        hour += 24;
-    }
-
-    while (day >= noDays(month, year)) {
-        day -= noDays(month, year);
-        month++;
-        
-        if (month >= 12) {
-            month -= 12;
-            year++;
-        }
-    }
-
-    while (day < 0) {
-        month--;
-        if (month < 0) {
-            month += 12;
-            year--;
-        }
-        day += noDays(month, year);
-    }
-
+    time += secs;
     return *this;
 }
 
@@ -214,13 +190,10 @@ Timestamp &Timestamp::addMilliseconds(int val) {
 
     if (ms >= 0 && ms < 1000) return *this;
     
-    auto dsecond = ms / 1000;
-    ms %= 1000;
-    if (ms < 0) {
-        dsecond--;
-        ms += 1000;
-    }
-    return this->operator+=(dsecond);
+    auto dsecond = floorDiv(ms, 1000);
+    ms -= dsecond * 1000;
+    time += dsecond;
+    return *this;
 }
 #endif //MO_ENABLE_TIMESTAMP_MILLISECONDS
 
@@ -229,32 +202,8 @@ Timestamp &Timestamp::operator-=(int secs) {
 }
 
 int Timestamp::operator-(const Timestamp &rhs) const {
-    //dt = rhs - mocpp_base
-    
-    int16_t year_base, year_end;
-    if (year <= rhs.year) {
-        year_base = year;
-        year_end = rhs.year;
-    } else {
-        year_base = rhs.year;
-        year_end = year;
-    }
 
-    int16_t lhsDays = day;
-    int16_t rhsDays = rhs.day;
-
-    for (int16_t iy = year_base; iy <= year_end; iy++) {
-        for (int16_t im = 0; im < 12; im++) {
-            if (year > iy || (year == iy && month > im)) {
-                lhsDays += noDays(im, iy);
-            }
-            if (rhs.year > iy || (rhs.year == iy && rhs.month > im)) {
-                rhsDays += noDays(im, iy);
-            }
-        }
-    }
-
-    int dt = (lhsDays - rhsDays) * (24 * 3600) + (hour - rhs.hour) * 3600 + (minute - rhs.minute) * 60 + second - rhs.second;
+    int dt = time - rhs.time;
 
 #if MO_ENABLE_TIMESTAMP_MILLISECONDS
     // Make it so that we round the difference to the nearest second, instead of being up to almost a whole second off
@@ -265,20 +214,6 @@ int Timestamp::operator-(const Timestamp &rhs) const {
     return dt;
 }
 
-Timestamp &Timestamp::operator=(const Timestamp &rhs) {
-    year = rhs.year;
-    month = rhs.month;
-    day = rhs.day;
-    hour = rhs.hour;
-    minute = rhs.minute;
-    second = rhs.second;
-#if MO_ENABLE_TIMESTAMP_MILLISECONDS
-    ms = rhs.ms;
-#endif //MO_ENABLE_TIMESTAMP_MILLISECONDS
-
-    return *this;
-}
-
 Timestamp operator+(const Timestamp &lhs, int secs) {
     Timestamp res = lhs;
     res += secs;
@@ -290,7 +225,7 @@ Timestamp operator-(const Timestamp &lhs, int secs) {
 }
 
 bool operator==(const Timestamp &lhs, const Timestamp &rhs) {
-    return lhs.year == rhs.year && lhs.month == rhs.month && lhs.day == rhs.day && lhs.hour == rhs.hour && lhs.minute == rhs.minute && lhs.second == rhs.second
+    return lhs.time == rhs.time
 #if MO_ENABLE_TIMESTAMP_MILLISECONDS
     && lhs.ms == rhs.ms
 #endif //MO_ENABLE_TIMESTAMP_MILLISECONDS
@@ -302,27 +237,15 @@ bool operator!=(const Timestamp &lhs, const Timestamp &rhs) {
 }
 
 bool operator<(const Timestamp &lhs, const Timestamp &rhs) {
-    if (lhs.year != rhs.year)
-        return lhs.year < rhs.year;
-    if (lhs.month != rhs.month)
-        return lhs.month < rhs.month;
-    if (lhs.day != rhs.day)
-        return lhs.day < rhs.day;
-    if (lhs.hour != rhs.hour)
-        return lhs.hour < rhs.hour;
-    if (lhs.minute != rhs.minute)
-        return lhs.minute < rhs.minute;
-    if (lhs.second != rhs.second)
-        return lhs.second < rhs.second;
 #if MO_ENABLE_TIMESTAMP_MILLISECONDS
-    if (lhs.ms != rhs.ms)
+    if (lhs.time == rhs.time)
         return lhs.ms < rhs.ms;
 #endif //MO_ENABLE_TIMESTAMP_MILLISECONDS
-    return false;  
+    return lhs.time < rhs.time;
 }
 
 bool operator<=(const Timestamp &lhs, const Timestamp &rhs) {
-    return lhs < rhs || lhs == rhs;
+    return !(rhs < lhs);
 }
 
 bool operator>(const Timestamp &lhs, const Timestamp &rhs) {
@@ -330,7 +253,7 @@ bool operator>(const Timestamp &lhs, const Timestamp &rhs) {
 }
 
 bool operator>=(const Timestamp &lhs, const Timestamp &rhs) {
-    return rhs <= lhs;
+    return !(lhs < rhs);
 }
 
 
@@ -371,6 +294,32 @@ const Timestamp &Clock::now() {
     return currentTime;
 }
 
+bool Clock::toJsonString(const Timestamp& t, char *out, size_t buffsize) {
+    if (buffsize < JSONDATE_LENGTH + 1) return false;
+
+    if (jsonCache[0] == '\0' || t.time != jsonCacheTime) {
+        if (!t.toJsonString(jsonCache, sizeof(jsonCache))) {
+            jsonCache[0] = '\0';
+            return false;
+        }
+        jsonCacheTime = t.time;
+    }
+#if MO_ENABLE_TIMESTAMP_MILLISECONDS
+    else {
+        jsonCache[20] = (char) ('0' + t.ms / 100);
+        jsonCache[21] = (char) ('0' + (t.ms / 10) % 10);
+        jsonCache[22] = (char) ('0' + t.ms % 10);
+    }
+#endif //MO_ENABLE_TIMESTAMP_MILLISECONDS
+
+    memcpy(out, jsonCache, sizeof(jsonCache));
+    return true;
+}
+
+bool Clock::nowJsonString(char *out, size_t buffsize) {
+    return toJsonString(now(), out, buffsize);
+}
+
 Timestamp Clock::adjustPrebootTimestamp(const Timestamp& t) {
     auto systemtime_in = t - Timestamp();
     if (systemtime_in > (int) system_basetime / 1000) {
@@ -24,28 +24,26 @@
 
 namespace MicroOcpp {
 
-class Timestamp : public MemoryManaged {
+/*
+ * Point in time with a resolution of seconds (or milliseconds with MO_ENABLE_TIMESTAMP_MILLISECONDS). Value type
+ * which counts the seconds since the UNIX epoch, so that arithmetic and comparisons are O(1). The calendar fields
+ * are only computed when parsing and formatting ISO 8601 date strings
+ */
+class Timestamp {
 private:
-    /*
-     * Internal representation of the current time. The initial values correspond to UNIX-time 0. January
-     * corresponds to month 0 and the first day in the month is day 0.
-     */
-    int16_t year = 1970;
-    int16_t month = 0;
-    int16_t day = 0;
-    int32_t hour = 0;
-    int32_t minute = 0;
-    int32_t second = 0;
+    int32_t time = 0; //seconds since 1970-01-01T00:00:00Z. Covers dates until 2038-01-19
 #if MO_ENABLE_TIMESTAMP_MILLISECONDS
-    int32_t ms = 0;
+    int32_t ms = 0; //[0, 999]
 #endif //MO_ENABLE_TIMESTAMP_MILLISECONDS
 
 public:
 
-    Timestamp();
-
-    Timestamp(const Timestamp& other);
+    Timestamp() = default;
 
+    /*
+     * Calendar date. January corresponds to month 0 and the first day in the month is day 0. Values out of range
+     * carry over into the next larger unit
+     */
 #if MO_ENABLE_TIMESTAMP_MILLISECONDS
     Timestamp(int16_t year, int16_t month, int16_t day, int32_t hour, int32_t minute, int32_t second, int32_t ms = 0);
 #else 
@@ -69,8 +67,6 @@ public:
 
     bool toJsonString(char *out, size_t buffsize) const;
 
-    Timestamp &operator=(const Timestamp &rhs);
-
 #if MO_ENABLE_TIMESTAMP_MILLISECONDS
     Timestamp &addMilliseconds(int ms);
 #endif //MO_ENABLE_TIMESTAMP_MILLISECONDS
@@ -92,6 +88,8 @@ public:
     friend bool operator<=(const Timestamp &lhs, const Timestamp &rhs);
     friend bool operator>(const Timestamp &lhs, const Timestamp &rhs);
     friend bool operator>=(const Timestamp &lhs, const Timestamp &rhs);
+
+    friend class Clock;
 };
 
 extern const Timestamp MIN_TIME;
@@ -106,6 +104,9 @@ private:
 
     Timestamp currentTime = Timestamp();
 
+    char jsonCache [JSONDATE_LENGTH + 1] = {'\0'}; //formatted second of the last toJsonString()
+    int32_t jsonCacheTime = 0;
+
 public:
 
     Clock();
@@ -115,6 +116,14 @@ public:
 
     const Timestamp &now();
 
+    /*
+     * Writes t as ISO 8601 date string into out, like t.toJsonString(). The date is formatted only once per
+     * second and copied from a cache for subsequent calls with the same second. Use this for timestamps which
+     * have been taken with now() shortly before, like the timestamps of the transaction messages
+     */
+    bool toJsonString(const Timestamp& t, char *out, size_t buffsize);
+    bool nowJsonString(char *out, size_t buffsize); //toJsonString(now(), ...)
+
     /**
      * Expects a date string like
      * 2020-10-01T20:53:32.486Z
@@ -0,0 +1,272 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#include <MicroOcpp/Core/TimerWheel.h>
+#include <MicroOcpp/Platform.h>
+#include <MicroOcpp/Debug.h>
+
+#define MO_TIMERWHEEL_SLOTMASK ((unsigned long) (MO_TIMERWHEEL_SLOTS - 1))
+
+using namespace MicroOcpp;
+
+namespace {
+
+int lowestBit(uint64_t mask) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(mask);
+#else
+    int i = 0;
+    while (!(mask & 1)) {
+        mask >>= 1;
+        i++;
+    }
+    return i;
+#endif
+}
+
+} //end namespace
+
+Timer::Timer(std::function<void()> callback) : callback(std::move(callback)) {
+
+}
+
+Timer::~Timer() {
+    cancel();
+}
+
+void Timer::setCallback(std::function<void()> callback) {
+    this->callback = std::move(callback);
+}
+
+bool Timer::isScheduled() const {
+    return wheel != nullptr;
+}
+
+unsigned long Timer::getDeadline() const {
+    return deadline;
+}
+
+void Timer::cancel() {
+    if (wheel) {
+        wheel->unlink(*this);
+        wheel->count--;
+        wheel = nullptr;
+    }
+}
+
+TimerWheel::TimerWheel() : MemoryManaged("TimerWheel"), current(mocpp_tick_ms()) {
+
+}
+
+TimerWheel::~TimerWheel() {
+    for (auto timer : slots) {
+        while (timer) {
+            timer->wheel = nullptr;
+            timer = timer->next;
+        }
+    }
+}
+
+void TimerWheel::link(Timer& timer, uint16_t list) {
+    timer.list = list;
+    timer.prev = nullptr;
+    timer.next = slots[list];
+    if (timer.next) {
+        timer.next->prev = &timer;
+    }
+    slots[list] = &timer;
+    if (list < LIST_OVERFLOW) {
+        occupied[list / MO_TIMERWHEEL_SLOTS] |= (uint64_t) 1 << (list % MO_TIMERWHEEL_SLOTS);
+    }
+}
+
+void TimerWheel::unlink(Timer& timer) {
+    if (timer.prev) {
+        timer.prev->next = timer.next;
+    } else {
+        slots[timer.list] = timer.next;
+        if (!timer.next && timer.list < LIST_OVERFLOW) {
+            occupied[timer.list / MO_TIMERWHEEL_SLOTS] &= ~((uint64_t) 1 << (timer.list % MO_TIMERWHEEL_SLOTS));
+        }
+    }
+    if (timer.next) {
+        timer.next->prev = timer.prev;
+    }
+    timer.prev = nullptr;
+    timer.next = nullptr;
+}
+
+void TimerWheel::place(Timer& timer) {
+    if ((long) (timer.deadline - current) <= 0) {
+        link(timer, LIST_EXPIRED);
+        return;
+    }
+
+    //the lowest level on which the deadline and the current time only differ in the slot index
+    unsigned long diff = timer.deadline ^ current;
+    for (unsigned int level = 0; level < MO_TIMERWHEEL_LEVELS; level++) {
+        unsigned int shift = level * MO_TIMERWHEEL_SLOTBITS;
+        if ((diff >> shift) <= MO_TIMERWHEEL_SLOTMASK) {
+            link(timer, level * MO_TIMERWHEEL_SLOTS + ((timer.deadline >> shift) & MO_TIMERWHEEL_SLOTMASK));
+            return;
+        }
+    }
+
+    link(timer, LIST_OVERFLOW);
+}
+
+void TimerWheel::cascade(uint16_t list) {
+    Timer *timer = slots[list];
+    slots[list] = nullptr;
+    if (list < LIST_OVERFLOW) {
+        occupied[list / MO_TIMERWHEEL_SLOTS] &= ~((uint64_t) 1 << (list % MO_TIMERWHEEL_SLOTS));
+    }
+
+    while (timer) {
+        Timer *next = timer->next;
+        place(*timer);
+        timer = next;
+    }
+}
+
+void TimerWheel::rebase(unsigned long now) {
+    //the time went backwards. Collect all Timers and place them again
+    Timer *all = nullptr;
+    for (uint16_t list = 0; list < LIST_FIRING; list++) {
+        while (auto timer = slots[list]) {
+            unlink(*timer);
+            timer->next = all;
+            all = timer;
+        }
+    }
+
+    current = now;
+
+    while (all) {
+        Timer *next = all->next;
+        all->next = nullptr;
+        place(*all);
+        all = next;
+    }
+}
+
+void TimerWheel::schedule(Timer& timer, unsigned long delayMs) {
+    if (timer.wheel && timer.wheel != this) {
+        MO_DBG_ERR("Timer already scheduled at other TimerWheel");
+        timer.cancel();
+    }
+
+    if (timer.wheel) {
+        unlink(timer);
+    } else {
+        timer.wheel = this;
+        count++;
+    }
+
+    timer.deadline = mocpp_tick_ms() + delayMs;
+    place(timer);
+}
+
+void TimerWheel::advance(unsigned long now) {
+
+    if ((long) (now - current) < 0) {
+        rebase(now);
+    } else if (now != current) {
+        unsigned long prev = current;
+        current = now;
+
+        const unsigned int wheelBits = MO_TIMERWHEEL_LEVELS * MO_TIMERWHEEL_SLOTBITS;
+        if ((prev >> wheelBits) != (now >> wheelBits)) {
+            cascade(LIST_OVERFLOW);
+        }
+
+        //from the top level downwards, so that the Timers which move down are handled on the lower levels
+        for (int level = MO_TIMERWHEEL_LEVELS - 1; level >= 0; level--) {
+            unsigned int shift = level * MO_TIMERWHEEL_SLOTBITS;
+            unsigned long steps = (now >> shift) - (prev >> shift);
+            if (steps == 0) {
+                continue;
+            }
+
+            //slots which the wheel has entered since the last advance()
+            uint64_t entered;
+            if (steps >= MO_TIMERWHEEL_SLOTS) {
+                entered = ~(uint64_t) 0;
+            } else {
+                unsigned int first = ((prev >> shift) + 1) & MO_TIMERWHEEL_SLOTMASK;
+                uint64_t range = ((uint64_t) 1 << steps) - 1;
+                entered = (range << first) | (first ? range >> (MO_TIMERWHEEL_SLOTS - first) : 0);
+            }
+
+            uint64_t pending = occupied[level] & entered;
+            while (pending) {
+                int slot = lowestBit(pending);
+                pending &= pending - 1;
+                cascade(level * MO_TIMERWHEEL_SLOTS + slot);
+            }
+        }
+    }
+
+    //fire. Timers which the callbacks schedule as due again wait for the next advance()
+    while (auto timer = slots[LIST_EXPIRED]) {
+        unlink(*timer);
+        link(*timer, LIST_FIRING);
+    }
+
+    while (auto timer = slots[LIST_FIRING]) {
+        unlink(*timer);
+        timer->wheel = nullptr;
+        count--;
+        if (timer->callback) {
+            timer->callback();
+        }
+    }
+}
+
+unsigned long TimerWheel::getNextDelay(unsigned long maxDelay) {
+    if (slots[LIST_EXPIRED]) {
+        return 0;
+    }
+
+    unsigned long next = 0;
+    bool found = false;
+
+    //the Timers of the lowest non-empty level are due or move down first
+    for (unsigned int level = 0; level < MO_TIMERWHEEL_LEVELS; level++) {
+        if (!occupied[level]) {
+            continue;
+        }
+        unsigned int shift = level * MO_TIMERWHEEL_SLOTBITS;
+        unsigned int slot = (current >> shift) & MO_TIMERWHEEL_SLOTMASK;
+        uint64_t later = slot + 1 < MO_TIMERWHEEL_SLOTS ? occupied[level] & (~(uint64_t) 0 << (slot + 1)) : 0;
+        if (!later) {
+            continue;
+        }
+        unsigned long groupStart = (current >> (shift + MO_TIMERWHEEL_SLOTBITS)) << (shift + MO_TIMERWHEEL_SLOTBITS);
+        next = groupStart + ((unsigned long) lowestBit(later) << shift);
+        found = true;
+        break;
+    }
+
+    if (!found && slots[LIST_OVERFLOW]) {
+        //the overflow list moves into the wheel when the top level wraps around
+        const unsigned int wheelBits = MO_TIMERWHEEL_LEVELS * MO_TIMERWHEEL_SLOTBITS;
+        next = ((current >> wheelBits) + 1) << wheelBits;
+        found = true;
+    }
+
+    if (!found) {
+        return maxDelay;
+    }
+
+    unsigned long now = mocpp_tick_ms();
+    if ((long) (next - now) <= 0) {
+        return 0;
+    }
+    return next - now < maxDelay ? next - now : maxDelay;
+}
+
+size_t TimerWheel::size() const {
+    return count;
+}
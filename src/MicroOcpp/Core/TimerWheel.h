@@ -0,0 +1,92 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#ifndef MO_TIMERWHEEL_H
+#define MO_TIMERWHEEL_H
+
+#include <MicroOcpp/Core/Memory.h>
+
+#include <functional>
+#include <stdint.h>
+
+#define MO_TIMERWHEEL_LEVELS 4      //4 levels of 64 slots cover 64^4 ms (4.6 h). Later deadlines wait in an overflow list
+#define MO_TIMERWHEEL_SLOTBITS 6
+#define MO_TIMERWHEEL_SLOTS (1 << MO_TIMERWHEEL_SLOTBITS)
+
+namespace MicroOcpp {
+
+class TimerWheel;
+
+/*
+ * Deadline which a service registers at the TimerWheel of its Context (see Context::getTimerWheel()). The service
+ * keeps the Timer as a member. Destroying the Timer cancels it
+ */
+class Timer {
+private:
+    friend class TimerWheel;
+
+    std::function<void()> callback;
+
+    TimerWheel *wheel = nullptr; //not nullptr while scheduled
+    Timer *prev = nullptr;
+    Timer *next = nullptr;
+    unsigned long deadline = 0;
+    uint16_t list = 0; //index of the list in the TimerWheel which holds this Timer
+public:
+    Timer() = default;
+    Timer(std::function<void()> callback);
+    ~Timer();
+
+    Timer(const Timer&) = delete;
+    Timer& operator=(const Timer&) = delete;
+
+    void setCallback(std::function<void()> callback);
+
+    bool isScheduled() const;
+    unsigned long getDeadline() const; //only valid while scheduled
+    void cancel();
+};
+
+/*
+ * Hierarchical timer wheel. Level 0 has one slot per ms, each further level has slots which are 64 times wider.
+ * A Timer is placed on the lowest level on which its deadline is in a later slot than the current time. When
+ * the wheel advances into a slot of an upper level, the Timers of that slot move down to the lower levels or
+ * fire if due. Scheduling, canceling and advancing over slots without Timers costs O(1), independent of the
+ * number of pending Timers
+ */
+class TimerWheel : public MemoryManaged {
+private:
+    static const uint16_t LIST_OVERFLOW = MO_TIMERWHEEL_LEVELS * MO_TIMERWHEEL_SLOTS;
+    static const uint16_t LIST_EXPIRED = LIST_OVERFLOW + 1; //due, fire at next advance()
+    static const uint16_t LIST_FIRING = LIST_OVERFLOW + 2; //due, fire during this advance()
+
+    Timer *slots [MO_TIMERWHEEL_LEVELS * MO_TIMERWHEEL_SLOTS + 3] = {nullptr};
+    uint64_t occupied [MO_TIMERWHEEL_LEVELS] = {0}; //bit per non-empty slot
+
+    unsigned long current = 0; //time up to which the wheel has advanced
+    size_t count = 0;
+
+    void link(Timer& timer, uint16_t list);
+    void unlink(Timer& timer);
+    void place(Timer& timer); //put into the list which corresponds to its deadline
+    void cascade(uint16_t list);
+    void rebase(unsigned long now);
+
+    friend class Timer;
+public:
+    TimerWheel();
+    ~TimerWheel();
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    void schedule(Timer& timer, unsigned long delayMs); //fire delayMs after now. Replaces the previous deadline
+    void advance(unsigned long now); //fire all Timers which are due at now
+
+    unsigned long getNextDelay(unsigned long maxDelay); //time until the next Timer is due or moves down a level, at most maxDelay
+    size_t size() const;
+};
+
+} //end namespace MicroOcpp
+#endif
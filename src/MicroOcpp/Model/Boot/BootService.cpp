@@ -24,6 +24,14 @@ unsigned int PreBootQueue::getFrontRequestOpNr() {
     return VolatileRequestQueue::getFrontRequestOpNr();
 }
 
+bool PreBootQueue::allowsPipelining() {
+    return activatedPostBootCommunication;
+}
+
+RequestPriority PreBootQueue::getRequestPriority() {
+    return activatedPostBootCommunication ? RequestPriority::Status : RequestPriority::Boot;
+}
+
 void PreBootQueue::activatePostBootCommunication() {
     activatedPostBootCommunication = true;
 }
@@ -55,6 +63,12 @@ BootService::BootService(Context& context, std::shared_ptr<FilesystemAdapter> fi
     //Register message handler for TriggerMessage operation
     context.getOperationRegistry().registerOperation("BootNotification", [this] () {
         return new Ocpp16::BootNotification(this->context.getModel(), getChargePointCredentials());});
+
+    retryTimer.setCallback([this] () {
+        if (status != RegistrationStatus::Accepted) {
+            sendBootNotification();
+        }
+    });
 }
 
 void BootService::loop() {
@@ -92,10 +106,17 @@ void BootService::loop() {
         return;
     }
     
-    if (mocpp_tick_ms() - lastBootNotification < (interval_s * 1000UL)) {
-        return;
+    if (!retryTimer.isScheduled()) {
+        unsigned long elapsed = mocpp_tick_ms() - lastBootNotification;
+        if (elapsed >= interval_s * 1000UL) {
+            sendBootNotification();
+        } else {
+            context.getTimerWheel().schedule(retryTimer, interval_s * 1000UL - elapsed);
+        }
     }
+}
 
+void BootService::sendBootNotification() {
     /*
      * Create BootNotification. The BootNotifaction object will fetch its paremeters from
      * this class and notify this class about the response
@@ -105,6 +126,7 @@ void BootService::loop() {
     context.getRequestQueue().sendRequestPreBoot(std::move(bootNotification));
 
     lastBootNotification = mocpp_tick_ms();
+    context.getTimerWheel().schedule(retryTimer, interval_s * 1000UL);
 }
 
 void BootService::setChargePointCredentials(JsonObject credentials) {
@@ -148,6 +170,7 @@ std::unique_ptr<JsonDoc> BootService::getChargePointCredentials() {
 void BootService::notifyRegistrationStatus(RegistrationStatus status) {
     this->status = status;
     lastBootNotification = mocpp_tick_ms();
+    retryTimer.cancel(); //loop() schedules the next attempt with the updated interval
 }
 
 void BootService::setRetryInterval(unsigned long interval_s) {
@@ -157,6 +180,7 @@ void BootService::setRetryInterval(unsigned long interval_s) {
         this->interval_s = interval_s;
     }
     lastBootNotification = mocpp_tick_ms();
+    retryTimer.cancel();
 }
 
 bool BootService::loadBootStats(std::shared_ptr<FilesystemAdapter> filesystem, BootStats& bstats) {
@@ -232,6 +256,7 @@ bool BootService::recover(std::shared_ptr<FilesystemAdapter> filesystem, BootSta
                 !strncmp(fname, "tx", strlen("tx")) ||
                 !strncmp(fname, "sc-", strlen("sc-")) ||
                 !strncmp(fname, "reservation", strlen("reservation")) ||
+                !strncmp(fname, "reqq", strlen("reqq")) ||
                 !strncmp(fname, "client-state", strlen("client-state"));
     });
     MO_DBG_ERR("clear local state files (recovery): %s", success ? "success" : "not completed");
@@ -9,6 +9,7 @@
 #include <MicroOcpp/Core/FilesystemAdapter.h>
 #include <MicroOcpp/Core/RequestQueue.h>
 #include <MicroOcpp/Core/Memory.h>
+#include <MicroOcpp/Core/TimerWheel.h>
 #include <memory>
 
 #define MO_BOOT_INTERVAL_DEFAULT 60
@@ -46,6 +47,8 @@ private:
     bool activatedPostBootCommunication = false;
 public:
     unsigned int getFrontRequestOpNr() override; //override FrontRequestOpNr behavior: in PreBoot mode, always return 0 to avoid other RequestEmitters from sending msgs
+    bool allowsPipelining() override; //in PreBoot mode, wait for the BootNotification response before sending anything else
+    RequestPriority getRequestPriority() override; //in PreBoot mode, Boot class
     
     void activatePostBootCommunication(); //end PreBoot mode, now send Requests normally
 };
@@ -61,6 +64,8 @@ private:
 
     unsigned long interval_s = MO_BOOT_INTERVAL_DEFAULT;
     unsigned long lastBootNotification = -1UL / 2;
+    Timer retryTimer;
+    void sendBootNotification();
 
     RegistrationStatus status = RegistrationStatus::Pending;
     
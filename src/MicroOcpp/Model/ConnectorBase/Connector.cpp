@@ -1278,6 +1278,18 @@ std::unique_ptr<Request> Connector::fetchFrontRequest() {
     return nullptr;
 }
 
+RequestPriority Connector::getRequestPriority() {
+    return RequestPriority::TxCritical;
+}
+
+int Connector::getRequestGroup() {
+    return (int) connectorId;
+}
+
+size_t Connector::getQueueDepth() {
+    return (txNrEnd + MAX_TX_CNT - txNrFront) % MAX_TX_CNT;
+}
+
 bool Connector::triggerStatusNotification() {
 
     ErrorData errorData {nullptr};
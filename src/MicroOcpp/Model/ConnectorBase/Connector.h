@@ -154,6 +154,9 @@ public:
 
     unsigned int getFrontRequestOpNr() override;
     std::unique_ptr<Request> fetchFrontRequest() override;
+    RequestPriority getRequestPriority() override; //TxCritical
+    int getRequestGroup() override; //connectorId; keeps the order with the tx-related MeterValues
+    size_t getQueueDepth() override; //number of transactions with pending messages (upper bound)
 
     bool triggerStatusNotification();
 
@@ -283,7 +283,7 @@ void DiagnosticsService::setDiagnosticsReader(std::function<size_t(char *buf, si
         }
 
         char jsonDate [JSONDATE_LENGTH + 1];
-        model.getClock().now().toJsonString(jsonDate, sizeof(jsonDate));
+        model.getClock().nowJsonString(jsonDate, sizeof(jsonDate));
 
         int ret;
 
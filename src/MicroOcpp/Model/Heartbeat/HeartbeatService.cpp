@@ -15,6 +15,9 @@ HeartbeatService::HeartbeatService(Context& context) : MemoryManaged("v16.Heartb
     heartbeatIntervalInt = declareConfiguration<int>("HeartbeatInterval", 86400);
     registerConfigurationValidator("HeartbeatInterval", VALIDATE_UNSIGNED_INT);
     lastHeartbeat = mocpp_tick_ms();
+    heartbeatTimer.setCallback([this] () {
+        sendHeartbeat();
+    });
 
     //Register message handler for TriggerMessage operation
     context.getOperationRegistry().registerOperation("Heartbeat", [&context] () {
@@ -22,16 +25,34 @@ HeartbeatService::HeartbeatService(Context& context) : MemoryManaged("v16.Heartb
 }
 
 void HeartbeatService::loop() {
+    //arm the Timer once the Model runs its tasks and whenever the interval changes
+    if (heartbeatTimer.isScheduled() && heartbeatIntervalInt->getValueRevision() == trackHeartbeatIntervalRevision) {
+        return;
+    }
+    trackHeartbeatIntervalRevision = heartbeatIntervalInt->getValueRevision();
+
     unsigned long hbInterval = heartbeatIntervalInt->getInt();
     hbInterval *= 1000UL; //conversion s -> ms
-    unsigned long now = mocpp_tick_ms();
-
-    if (now - lastHeartbeat >= hbInterval) {
-        lastHeartbeat = now;
+    unsigned long elapsed = mocpp_tick_ms() - lastHeartbeat;
 
-        auto heartbeat = makeRequest(new Ocpp16::Heartbeat(context.getModel()));
-        // Heartbeats can not deviate more than 4s from the configured interval
-        heartbeat->setTimeout(std::min(4000UL, hbInterval));
-        context.initiateRequest(std::move(heartbeat));
+    if (elapsed >= hbInterval) {
+        sendHeartbeat();
+    } else {
+        context.getTimerWheel().schedule(heartbeatTimer, hbInterval - elapsed);
     }
 }
+
+void HeartbeatService::sendHeartbeat() {
+    unsigned long hbInterval = heartbeatIntervalInt->getInt();
+    hbInterval *= 1000UL; //conversion s -> ms
+    lastHeartbeat = mocpp_tick_ms();
+
+    auto heartbeat = makeRequest(new Ocpp16::Heartbeat(context.getModel()));
+    // Heartbeats can not deviate more than 4s from the configured interval. Once sent, wait for the response
+    // according to the measured RTT, but not longer than the interval
+    heartbeat->setTimeout(std::min(4000UL, hbInterval));
+    heartbeat->setTimeoutAdaptive(hbInterval);
+    context.initiateRequest(std::move(heartbeat));
+
+    context.getTimerWheel().schedule(heartbeatTimer, hbInterval);
+}
@@ -9,6 +9,7 @@
 
 #include <MicroOcpp/Core/ConfigurationKeyValue.h>
 #include <MicroOcpp/Core/Memory.h>
+#include <MicroOcpp/Core/TimerWheel.h>
 
 namespace MicroOcpp {
 
@@ -20,6 +21,10 @@ private:
 
     unsigned long lastHeartbeat;
     std::shared_ptr<Configuration> heartbeatIntervalInt;
+    revision_t trackHeartbeatIntervalRevision = 0;
+
+    Timer heartbeatTimer;
+    void sendHeartbeat();
 
 public:
     HeartbeatService(Context& context);
@@ -160,6 +160,8 @@ void MeteringConnector::loop() {
             }
             lastSampleTime = mocpp_tick_ms();
         }
+
+        context.scheduleLoop((unsigned long) (meterValueSampleIntervalInt->getInt() * 1000) - (mocpp_tick_ms() - lastSampleTime));
     }
 }
 
@@ -261,6 +263,18 @@ unsigned int MeteringConnector::getFrontRequestOpNr() {
     return NoOperation;
 }
 
+RequestPriority MeteringConnector::getRequestPriority() {
+    return RequestPriority::Metering;
+}
+
+int MeteringConnector::getRequestGroup() {
+    return connectorId;
+}
+
+size_t MeteringConnector::getQueueDepth() {
+    return meterData.size() + (meterDataFront ? 1 : 0);
+}
+
 std::unique_ptr<Request> MeteringConnector::fetchFrontRequest() {
 
     if (!meterDataFront) {
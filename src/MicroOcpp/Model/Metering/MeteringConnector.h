@@ -88,6 +88,9 @@ public:
     //RequestEmitter implementation
     unsigned int getFrontRequestOpNr() override;
     std::unique_ptr<Request> fetchFrontRequest() override;
+    RequestPriority getRequestPriority() override; //Metering
+    int getRequestGroup() override; //connectorId; keeps the order with the tx messages
+    size_t getQueueDepth() override;
 
 };
 
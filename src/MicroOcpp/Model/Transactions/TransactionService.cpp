@@ -941,6 +941,18 @@ std::unique_ptr<Request> TransactionService::Evse::fetchFrontRequest() {
     return txEventRequest;
 }
 
+RequestPriority TransactionService::Evse::getRequestPriority() {
+    return RequestPriority::TxCritical;
+}
+
+int TransactionService::Evse::getRequestGroup() {
+    return (int) evseId;
+}
+
+size_t TransactionService::Evse::getQueueDepth() {
+    return (txNrEnd + MAX_TX_CNT - txNrFront) % MAX_TX_CNT;
+}
+
 bool TransactionService::isTxStartPoint(TxStartStopPoint check) {
     for (auto& v : txStartPointParsed) {
         if (v == check) {
@@ -91,6 +91,9 @@ public:
 
         unsigned int getFrontRequestOpNr() override;
         std::unique_ptr<Request> fetchFrontRequest() override;
+        RequestPriority getRequestPriority() override; //TxCritical
+        int getRequestGroup() override; //evseId
+        size_t getQueueDepth() override; //number of transactions with pending messages (upper bound)
 
         friend TransactionService;
     };
@@ -7,14 +7,116 @@
 #include <MicroOcpp/Core/FilesystemUtils.h>
 #include <MicroOcpp/Debug.h>
 
+#include <algorithm>
+
 using namespace MicroOcpp;
 
+#if MO_ENABLE_TX_JOURNAL
+
+#define MO_TX_JOURNAL_STATE_SIZE 1024 //capacity for replaying the records on a tx, like serializeTransaction()
+
+namespace {
+
+//the states of txs only contain strings, integers and bools
+bool equalsJson(JsonVariant a, JsonVariant b) {
+    if (a.is<const char*>() || b.is<const char*>()) {
+        return a.is<const char*>() && b.is<const char*>() && !strcmp(a.as<const char*>(), b.as<const char*>());
+    }
+    if (a.is<bool>() || b.is<bool>()) {
+        return a.is<bool>() && b.is<bool>() && a.as<bool>() == b.as<bool>();
+    }
+    return a.is<long>() && b.is<long>() && a.as<long>() == b.as<long>();
+}
+
+//write the fields of newState which differ from oldState into delta. Fields which are only in oldState become null
+void diffJson(JsonObject oldState, JsonObject newState, JsonObject delta) {
+    for (JsonPair kv : newState) {
+        JsonVariant oldVal = oldState[kv.key().c_str()];
+        if (kv.value().is<JsonObject>() && oldVal.is<JsonObject>()) {
+            JsonObject nested = delta.createNestedObject(kv.key());
+            diffJson(oldVal.as<JsonObject>(), kv.value().as<JsonObject>(), nested);
+            if (nested.size() == 0) {
+                delta.remove(kv.key().c_str());
+            }
+        } else if (!equalsJson(oldVal, kv.value())) {
+            delta[kv.key()] = kv.value();
+        }
+    }
+    for (JsonPair kv : oldState) {
+        if (!newState.containsKey(kv.key().c_str())) {
+            delta[kv.key()] = nullptr;
+        }
+    }
+}
+
+//inverse of diffJson(): apply delta on state
+void mergeJson(JsonObject state, JsonObject delta) {
+    for (JsonPair kv : delta) {
+        if (kv.value().isNull()) {
+            state.remove(kv.key().c_str());
+        } else if (kv.value().is<JsonObject>()) {
+            JsonObject nested = state[kv.key().c_str()].is<JsonObject>() ?
+                    state[kv.key().c_str()].as<JsonObject>() :
+                    state.createNestedObject(kv.key());
+            mergeJson(nested, kv.value().as<JsonObject>());
+        } else {
+            state[kv.key()] = kv.value();
+        }
+    }
+}
+
+//read the next record. Returns 1 if successful, 0 at the end of the file and -1 if the last record is incomplete
+int readRecord(FileAdapter& file, String& line) {
+    line.clear();
+    int c;
+    while ((c = file.read()) >= 0 && c != '\n') {
+        if (line.length() >= MO_MAX_JSON_CAPACITY) {
+            MO_DBG_ERR("record exceeds MO_MAX_JSON_CAPACITY");
+            return -1;
+        }
+        line.push_back((char) c);
+    }
+    if (c == '\n') {
+        return 1;
+    }
+    return line.empty() ? 0 : -1;
+}
+
+//parse the leading txNr of a record and if it is an "rm" record, without deserializing the record
+bool parseRecordHeader(const char *line, unsigned int& txNr, bool& rm) {
+    const char *prefix = "{\"txNr\":";
+    size_t prefixLen = strlen(prefix);
+    if (strncmp(line, prefix, prefixLen)) {
+        return false;
+    }
+    const char *p = line + prefixLen;
+    if (*p < '0' || *p > '9') {
+        return false;
+    }
+    txNr = 0;
+    for (; *p >= '0' && *p <= '9'; p++) {
+        txNr *= 10;
+        txNr += *p - '0';
+    }
+    rm = !strncmp(p, ",\"rm\"", strlen(",\"rm\""));
+    return true;
+}
+
+} //end namespace
+
+#endif //MO_ENABLE_TX_JOURNAL
+
 ConnectorTransactionStore::ConnectorTransactionStore(TransactionStore& context, unsigned int connectorId, std::shared_ptr<FilesystemAdapter> filesystem) :
         MemoryManaged("v16.Transactions.TransactionStore"),
         context(context),
         connectorId(connectorId),
         filesystem(filesystem),
-        transactions{makeVector<std::weak_ptr<Transaction>>(getMemoryTag())} {
+        transactions{makeVector<std::weak_ptr<Transaction>>(getMemoryTag())}
+#if MO_ENABLE_TX_JOURNAL
+        , committed{makeVector<CommittedState>(getMemoryTag())},
+        journalTxNrs{makeVector<unsigned int>(getMemoryTag())}
+#endif
+        {
 
 }
 
@@ -22,6 +124,105 @@ ConnectorTransactionStore::~ConnectorTransactionStore() {
 
 }
 
+bool ConnectorTransactionStore::printTxFn(char *fn, size_t size, unsigned int txNr) {
+    auto ret = snprintf(fn, size, MO_FILENAME_PREFIX "tx" "-%u-%u.json", connectorId, txNr);
+    if (ret < 0 || (size_t) ret >= size) {
+        MO_DBG_ERR("fn error: %i", ret);
+        return false;
+    }
+    return true;
+}
+
+std::unique_ptr<JsonDoc> ConnectorTransactionStore::loadTransactionJson(unsigned int txNr) {
+
+#if MO_ENABLE_TX_JOURNAL
+    loadJournal(); //before loading the tx file, because this may compact the journal into it
+#endif
+
+    char fn [MO_MAX_PATH_SIZE] = {'\0'};
+    if (!printTxFn(fn, sizeof(fn), txNr)) {
+        return nullptr;
+    }
+
+    size_t msize;
+    if (filesystem->stat(fn, &msize) != 0) {
+        MO_DBG_DEBUG("%u-%u does not exist", connectorId, txNr);
+        return nullptr;
+    }
+
+    auto doc = FilesystemUtils::loadJson(filesystem, fn, getMemoryTag());
+
+    if (!doc) {
+        MO_DBG_ERR("memory corruption");
+        return nullptr;
+    }
+
+#if MO_ENABLE_TX_JOURNAL
+    if (std::find(journalTxNrs.begin(), journalTxNrs.end(), txNr) == journalTxNrs.end()) {
+        //tx file is up to date
+        return doc;
+    }
+
+    char journalFn [MO_MAX_PATH_SIZE];
+    if (!printJournalFn(journalFn, sizeof(journalFn))) {
+        return nullptr;
+    }
+
+    auto file = filesystem->open(journalFn, "r");
+    if (!file) {
+        MO_DBG_ERR("cannot open %s", journalFn);
+        return nullptr;
+    }
+
+    auto state = makeJsonDoc(getMemoryTag(), MO_TX_JOURNAL_STATE_SIZE);
+    state->set(*doc);
+
+    //the JsonDoc doesn't free overwritten fields. Copy the state into a new one if it runs full
+    auto compactState = [this, &state] () {
+        if (state->memoryUsage() > MO_TX_JOURNAL_STATE_SIZE / 2) {
+            auto compacted = makeJsonDoc(getMemoryTag(), MO_TX_JOURNAL_STATE_SIZE);
+            compacted->set(*state);
+            state = std::move(compacted);
+        }
+    };
+
+    auto line = makeString(getMemoryTag());
+    while (readRecord(*file, line) > 0) {
+        unsigned int recTxNr;
+        bool rm;
+        if (!parseRecordHeader(line.c_str(), recTxNr, rm) || recTxNr != txNr) {
+            continue;
+        }
+
+        if (rm) {
+            //the records so far belong to a previous tx with the same txNr
+            state = makeJsonDoc(getMemoryTag(), MO_TX_JOURNAL_STATE_SIZE);
+            state->set(*doc);
+            continue;
+        }
+
+        auto record = makeJsonDoc(getMemoryTag(), measureJsonCapacity(line.c_str(), line.length()));
+        auto err = deserializeJson(*record, line.c_str(), line.length());
+        if (err || !(*record)["d"].is<JsonObject>()) {
+            MO_DBG_ERR("record deserialization error: %s", err.c_str());
+            return nullptr;
+        }
+
+        compactState();
+        mergeJson(state->as<JsonObject>(), (*record)["d"].as<JsonObject>());
+
+        if (state->overflowed()) {
+            MO_DBG_ERR("JSON capacity exceeded");
+            return nullptr;
+        }
+    }
+
+    return state;
+#else
+    return doc;
+#endif //MO_ENABLE_TX_JOURNAL
+}
+
 std::shared_ptr<Transaction> ConnectorTransactionStore::getTransaction(unsigned int txNr) {
 
     //check for most recent element of cache first because of temporal locality
@@ -56,23 +257,8 @@ std::shared_ptr<Transaction> ConnectorTransactionStore::getTransaction(unsigned
         return nullptr;
     }
 
-    char fn [MO_MAX_PATH_SIZE] = {'\0'};
-    auto ret = snprintf(fn, MO_MAX_PATH_SIZE, MO_FILENAME_PREFIX "tx" "-%u-%u.json", connectorId, txNr);
-    if (ret < 0 || ret >= MO_MAX_PATH_SIZE) {
-        MO_DBG_ERR("fn error: %i", ret);
-        return nullptr;
-    }
-
-    size_t msize;
-    if (filesystem->stat(fn, &msize) != 0) {
-        MO_DBG_DEBUG("%u-%u does not exist", connectorId, txNr);
-        return nullptr;
-    }
-
-    auto doc = FilesystemUtils::loadJson(filesystem, fn, getMemoryTag());
-
+    auto doc = loadTransactionJson(txNr);
     if (!doc) {
-        MO_DBG_ERR("memory corruption");
         return nullptr;
     }
 
@@ -95,6 +281,14 @@ std::shared_ptr<Transaction> ConnectorTransactionStore::getTransaction(unsigned
     }
 
     transactions.push_back(transaction);
+
+#if MO_ENABLE_TX_JOURNAL
+    auto state = makeString(getMemoryTag());
+    serializeJson(*doc, state);
+    setCommittedState(txNr, std::move(state));
+    cleanCommittedStates();
+#endif
+
     return transaction;
 }
 
@@ -102,6 +296,18 @@ std::shared_ptr<Transaction> ConnectorTransactionStore::createTransaction(unsign
 
     auto transaction = std::allocate_shared<Transaction>(makeAllocator<Transaction>(getMemoryTag()), *this, connectorId, txNr, silent);
 
+#if MO_ENABLE_TX_JOURNAL
+    //a previous tx with this txNr could have left its state
+    auto prev = committed.begin();
+    while (prev != committed.end()) {
+        if (prev->txNr == txNr) {
+            prev = committed.erase(prev);
+        } else {
+            prev++;
+        }
+    }
+#endif
+
     if (!commit(transaction.get())) {
         MO_DBG_ERR("FS error");
         return nullptr;
@@ -119,6 +325,11 @@ std::shared_ptr<Transaction> ConnectorTransactionStore::createTransaction(unsign
     }
 
     transactions.push_back(transaction);
+
+#if MO_ENABLE_TX_JOURNAL
+    cleanCommittedStates();
+#endif
+
     return transaction;
 }
 
@@ -130,9 +341,7 @@ bool ConnectorTransactionStore::commit(Transaction *transaction) {
     }
 
     char fn [MO_MAX_PATH_SIZE] = {'\0'};
-    auto ret = snprintf(fn, MO_MAX_PATH_SIZE, MO_FILENAME_PREFIX "tx" "-%u-%u.json", connectorId, transaction->getTxNr());
-    if (ret < 0 || ret >= MO_MAX_PATH_SIZE) {
-        MO_DBG_ERR("fn error: %i", ret);
+    if (!printTxFn(fn, sizeof(fn), transaction->getTxNr())) {
         return false;
     }
     
@@ -142,11 +351,81 @@ bool ConnectorTransactionStore::commit(Transaction *transaction) {
         return false;
     }
 
+#if MO_ENABLE_TX_JOURNAL
+    loadJournal();
+
+    auto txNr = transaction->getTxNr();
+
+    auto base = getCommittedState(txNr);
+
+    size_t msize;
+    if (base && filesystem->stat(fn, &msize) != 0) {
+        //the tx file has been removed behind the store (e.g. ClearCache). The records need a base
+        MO_DBG_WARN("%s has been removed. Write full state", fn);
+        base = nullptr;
+    }
+
+    if (base) {
+        //the tx exists on flash. Only record the changes
+        auto baseDoc = initJsonDoc(getMemoryTag(), measureJsonCapacity(base->c_str(), base->length()));
+        auto err = deserializeJson(baseDoc, base->c_str(), base->length());
+        if (err) {
+            MO_DBG_ERR("state deserialization error: %s", err.c_str());
+            return false;
+        }
+
+        auto record = initJsonDoc(getMemoryTag(), txDoc.capacity());
+        JsonObject delta = record.to<JsonObject>();
+        diffJson(baseDoc.as<JsonObject>(), txDoc.as<JsonObject>(), delta);
+
+        if (delta.size() == 0) {
+            //nothing changed
+            return true;
+        }
+
+        char header [32];
+        snprintf(header, sizeof(header), "{\"txNr\":%u,\"d\":", txNr);
+        auto line = makeString(getMemoryTag(), header);
+        serializeJson(delta, line);
+        line += "}\n";
+
+        if (appendJournal(line.c_str(), line.length())) {
+            if (std::find(journalTxNrs.begin(), journalTxNrs.end(), txNr) == journalTxNrs.end()) {
+                journalTxNrs.push_back(txNr);
+            }
+
+            base->clear();
+            serializeJson(txDoc, *base);
+
+            if (journalRecords >= MO_TX_JOURNAL_MAXRECORDS) {
+                compactJournal(); //if this fails, the records stay valid
+            }
+            return true;
+        }
+
+        //fall back to writing the full state
+    }
+
+    if (std::find(journalTxNrs.begin(), journalTxNrs.end(), txNr) != journalTxNrs.end()) {
+        //the full state replaces all records so far. Move them into the tx file first, so that the tx file and the
+        //records stay valid until the full state is written
+        if (!compactJournal()) {
+            return false;
+        }
+    }
+#endif //MO_ENABLE_TX_JOURNAL
+
     if (!FilesystemUtils::storeJson(filesystem, fn, txDoc)) {
         MO_DBG_ERR("FS error");
         return false;
     }
 
+#if MO_ENABLE_TX_JOURNAL
+    auto state = makeString(getMemoryTag());
+    serializeJson(txDoc, state);
+    setCommittedState(txNr, std::move(state));
+#endif
+
     //success
     return true;
 }
@@ -159,12 +438,23 @@ bool ConnectorTransactionStore::remove(unsigned int txNr) {
     }
 
     char fn [MO_MAX_PATH_SIZE] = {'\0'};
-    auto ret = snprintf(fn, MO_MAX_PATH_SIZE, MO_FILENAME_PREFIX "tx" "-%u-%u.json", connectorId, txNr);
-    if (ret < 0 || ret >= MO_MAX_PATH_SIZE) {
-        MO_DBG_ERR("fn error: %i", ret);
+    if (!printTxFn(fn, sizeof(fn), txNr)) {
         return false;
     }
 
+#if MO_ENABLE_TX_JOURNAL
+    loadJournal();
+
+    auto state = committed.begin();
+    while (state != committed.end()) {
+        if (state->txNr == txNr) {
+            state = committed.erase(state);
+        } else {
+            state++;
+        }
+    }
+#endif
+
     size_t msize;
     if (filesystem->stat(fn, &msize) != 0) {
         MO_DBG_DEBUG("%s already removed", fn);
@@ -172,10 +462,209 @@ bool ConnectorTransactionStore::remove(unsigned int txNr) {
     }
 
     MO_DBG_DEBUG("remove %s", fn);
-    
-    return filesystem->remove(fn);
+
+    if (!filesystem->remove(fn)) {
+        return false;
+    }
+
+#if MO_ENABLE_TX_JOURNAL
+    auto journaled = std::find(journalTxNrs.begin(), journalTxNrs.end(), txNr);
+    if (journaled != journalTxNrs.end()) {
+        //discard the records of this tx. If this fails, the next compaction will skip them
+        char line [32];
+        snprintf(line, sizeof(line), "{\"txNr\":%u,\"rm\":true}\n", txNr);
+        if (appendJournal(line, strlen(line))) {
+            journalTxNrs.erase(journaled);
+        }
+    }
+#endif
+
+    return true;
+}
+
+#if MO_ENABLE_TX_JOURNAL
+
+bool ConnectorTransactionStore::printJournalFn(char *fn, size_t size) {
+    auto ret = snprintf(fn, size, MO_FILENAME_PREFIX MO_TX_JOURNAL_FN_PREFIX "%u.jsn", connectorId);
+    if (ret < 0 || (size_t) ret >= size) {
+        MO_DBG_ERR("fn error: %i", ret);
+        return false;
+    }
+    return true;
+}
+
+void ConnectorTransactionStore::loadJournal() {
+    if (journalLoaded) {
+        return;
+    }
+    journalLoaded = true;
+
+    char fn [MO_MAX_PATH_SIZE];
+    if (!printJournalFn(fn, sizeof(fn))) {
+        return;
+    }
+
+    size_t msize;
+    if (filesystem->stat(fn, &msize) != 0) {
+        //no journal
+        return;
+    }
+
+    auto file = filesystem->open(fn, "r");
+    if (!file) {
+        MO_DBG_ERR("cannot open %s", fn);
+        return;
+    }
+
+    auto line = makeString(getMemoryTag());
+    int ret;
+    while ((ret = readRecord(*file, line)) > 0) {
+        journalRecords++;
+
+        unsigned int txNr;
+        bool rm;
+        if (!parseRecordHeader(line.c_str(), txNr, rm)) {
+            MO_DBG_ERR("invalid record");
+            continue;
+        }
+
+        auto journaled = std::find(journalTxNrs.begin(), journalTxNrs.end(), txNr);
+        if (rm && journaled != journalTxNrs.end()) {
+            journalTxNrs.erase(journaled);
+        } else if (!rm && journaled == journalTxNrs.end()) {
+            journalTxNrs.push_back(txNr);
+        }
+    }
+
+    file.reset();
+
+    MO_DBG_DEBUG("journal of connector %u: %zu records", connectorId, journalRecords);
+
+    if (ret < 0) {
+        //a write has been interrupted. Further records would be appended to the incomplete one
+        MO_DBG_WARN("incomplete record in %s. Compact journal", fn);
+        compactJournal();
+    }
 }
 
+bool ConnectorTransactionStore::appendJournal(const char *record, size_t len) {
+    char fn [MO_MAX_PATH_SIZE];
+    if (!printJournalFn(fn, sizeof(fn))) {
+        return false;
+    }
+
+    bool success = false;
+    if (auto file = filesystem->open(fn, "a")) {
+        success = file->write(record, len) == len;
+    }
+
+    if (!success) {
+        MO_DBG_ERR("cannot write %s", fn);
+        return false;
+    }
+
+    journalRecords++;
+    return true;
+}
+
+bool ConnectorTransactionStore::compactJournal() {
+
+    char journalFn [MO_MAX_PATH_SIZE];
+    if (!printJournalFn(journalFn, sizeof(journalFn))) {
+        return false;
+    }
+
+    size_t msize;
+    if (filesystem->stat(journalFn, &msize) != 0) {
+        //the records have been removed behind the store (e.g. ClearCache)
+        journalRecords = 0;
+        journalTxNrs.clear();
+        return true;
+    }
+
+    //write the current states into the tx files, then drop the journal
+    for (auto txNr : journalTxNrs) {
+        char fn [MO_MAX_PATH_SIZE];
+        if (!printTxFn(fn, sizeof(fn), txNr)) {
+            return false;
+        }
+
+        std::unique_ptr<JsonDoc> doc;
+        if (auto state = getCommittedState(txNr)) {
+            doc = makeJsonDoc(getMemoryTag(), measureJsonCapacity(state->c_str(), state->length()));
+            auto err = deserializeJson(*doc, state->c_str(), state->length());
+            if (err) {
+                MO_DBG_ERR("state deserialization error: %s", err.c_str());
+                return false;
+            }
+        } else {
+            doc = loadTransactionJson(txNr);
+            if (!doc) {
+                if (filesystem->stat(fn, &msize) != 0) {
+                    //tx file has been removed before its "rm" record was written
+                    continue;
+                }
+                MO_DBG_ERR("cannot replay %u-%u. Keep journal", connectorId, txNr);
+                return false;
+            }
+        }
+
+        if (!FilesystemUtils::storeJson(filesystem, fn, *doc)) {
+            MO_DBG_ERR("FS error");
+            return false;
+        }
+    }
+
+    MO_DBG_DEBUG("compact journal of connector %u: %zu records", connectorId, journalRecords);
+
+    if (!filesystem->remove(journalFn)) {
+        MO_DBG_ERR("cannot remove %s", journalFn);
+        return false;
+    }
+
+    journalRecords = 0;
+    journalTxNrs.clear();
+    return true;
+}
+
+String *ConnectorTransactionStore::getCommittedState(unsigned int txNr) {
+    for (auto& entry : committed) {
+        if (entry.txNr == txNr) {
+            return &entry.state;
+        }
+    }
+    return nullptr;
+}
+
+void ConnectorTransactionStore::setCommittedState(unsigned int txNr, String&& state) {
+    if (auto entry = getCommittedState(txNr)) {
+        *entry = std::move(state);
+    } else {
+        committed.push_back(CommittedState{txNr, std::move(state)});
+    }
+}
+
+void ConnectorTransactionStore::cleanCommittedStates() {
+    auto entry = committed.begin();
+    while (entry != committed.end()) {
+        bool isCached = false;
+        for (auto& cached : transactions) {
+            auto tx = cached.lock();
+            if (tx && tx->getTxNr() == entry->txNr) {
+                isCached = true;
+                break;
+            }
+        }
+        if (isCached) {
+            entry++;
+        } else {
+            entry = committed.erase(entry);
+        }
+    }
+}
+
+#endif //MO_ENABLE_TX_JOURNAL
+
 TransactionStore::TransactionStore(unsigned int nConnectors, std::shared_ptr<FilesystemAdapter> filesystem) :
         MemoryManaged{"v16.Transactions.TransactionStore"}, connectors{makeVector<std::unique_ptr<ConnectorTransactionStore>>(getMemoryTag())} {
 
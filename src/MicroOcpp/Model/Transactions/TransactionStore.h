@@ -10,10 +10,44 @@
 #include <MicroOcpp/Core/FilesystemAdapter.h>
 #include <MicroOcpp/Core/Memory.h>
 
+#ifndef MO_ENABLE_TX_JOURNAL
+#define MO_ENABLE_TX_JOURNAL 1
+#endif
+
+#if MO_ENABLE_TX_JOURNAL
+
+//number of records in the journal of a connector after which the journal is compacted into the tx files
+#ifndef MO_TX_JOURNAL_MAXRECORDS
+#define MO_TX_JOURNAL_MAXRECORDS 50
+#endif
+
+#define MO_TX_JOURNAL_FN_PREFIX "txj-"
+
+#endif //MO_ENABLE_TX_JOURNAL
+
 namespace MicroOcpp {
 
 class TransactionStore;
 
+/*
+ * Stores the transactions of a connector in the files tx-<connectorId>-<txNr>.json.
+ *
+ * With MO_ENABLE_TX_JOURNAL, commit() doesn't rewrite the tx file, but appends a record with the changed fields
+ * since the previous commit to the journal txj-<connectorId>.jsn:
+ *
+ *     {"txNr":5,"d":{"start":{"requested":true,"opNr":12}}}\n
+ *     {"txNr":5,"d":{"start":{"confirmed":true,"transactionId":1234}}}\n
+ *
+ * A field which is omitted in the new state is recorded as null. remove() records the end of a tx:
+ *
+ *     {"txNr":5,"rm":true}\n
+ *
+ * When loading a tx, the records which follow its last "rm" record are applied on the tx file. When the journal
+ * exceeds MO_TX_JOURNAL_MAXRECORDS, the current states are written into the tx files and the journal starts over.
+ * The records contain the absolute values of the changed fields, so that replaying a record on a tx file which
+ * already contains it has no effect. An interrupted compaction is safe to repeat. If commit() writes the full state of
+ * a tx which has records, e.g. because the tx file has been removed externally, it compacts the journal first
+ */
 class ConnectorTransactionStore : public MemoryManaged {
 private:
     TransactionStore& context;
@@ -23,6 +57,31 @@ private:
     
     Vector<std::weak_ptr<Transaction>> transactions;
 
+    bool printTxFn(char *fn, size_t size, unsigned int txNr);
+
+    std::unique_ptr<JsonDoc> loadTransactionJson(unsigned int txNr); //nullptr if not existent
+
+#if MO_ENABLE_TX_JOURNAL
+    struct CommittedState {
+        unsigned int txNr;
+        String state; //serialized state as on the flash, base of the next record
+    };
+    Vector<CommittedState> committed; //one entry per cached tx
+
+    bool journalLoaded = false;
+    size_t journalRecords = 0;
+    Vector<unsigned int> journalTxNrs; //txs with records after their last "rm" record
+
+    bool printJournalFn(char *fn, size_t size);
+    void loadJournal(); //index the records on the flash
+    bool appendJournal(const char *record, size_t len);
+    bool compactJournal();
+
+    String *getCommittedState(unsigned int txNr);
+    void setCommittedState(unsigned int txNr, String&& state);
+    void cleanCommittedStates(); //drop the states of txs which aren't in the cache anymore
+#endif //MO_ENABLE_TX_JOURNAL
+
 public:
     ConnectorTransactionStore(TransactionStore& context, unsigned int connectorId, std::shared_ptr<FilesystemAdapter> filesystem);
     ConnectorTransactionStore(const ConnectorTransactionStore&) = delete;
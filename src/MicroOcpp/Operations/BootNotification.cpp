@@ -106,16 +106,14 @@ std::unique_ptr<JsonDoc> BootNotification::createConf(){
 
     //safety mechanism; in some test setups the library has to answer BootNotifications without valid system time
     Timestamp ocppTimeReference = Timestamp(2022,0,27,11,59,55); 
-    Timestamp ocppSelect = ocppTimeReference;
     auto& ocppTime = model.getClock();
-    Timestamp ocppNow = ocppTime.now();
-    if (ocppNow > ocppTimeReference) {
+    char ocppNowJson [JSONDATE_LENGTH + 1] = {'\0'};
+    if (ocppTime.now() > ocppTimeReference) {
         //time has already been set
-        ocppSelect = ocppNow;
+        ocppTime.nowJsonString(ocppNowJson, JSONDATE_LENGTH + 1);
+    } else {
+        ocppTimeReference.toJsonString(ocppNowJson, JSONDATE_LENGTH + 1);
     }
-
-    char ocppNowJson [JSONDATE_LENGTH + 1] = {'\0'};
-    ocppSelect.toJsonString(ocppNowJson, JSONDATE_LENGTH + 1);
     payload["currentTime"] = ocppNowJson;
 
     payload["interval"] = 86400; //heartbeat send interval - not relevant for JSON variant of OCPP so send dummy value that likely won't break
@@ -10,6 +10,8 @@
 using MicroOcpp::Ocpp16::Heartbeat;
 using MicroOcpp::JsonDoc;
 
+MO_OBJECT_POOL_DEFINE(Heartbeat)
+
 Heartbeat::Heartbeat(Model& model) : MemoryManaged("v16.Operation.", "Heartbeat"), model(model) {
   
 }
@@ -51,15 +53,13 @@ std::unique_ptr<JsonDoc> Heartbeat::createConf(){
 
     //safety mechanism; in some test setups the library could have to answer Heartbeats without valid system time
     Timestamp ocppTimeReference = Timestamp(2019,10,0,11,59,55); 
-    Timestamp ocppSelect = ocppTimeReference;
-    auto& ocppNow = model.getClock().now();
-    if (ocppNow > ocppTimeReference) {
+    char ocppNowJson [JSONDATE_LENGTH + 1] = {'\0'};
+    if (model.getClock().now() > ocppTimeReference) {
         //time has already been set
-        ocppSelect = ocppNow;
+        model.getClock().nowJsonString(ocppNowJson, JSONDATE_LENGTH + 1);
+    } else {
+        ocppTimeReference.toJsonString(ocppNowJson, JSONDATE_LENGTH + 1);
     }
-
-    char ocppNowJson [JSONDATE_LENGTH + 1] = {'\0'};
-    ocppSelect.toJsonString(ocppNowJson, JSONDATE_LENGTH + 1);
     payload["currentTime"] = ocppNowJson;
 
     return doc;
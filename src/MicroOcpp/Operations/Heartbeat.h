@@ -6,6 +6,7 @@
 #define MO_HEARTBEAT_H
 
 #include <MicroOcpp/Core/Operation.h>
+#include <MicroOcpp/Core/ObjectPool.h>
 
 namespace MicroOcpp {
 
@@ -19,6 +20,9 @@ private:
 public:
     Heartbeat(Model& model);
 
+    static void *operator new(size_t size);
+    static void operator delete(void *ptr, size_t size);
+
     const char* getOperationType() override;
 
     std::unique_ptr<JsonDoc> createReq() override;
@@ -10,12 +10,15 @@
 
 using MicroOcpp::Ocpp16::MeterValues;
 using MicroOcpp::JsonDoc;
+using MicroOcpp::CoalescingKey;
 
 //can only be used for echo server debugging
 MeterValues::MeterValues(Model& model) : MemoryManaged("v16.Operation.", "MeterValues"), model(model) {
     
 }
 
+MO_OBJECT_POOL_DEFINE(MeterValues)
+
 MeterValues::MeterValues(Model& model, MeterValue *meterValue, unsigned int connectorId, std::shared_ptr<Transaction> transaction) 
       : MemoryManaged("v16.Operation.", "MeterValues"), model(model), meterValue{meterValue}, connectorId{connectorId}, transaction{transaction} {
     
@@ -91,3 +94,10 @@ void MeterValues::processReq(JsonObject payload) {
 std::unique_ptr<JsonDoc> MeterValues::createConf(){
     return createEmptyDocument();
 }
+
+CoalescingKey MeterValues::getCoalescingKey() {
+    if (!meterValueOwnership) {
+        return CoalescingKey(); //tx meter data, owned by the MeteringConnector
+    }
+    return CoalescingKey(CoalescingKey::Type::MeterValues, (int) connectorId);
+}
@@ -6,6 +6,7 @@
 #define MO_METERVALUES_H
 
 #include <MicroOcpp/Core/Operation.h>
+#include <MicroOcpp/Core/ObjectPool.h>
 #include <MicroOcpp/Core/Memory.h>
 #include <MicroOcpp/Core/Time.h>
 
@@ -35,6 +36,9 @@ public:
 
     ~MeterValues();
 
+    static void *operator new(size_t size);
+    static void operator delete(void *ptr, size_t size);
+
     const char* getOperationType() override;
 
     std::unique_ptr<JsonDoc> createReq() override;
@@ -44,6 +48,8 @@ public:
     void processReq(JsonObject payload) override;
 
     std::unique_ptr<JsonDoc> createConf() override;
+
+    CoalescingKey getCoalescingKey() override; //triggered MeterValues (owned meterValue) of connectorId. Tx meter data is never coalesced
 };
 
 } //end namespace Ocpp16
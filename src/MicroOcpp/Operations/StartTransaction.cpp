@@ -52,7 +52,7 @@ std::unique_ptr<JsonDoc> StartTransaction::createReq() {
     }
 
     char timestamp[JSONDATE_LENGTH + 1] = {'\0'};
-    transaction->getStartTimestamp().toJsonString(timestamp, JSONDATE_LENGTH + 1);
+    model.getClock().toJsonString(transaction->getStartTimestamp(), timestamp, JSONDATE_LENGTH + 1);
     payload["timestamp"] = timestamp;
 
     return doc;
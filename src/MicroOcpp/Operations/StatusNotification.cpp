@@ -45,6 +45,8 @@ const char *cstrFromOcppEveState(ChargePointStatus state) {
 
 namespace Ocpp16 {
 
+MO_OBJECT_POOL_DEFINE(StatusNotification)
+
 StatusNotification::StatusNotification(int connectorId, ChargePointStatus currentStatus, const Timestamp &timestamp, ErrorData errorData)
         : MemoryManaged("v16.Operation.", "StatusNotification"), connectorId(connectorId), currentStatus(currentStatus), timestamp(timestamp), errorData(errorData) {
     
@@ -111,6 +113,13 @@ std::unique_ptr<JsonDoc> StatusNotification::createConf(){
     return createEmptyDocument();
 }
 
+CoalescingKey StatusNotification::getCoalescingKey() {
+    if (errorData.isError) {
+        return CoalescingKey(); //keep error reports
+    }
+    return CoalescingKey(CoalescingKey::Type::StatusNotification, connectorId);
+}
+
 } // namespace Ocpp16
 } // namespace MicroOcpp
 
@@ -149,6 +158,10 @@ void StatusNotification::processConf(JsonObject payload) {
     */
 }
 
+CoalescingKey StatusNotification::getCoalescingKey() {
+    return CoalescingKey(CoalescingKey::Type::StatusNotification, evseId.id, evseId.connectorId);
+}
+
 } // namespace Ocpp201
 } // namespace MicroOcpp
 
@@ -6,6 +6,7 @@
 #define STATUSNOTIFICATION_H
 
 #include <MicroOcpp/Core/Operation.h>
+#include <MicroOcpp/Core/ObjectPool.h>
 #include <MicroOcpp/Core/Time.h>
 #include <MicroOcpp/Model/ConnectorBase/ChargePointStatus.h>
 #include <MicroOcpp/Model/ConnectorBase/ChargePointErrorData.h>
@@ -26,6 +27,9 @@ private:
 public:
     StatusNotification(int connectorId, ChargePointStatus currentStatus, const Timestamp &timestamp, ErrorData errorData = nullptr);
 
+    static void *operator new(size_t size);
+    static void operator delete(void *ptr, size_t size);
+
     const char* getOperationType() override;
 
     std::unique_ptr<JsonDoc> createReq() override;
@@ -39,6 +43,8 @@ public:
     int getConnectorId() {
         return connectorId;
     }
+
+    CoalescingKey getCoalescingKey() override; //status of connectorId. Error reports are not coalesced
 };
 
 } // namespace Ocpp16
@@ -64,6 +70,8 @@ public:
     std::unique_ptr<JsonDoc> createReq() override;
 
     void processConf(JsonObject payload) override;
+
+    CoalescingKey getCoalescingKey() override; //status of evseId and connectorId
 };
 
 } // namespace Ocpp201
@@ -99,7 +99,7 @@ std::unique_ptr<JsonDoc> StopTransaction::createReq() {
     payload["meterStop"] = transaction->getMeterStop();
 
     char timestamp[JSONDATE_LENGTH + 1] = {'\0'};
-    transaction->getStopTimestamp().toJsonString(timestamp, JSONDATE_LENGTH + 1);
+    model.getClock().toJsonString(transaction->getStopTimestamp(), timestamp, JSONDATE_LENGTH + 1);
     payload["timestamp"] = timestamp;
 
     payload["transactionId"] = transaction->getTransactionId();
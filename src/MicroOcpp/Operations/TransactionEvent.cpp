@@ -54,7 +54,7 @@ std::unique_ptr<JsonDoc> TransactionEvent::createReq() {
     payload["eventType"] = serializeTransactionEventType(txEvent->eventType);
 
     char timestamp [JSONDATE_LENGTH + 1];
-    txEvent->timestamp.toJsonString(timestamp, JSONDATE_LENGTH + 1);
+    model.getClock().toJsonString(txEvent->timestamp, timestamp, JSONDATE_LENGTH + 1);
     payload["timestamp"] = timestamp;
 
     if (serializeTransactionEventTriggerReason(txEvent->triggerReason)) {
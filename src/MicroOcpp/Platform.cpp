@@ -104,7 +104,7 @@ uint32_t mocpp_rng_custom(void) {
 // each time it is called. Then this is passed through a multiply-with-carry
 // PRNG operation to get a pseudo-random number.
 uint32_t mocpp_time_based_prng(void) {
-    static uint32_t prng_state = 1;
+    static MO_THREAD_LOCAL uint32_t prng_state = 1;
     uint32_t entropy = mocpp_tick_ms();
     prng_state = (prng_state ^ entropy)*1664525U + 1013904223U; // assuming complement-2 integers and non-signaling overflow
     return prng_state;
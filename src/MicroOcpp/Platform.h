@@ -116,4 +116,15 @@ MO_EXTERN_C uint32_t mocpp_time_based_prng(void);
 #define MO_ENABLE_MBEDTLS 0
 #endif
 
+// run multiple MO instances in one process and loop them from different threads (see mocpp_select_instance())
+#ifndef MO_ENABLE_MULTI_INSTANCE
+#define MO_ENABLE_MULTI_INSTANCE 0
+#endif
+
+#if MO_ENABLE_MULTI_INSTANCE
+#define MO_THREAD_LOCAL thread_local
+#else
+#define MO_THREAD_LOCAL
+#endif
+
 #endif
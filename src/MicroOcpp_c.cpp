@@ -59,10 +59,34 @@ bool ocpp_is_initialized() {
     return getOcppContext() != nullptr;
 }
 
+OCPP_Instance *ocpp_get_instance() {
+    return reinterpret_cast<OCPP_Instance*>(getOcppContext());
+}
+
+void ocpp_select_instance(OCPP_Instance *instance) {
+    mocpp_select_instance(reinterpret_cast<MicroOcpp::Context*>(instance));
+}
+
 void ocpp_loop() {
     mocpp_loop();
 }
 
+unsigned long ocpp_loop_next_deadline_ms() {
+    return mocpp_loop_next_deadline_ms();
+}
+
+#if MO_ENABLE_COMMAND_QUEUE
+bool ocpp_post(void (*command)(void *user_data), void *user_data) {
+    if (!command) {
+        MO_DBG_ERR("invalid arg");
+        return false;
+    }
+    return mocpp_post([command, user_data] () {
+        command(user_data);
+    });
+}
+#endif
+
 /*
  * Helper functions for transforming callback functions from C-style to C++style
  */
@@ -23,6 +23,9 @@ typedef struct MeterValueInput MeterValueInput;
 struct FilesystemAdapterC;
 typedef struct FilesystemAdapterC FilesystemAdapterC;
 
+struct OCPP_Instance;
+typedef struct OCPP_Instance OCPP_Instance;
+
 typedef void (*OnMessage) (const char *payload, size_t len);
 typedef void (*OnAbort)   ();
 typedef void (*OnTimeout) ();
@@ -87,8 +90,18 @@ void ocpp_deinitialize();
 
 bool ocpp_is_initialized();
 
+//Multiple instances: see mocpp_select_instance()
+OCPP_Instance *ocpp_get_instance();
+void ocpp_select_instance(OCPP_Instance *instance);
+
 void ocpp_loop();
 
+unsigned long ocpp_loop_next_deadline_ms(); //see mocpp_loop_next_deadline_ms()
+
+#if MO_ENABLE_COMMAND_QUEUE
+bool ocpp_post(void (*command)(void *user_data), void *user_data); //thread-safe, see mocpp_post()
+#endif
+
 /*
  * Charging session management
  */
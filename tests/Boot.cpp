@@ -227,6 +227,77 @@ TEST_CASE( "Boot Behavior" ) {
         REQUIRE( checkProcessedHeartbeat );
     }
 
+    SECTION("BootNotification retry and Heartbeat timers") {
+
+        unsigned int nBootNotifications = 0;
+        bool accept = false;
+
+        getOcppContext()->getOperationRegistry().registerOperation("BootNotification",
+            [&nBootNotifications, &accept] () {
+                return new Ocpp16::CustomOperation("BootNotification",
+                    [&nBootNotifications] (JsonObject) {
+                        //process req
+                        nBootNotifications++;
+                    },
+                    [&accept] () {
+                        //create conf
+                        auto conf = makeJsonDoc(UNIT_MEM_TAG, 1024);
+                        (*conf)["currentTime"] = BASE_TIME;
+                        (*conf)["interval"] = 60;
+                        (*conf)["status"] = accept ? "Accepted" : "Pending";
+                        return conf;
+                    });
+            });
+
+        unsigned int nHeartbeats = 0;
+
+        getOcppContext()->getOperationRegistry().setOnRequest("Heartbeat",
+            [&nHeartbeats] (JsonObject) {
+                nHeartbeats++;
+            });
+
+        loop();
+        REQUIRE( nBootNotifications == 1 );
+
+        //retry after the interval of the Pending response
+        mtime += 50000;
+        mocpp_loop();
+        REQUIRE( nBootNotifications == 1 );
+
+        mtime += 10000;
+        loop();
+        REQUIRE( nBootNotifications == 2 );
+
+        //the Accepted response sets the HeartbeatInterval and the Heartbeat is overdue since startup
+        accept = true;
+        mtime += 60000;
+        loop();
+        REQUIRE( nBootNotifications == 3 );
+        REQUIRE( isOperative() );
+        REQUIRE( nHeartbeats == 1 );
+
+        mtime += 55000;
+        mocpp_loop();
+        REQUIRE( nHeartbeats == 1 );
+
+        mtime += 5000;
+        loop();
+        REQUIRE( nHeartbeats == 2 );
+
+        //a new HeartbeatInterval re-arms the Timer with the next loop
+        declareConfiguration<int>("HeartbeatInterval", 86400)->setInt(120);
+        mocpp_loop();
+
+        mtime += 60000;
+        loop();
+        REQUIRE( nHeartbeats == 2 );
+
+        mtime += 60000;
+        loop();
+        REQUIRE( nHeartbeats == 3 );
+        REQUIRE( nBootNotifications == 3 );
+    }
+
     SECTION("PreBoot transactions") {
         declareConfiguration<bool>(MO_CONFIG_EXT_PREFIX "PreBootTransactions", true)->setBool(true);
         declareConfiguration<bool>("AllowOfflineTxForUnknownId", true)->setBool(true);
@@ -0,0 +1,117 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#include <MicroOcpp.h>
+#include <MicroOcpp/Core/Connection.h>
+#include <MicroOcpp/Core/Context.h>
+#include <MicroOcpp/Core/CommandQueue.h>
+#include <MicroOcpp/Debug.h>
+#include <catch2/catch.hpp>
+#include "./helpers/testHelper.h"
+
+#include <array>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+TEST_CASE( "Thread-safe command ingress" ) {
+    printf("\nRun %s\n",  "Thread-safe command ingress");
+
+    //initialize Context with dummy socket
+    MicroOcpp::LoopbackConnection loopback;
+    mocpp_initialize(loopback, ChargerCredentials("test-runner1234"));
+
+    auto context = getOcppContext();
+
+    mocpp_set_timer(custom_timer_cb);
+
+    loop();
+
+    SECTION("Post from multiple threads") {
+
+        const unsigned int nCommands = 1000;
+
+        std::array<unsigned int, 4> executed {0}; //only accessed by loop thread until join
+        bool inOrder = true;
+        std::atomic<unsigned int> producersDone {0};
+
+        std::vector<std::thread> producers;
+        for (unsigned int p = 0; p < executed.size(); p++) {
+            producers.emplace_back([context, p, &executed, &inOrder, &producersDone] () {
+                mocpp_select_instance(context);
+                for (unsigned int i = 0; i < nCommands; i++) {
+                    while (!mocpp_post([p, i, &executed, &inOrder] () {
+                                if (executed[p] != i) {
+                                    inOrder = false;
+                                }
+                                executed[p]++;
+                            })) {
+                        std::this_thread::yield(); //queue full
+                    }
+                }
+                producersDone++;
+            });
+        }
+
+        while (producersDone < executed.size() || !context->getCommandQueue().isEmpty()) {
+            mocpp_loop();
+        }
+
+        for (auto& producer : producers) {
+            producer.join();
+        }
+
+        for (auto count : executed) {
+            REQUIRE( count == nCommands );
+        }
+        REQUIRE( inOrder );
+    }
+
+    SECTION("Completion callback") {
+
+        bool called = false;
+        bool result = false;
+
+        std::thread producer ([context, &called, &result] () {
+            mocpp_select_instance(context);
+            mocpp_post<bool>([] () {
+                    return beginTransaction("mIdTag");
+                }, [&called, &result] (bool success) {
+                    called = true;
+                    result = success;
+                });
+        });
+        producer.join();
+
+        REQUIRE( !called );
+        REQUIRE( mocpp_loop_next_deadline_ms() == 0 );
+
+        mocpp_loop();
+        REQUIRE( called );
+        REQUIRE( result );
+        REQUIRE( isTransactionActive() );
+
+        endTransaction();
+        loop();
+    }
+
+    SECTION("Bounded queue") {
+
+        unsigned int executed = 0;
+
+        for (unsigned int i = 0; i < MO_COMMAND_QUEUE_SIZE; i++) {
+            REQUIRE( mocpp_post([&executed] () {executed++;}) );
+        }
+        REQUIRE( !mocpp_post([&executed] () {executed++;}) );
+
+        mocpp_loop();
+        REQUIRE( executed == MO_COMMAND_QUEUE_SIZE );
+        REQUIRE( mocpp_post([&executed] () {executed++;}) );
+
+        mocpp_loop();
+        REQUIRE( executed == MO_COMMAND_QUEUE_SIZE + 1 );
+    }
+
+    mocpp_deinitialize();
+}
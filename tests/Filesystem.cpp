@@ -0,0 +1,206 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#include <MicroOcpp/Core/FilesystemAdapter.h>
+#include <MicroOcpp/Core/FilesystemUtils.h>
+#include <MicroOcpp/Debug.h>
+#include <catch2/catch.hpp>
+#include "./helpers/testHelper.h"
+
+#include <string>
+
+namespace {
+
+//filesystem without rename support, like SPIFFS
+class NoRenameFilesystem : public MicroOcpp::FilesystemAdapter {
+public:
+    std::shared_ptr<MicroOcpp::FilesystemAdapter> filesystem;
+    bool failWrites = false; //power loss before writing
+    NoRenameFilesystem(std::shared_ptr<MicroOcpp::FilesystemAdapter> filesystem) : filesystem(filesystem) { }
+    int stat(const char *path, size_t *size) override {return filesystem->stat(path, size);}
+    std::unique_ptr<MicroOcpp::FileAdapter> open(const char *path, const char *mode) override {
+        if (failWrites && strcmp(mode, "r")) {
+            return nullptr;
+        }
+        return filesystem->open(path, mode);
+    }
+    bool remove(const char *path) override {return filesystem->remove(path);}
+    int ftw_root(std::function<int(const char *fpath)> fn) override {return filesystem->ftw_root(fn);}
+};
+
+bool writeRaw(std::shared_ptr<MicroOcpp::FilesystemAdapter> filesystem, const char *fn, const char *content) {
+    auto file = filesystem->open(fn, "w");
+    return file && file->write(content, strlen(content)) == strlen(content);
+}
+
+} //end namespace
+
+TEST_CASE( "Atomic file replacement" ) {
+    printf("\nRun %s\n",  "Atomic file replacement");
+
+    auto filesystem = MicroOcpp::makeDefaultFilesystemAdapter(MicroOcpp::FilesystemOpt::Use_Mount_FormatOnFail);
+    MicroOcpp::FilesystemUtils::remove_if(filesystem, [] (const char*) {return true;});
+
+    const char *fn = MO_FILENAME_PREFIX "atomic.jsn";
+    const char *tmpFn = MO_FILENAME_PREFIX "~atomic.jsn";
+    size_t size;
+
+    auto doc = MicroOcpp::initJsonDoc("UnitTests", 256);
+    deserializeJson(doc, "{\"key\":\"old\"}");
+    REQUIRE( MicroOcpp::FilesystemUtils::storeJson(filesystem, fn, doc) );
+
+    SECTION("Replace without leftovers") {
+        doc["key"] = "new";
+        REQUIRE( MicroOcpp::FilesystemUtils::storeJson(filesystem, fn, doc) );
+        REQUIRE( filesystem->stat(tmpFn, &size) != 0 );
+
+        auto loaded = MicroOcpp::FilesystemUtils::loadJson(filesystem, fn, "UnitTests");
+        REQUIRE( loaded );
+        REQUIRE( !strcmp((*loaded)["key"] | "", "new") );
+    }
+
+    SECTION("Recover complete temporary file") {
+        //power loss after writing the temporary file
+        REQUIRE( writeRaw(filesystem, tmpFn, "{\"key\":\"new\"}") );
+
+        auto loaded = MicroOcpp::FilesystemUtils::loadJson(filesystem, fn, "UnitTests");
+        REQUIRE( loaded );
+        REQUIRE( !strcmp((*loaded)["key"] | "", "new") );
+        REQUIRE( filesystem->stat(tmpFn, &size) != 0 );
+
+        loaded = MicroOcpp::FilesystemUtils::loadJson(filesystem, fn, "UnitTests");
+        REQUIRE( !strcmp((*loaded)["key"] | "", "new") );
+    }
+
+    SECTION("Discard torn temporary file") {
+        //power loss while writing the temporary file
+        REQUIRE( writeRaw(filesystem, tmpFn, "{\"key\":\"ne") );
+
+        auto loaded = MicroOcpp::FilesystemUtils::loadJson(filesystem, fn, "UnitTests");
+        REQUIRE( loaded );
+        REQUIRE( !strcmp((*loaded)["key"] | "", "old") );
+        REQUIRE( filesystem->stat(tmpFn, &size) != 0 );
+    }
+
+    SECTION("Filesystem without rename") {
+        auto noRename = std::make_shared<NoRenameFilesystem>(filesystem);
+
+        doc["key"] = "new";
+        REQUIRE( MicroOcpp::FilesystemUtils::storeJson(noRename, fn, doc) );
+        REQUIRE( filesystem->stat(tmpFn, &size) != 0 );
+
+        //torn fn, the shadow copy is still there
+        REQUIRE( writeRaw(filesystem, tmpFn, "{\"key\":\"newer\"}") );
+        REQUIRE( writeRaw(filesystem, fn, "{\"key\":\"ne") );
+
+        //the recovery is interrupted, too. The shadow copy must survive it
+        noRename->failWrites = true;
+        auto loaded = MicroOcpp::FilesystemUtils::loadJson(noRename, fn, "UnitTests");
+        REQUIRE( loaded );
+        REQUIRE( !strcmp((*loaded)["key"] | "", "newer") );
+        REQUIRE( filesystem->stat(tmpFn, &size) == 0 );
+        auto shadow = MicroOcpp::FilesystemUtils::loadJson(filesystem, tmpFn, "UnitTests");
+        REQUIRE( shadow );
+        REQUIRE( !strcmp((*shadow)["key"] | "", "newer") );
+        noRename->failWrites = false;
+
+        loaded = MicroOcpp::FilesystemUtils::loadJson(noRename, fn, "UnitTests");
+        REQUIRE( loaded );
+        REQUIRE( !strcmp((*loaded)["key"] | "", "newer") );
+        REQUIRE( filesystem->stat(tmpFn, &size) != 0 );
+
+        loaded = MicroOcpp::FilesystemUtils::loadJson(noRename, fn, "UnitTests");
+        REQUIRE( !strcmp((*loaded)["key"] | "", "newer") );
+    }
+
+    SECTION("Group commit") {
+        auto groupCommit = MicroOcpp::makeGroupCommitFilesystemAdapter(filesystem);
+
+        for (int i = 0; i < 3; i++) {
+            doc["key"] = i;
+            REQUIRE( MicroOcpp::FilesystemUtils::storeJson(groupCommit, fn, doc) );
+        }
+        REQUIRE( MicroOcpp::FilesystemUtils::storeJson(groupCommit, MO_FILENAME_PREFIX "atomic2.jsn", doc) );
+
+        //reads see the pending state, the filesystem still has the old one
+        auto loaded = MicroOcpp::FilesystemUtils::loadJson(groupCommit, fn, "UnitTests");
+        REQUIRE( loaded );
+        REQUIRE( ((*loaded)["key"] | -1) == 2 );
+        loaded = MicroOcpp::FilesystemUtils::loadJson(filesystem, fn, "UnitTests");
+        REQUIRE( !strcmp((*loaded)["key"] | "", "old") );
+
+        size_t nfiles = 0;
+        groupCommit->ftw_root([&nfiles] (const char*) {nfiles++; return 0;});
+        REQUIRE( nfiles == 2 );
+
+        //removed before the flush, never reaches the filesystem
+        REQUIRE( groupCommit->remove(MO_FILENAME_PREFIX "atomic2.jsn") );
+        REQUIRE( groupCommit->stat(MO_FILENAME_PREFIX "atomic2.jsn", &size) != 0 );
+
+        REQUIRE( groupCommit->flush() );
+        loaded = MicroOcpp::FilesystemUtils::loadJson(filesystem, fn, "UnitTests");
+        REQUIRE( loaded );
+        REQUIRE( ((*loaded)["key"] | -1) == 2 );
+        REQUIRE( filesystem->stat(tmpFn, &size) != 0 );
+        REQUIRE( filesystem->stat(MO_FILENAME_PREFIX "atomic2.jsn", &size) != 0 );
+
+        //destructor flushes
+        doc["key"] = 3;
+        REQUIRE( MicroOcpp::FilesystemUtils::storeJson(groupCommit, fn, doc) );
+        groupCommit.reset();
+        loaded = MicroOcpp::FilesystemUtils::loadJson(filesystem, fn, "UnitTests");
+        REQUIRE( ((*loaded)["key"] | -1) == 3 );
+    }
+
+    SECTION("Group commit of appends") {
+        auto groupCommit = MicroOcpp::makeGroupCommitFilesystemAdapter(filesystem);
+        const char *logFn = MO_FILENAME_PREFIX "atomic.log";
+        REQUIRE( writeRaw(filesystem, logFn, "a") );
+
+        auto readAll = [] (std::shared_ptr<MicroOcpp::FilesystemAdapter> filesystem, const char *fn) {
+            std::string content;
+            if (auto file = filesystem->open(fn, "r")) {
+                int c;
+                while ((c = file->read()) >= 0) {
+                    content.push_back((char) c);
+                }
+            }
+            return content;
+        };
+
+        //loop 1
+        if (auto file = groupCommit->open(logFn, "a")) {
+            REQUIRE( file->write("b", 1) == 1 );
+        }
+        REQUIRE( groupCommit->flush() );
+        REQUIRE( readAll(filesystem, logFn) == "ab" );
+
+        //loop 2: nothing reaches the filesystem before the flush
+        for (int i = 0; i < 2; i++) {
+            auto file = groupCommit->open(logFn, "a");
+            REQUIRE( file );
+            REQUIRE( file->write("c", 1) == 1 );
+        }
+        REQUIRE( groupCommit->stat(logFn, &size) == 0 );
+        REQUIRE( size == 4 );
+        REQUIRE( readAll(groupCommit, logFn) == "abcc" );
+        REQUIRE( filesystem->stat(logFn, &size) == 0 );
+        REQUIRE( size == 2 );
+        REQUIRE( readAll(filesystem, logFn) == "ab" );
+
+        //appended, then removed: the removal comes last
+        REQUIRE( groupCommit->remove(logFn) );
+        if (auto file = groupCommit->open(logFn, "a")) {
+            REQUIRE( file->write("d", 1) == 1 );
+        }
+        REQUIRE( readAll(filesystem, logFn) == "ab" );
+
+        REQUIRE( groupCommit->flush() );
+        REQUIRE( readAll(filesystem, logFn) == "d" );
+    }
+
+    MicroOcpp::FilesystemUtils::remove_if(filesystem, [] (const char*) {return true;});
+    REQUIRE( filesystem->stat(tmpFn, &size) != 0 );
+    MicroOcpp::FilesystemUtils::freeReadBuffer();
+}
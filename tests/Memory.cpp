@@ -0,0 +1,278 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#include <MicroOcpp/Core/Memory.h>
+#include <MicroOcpp/Core/ObjectPool.h>
+#include <MicroOcpp/Core/SlabAllocator.h>
+#include <MicroOcpp/Core/FilesystemUtils.h>
+#include <MicroOcpp/Core/Request.h>
+#include <MicroOcpp/Operations/CustomOperation.h>
+#include <MicroOcpp/Debug.h>
+#include <catch2/catch.hpp>
+#include "./helpers/testHelper.h"
+
+#include <array>
+#include <thread>
+#include <vector>
+
+TEST_CASE( "Object pool" ) {
+    printf("\nRun %s\n",  "Object pool");
+
+    SECTION("Recycle blocks") {
+        MicroOcpp::ObjectPool pool ("UnitTests", 64);
+
+        void *block1 = pool.allocate(64);
+        void *block2 = pool.allocate(64);
+        REQUIRE( block1 != block2 );
+
+        pool.release(block1, 64);
+        REQUIRE( pool.allocate(64) == block1 );
+
+        //other sizes bypass the pool
+        void *other = pool.allocate(128);
+        pool.release(other, 128);
+        pool.release(block2, 64);
+        REQUIRE( pool.allocate(64) == block2 );
+
+        pool.release(block1, 64);
+        pool.release(block2, 64);
+        pool.shrink();
+    }
+
+#if MO_ENABLE_OBJECT_POOL
+    SECTION("Recycle Requests") {
+        auto makeDataTransfer = [] () {
+            return MicroOcpp::makeRequest(new MicroOcpp::Ocpp16::CustomOperation("DataTransfer",
+                    [] (JsonObject) {}, [] () {return MicroOcpp::createEmptyDocument();}));
+        };
+
+        auto request = makeDataTransfer();
+        auto addr = request.get();
+        request.reset();
+
+        request = makeDataTransfer();
+        REQUIRE( request.get() == addr );
+    }
+#endif
+}
+
+TEST_CASE( "JSON arena" ) {
+    printf("\nRun %s\n",  "JSON arena");
+
+    SECTION("Reuse memory") {
+        MicroOcpp::JsonArena arena ("UnitTests", 1024);
+
+        auto& doc = arena.acquire();
+        REQUIRE( doc.capacity() == 1024 );
+        deserializeJson(doc, "[2,\"msgId\",\"Heartbeat\",{}]");
+        arena.release();
+
+        auto& doc2 = arena.acquire(256);
+        REQUIRE( &doc2 == &doc );
+        REQUIRE( doc2.capacity() == 1024 );
+        REQUIRE( doc2.isNull() );
+        arena.release();
+
+        //larger documents are allocated temporarily
+        auto& doc3 = arena.acquire(4096);
+        REQUIRE( doc3.capacity() >= 4096 );
+        arena.release();
+        REQUIRE( arena.acquire().capacity() == 1024 );
+        arena.release();
+
+        //disable reuse
+        arena.setMaxCapacity(0);
+        REQUIRE( arena.acquire().capacity() == 0 );
+        arena.release();
+    }
+
+    SECTION("Load JSON files") {
+        auto filesystem = MicroOcpp::makeDefaultFilesystemAdapter(MicroOcpp::FilesystemOpt::Use_Mount_FormatOnFail);
+
+        auto doc = MicroOcpp::initJsonDoc("UnitTests", 256);
+        deserializeJson(doc, "{\"key\":\"value\",\"arr\":[1,2,3]}");
+        REQUIRE( MicroOcpp::FilesystemUtils::storeJson(filesystem, MO_FILENAME_PREFIX "arena.jsn", doc) );
+
+        auto loaded = MicroOcpp::FilesystemUtils::loadJson(filesystem, MO_FILENAME_PREFIX "arena.jsn", "UnitTests");
+        REQUIRE( loaded );
+        REQUIRE( !strcmp((*loaded)["key"] | "", "value") );
+        REQUIRE( ((*loaded)["arr"][2] | -1) == 3 );
+#if MO_JSON_FILE_BUFSIZE > 0
+        REQUIRE( loaded->capacity() < 128 ); //exact size instead of the power-of-2 estimate
+#endif
+
+        filesystem->remove(MO_FILENAME_PREFIX "arena.jsn");
+        MicroOcpp::FilesystemUtils::freeReadBuffer();
+    }
+}
+
+#if MO_OVERRIDE_ALLOCATION && MO_ENABLE_HEAP_PROFILER
+TEST_CASE( "Heap profiler" ) {
+    printf("\nRun %s\n",  "Heap profiler");
+
+    //returns {current, max} of the tag
+    auto getTagStats = [] (const char *tag) -> std::array<size_t, 2> {
+        static char buf [1 << 18];
+        REQUIRE( mo_mem_write_stats_json(buf, sizeof(buf)) > 0 );
+        DynamicJsonDocument doc (2 * sizeof(buf));
+        REQUIRE( !deserializeJson(doc, buf) );
+        for (JsonObject entry : doc["by_tag"].as<JsonArray>()) {
+            if (!strcmp(entry["tag"] | "", tag)) {
+                return {entry["current"] | (size_t) 0, entry["max"] | (size_t) 0};
+            }
+        }
+        return {0, 0};
+    };
+
+    SECTION("Track blocks by tag") {
+        void *block1 = mo_mem_malloc("UnitTests.Profiler", 100);
+        void *block2 = mo_mem_malloc("UnitTests.Profiler", 50);
+        REQUIRE( getTagStats("UnitTests.Profiler")[0] == 150 );
+
+        mo_mem_free(block1);
+        REQUIRE( getTagStats("UnitTests.Profiler")[0] == 50 );
+        REQUIRE( getTagStats("UnitTests.Profiler")[1] >= 150 );
+
+        mo_mem_free(block2);
+        REQUIRE( getTagStats("UnitTests.Profiler")[0] == 0 );
+    }
+
+    SECTION("Tag by object") {
+        //objects which are close to the block start set the tag of an untagged block
+        auto block = static_cast<unsigned char*>(mo_mem_malloc(nullptr, 64));
+        mo_mem_set_tag(block + 2 * sizeof(void*), "UnitTests.Inner");
+        REQUIRE( getTagStats("UnitTests.Inner")[0] == 64 );
+
+        //outer objects take precedence
+        mo_mem_set_tag(block, "UnitTests.Outer");
+        REQUIRE( getTagStats("UnitTests.Inner")[0] == 0 );
+        REQUIRE( getTagStats("UnitTests.Outer")[0] == 64 );
+
+        mo_mem_set_tag(block + sizeof(void*), "UnitTests.Inner");
+        REQUIRE( getTagStats("UnitTests.Outer")[0] == 64 );
+
+        mo_mem_free(block);
+        REQUIRE( getTagStats("UnitTests.Outer")[0] == 0 );
+    }
+
+    SECTION("Interned tags") {
+        auto tagId = MicroOcpp::Memory::internTag("UnitTests", ".Interned");
+        REQUIRE( tagId != 0 );
+        REQUIRE( MicroOcpp::Memory::internTag("UnitTests.Interned") == tagId );
+        REQUIRE( !strcmp(MicroOcpp::Memory::getTag(tagId), "UnitTests.Interned") );
+        REQUIRE( MicroOcpp::Memory::internTag(nullptr) == 0 );
+        REQUIRE( MicroOcpp::Memory::getTag(0) == nullptr );
+
+        //copies of containers allocate under the same tag
+        auto vec = MicroOcpp::makeVector<int>("UnitTests.Interned");
+        vec.resize(16);
+        auto vecCopy = vec;
+        REQUIRE( getTagStats("UnitTests.Interned")[0] == 2 * 16 * sizeof(int) );
+    }
+
+    SECTION("Sampling") {
+        mo_mem_set_sample_rate(4);
+
+        void *blocks [8];
+        for (size_t i = 0; i < 8; i++) {
+            blocks[i] = mo_mem_malloc("UnitTests.Sampled", 16);
+        }
+        REQUIRE( getTagStats("UnitTests.Sampled")[0] == 8 * 16 ); //2 sampled blocks, counted 4 times each
+
+        mo_mem_set_sample_rate(1);
+
+        for (size_t i = 0; i < 8; i++) {
+            mo_mem_free(blocks[i]);
+        }
+        REQUIRE( getTagStats("UnitTests.Sampled")[0] == 0 );
+    }
+
+#if MO_JSON_FILE_BUFSIZE > 0 && MO_ENABLE_MULTI_INSTANCE
+    SECTION("Read buffer of worker threads") {
+        auto filesystem = MicroOcpp::makeDefaultFilesystemAdapter(MicroOcpp::FilesystemOpt::Use_Mount_FormatOnFail);
+        auto doc = MicroOcpp::initJsonDoc("UnitTests", 64);
+        deserializeJson(doc, "{\"key\":\"value\"}");
+        REQUIRE( MicroOcpp::FilesystemUtils::storeJson(filesystem, MO_FILENAME_PREFIX "worker.jsn", doc) );
+
+        MicroOcpp::FilesystemUtils::freeReadBuffer();
+        auto heapBefore = getTagStats("FilesystemUtils")[0];
+
+        bool loaded = false;
+        std::thread worker ([&filesystem, &loaded] () {
+            loaded = MicroOcpp::FilesystemUtils::loadJson(filesystem, MO_FILENAME_PREFIX "worker.jsn", "UnitTests") != nullptr;
+        });
+        worker.join();
+        REQUIRE( loaded );
+
+        //the worker has allocated its own buffer and freed it on exit
+        REQUIRE( getTagStats("FilesystemUtils")[0] == heapBefore );
+
+        filesystem->remove(MO_FILENAME_PREFIX "worker.jsn");
+    }
+#endif
+}
+#endif
+
+#if MO_OVERRIDE_ALLOCATION && MO_ENABLE_SLAB_ALLOCATOR
+TEST_CASE( "Slab allocator" ) {
+    printf("\nRun %s\n",  "Slab allocator");
+
+    //other tests leave blocks in the slabs, so only compare the differences
+    auto getSlabStats = [] () {
+        char buf [2048];
+        REQUIRE( mo_mem_write_slab_stats_json(buf, sizeof(buf)) > 0 );
+        DynamicJsonDocument doc (4096);
+        REQUIRE( !deserializeJson(doc, buf) );
+        return doc;
+    };
+
+    SECTION("Size classes") {
+        auto before = getSlabStats();
+        size_t used16 = before["by_class"][0]["used"];
+        size_t requested16 = before["by_class"][0]["requested"];
+        size_t used64 = before["by_class"][2]["used"];
+
+        void *block1 = MO_MALLOC("UnitTests", 10);
+        void *block2 = MO_MALLOC("UnitTests", 40);
+
+        auto after = getSlabStats();
+        REQUIRE( (size_t) after["by_class"][0]["used"] == used16 + 1 );
+        REQUIRE( (size_t) after["by_class"][0]["requested"] == requested16 + 10 );
+        REQUIRE( (size_t) after["by_class"][2]["used"] == used64 + 1 );
+
+        MO_FREE(block1);
+        MO_FREE(block2);
+
+        auto freed = getSlabStats();
+        REQUIRE( (size_t) freed["by_class"][0]["used"] == used16 );
+        REQUIRE( (size_t) freed["by_class"][0]["requested"] == requested16 );
+        REQUIRE( (size_t) freed["by_class"][2]["used"] == used64 );
+    }
+
+    SECTION("Fall back to heap") {
+        auto before = getSlabStats();
+        size_t fallbacks = before["fallbacks"];
+        size_t oversized = before["oversized"];
+
+        //the largest class has no larger class to spill into
+        std::vector<void*> blocks;
+        for (size_t i = 0; i <= MO_SLAB_BLOCKS_256; i++) {
+            blocks.push_back(MO_MALLOC("UnitTests", 200));
+        }
+        void *large = MO_MALLOC("UnitTests", 1000);
+        REQUIRE( !MicroOcpp::Memory::slabFree(large) );
+        MO_FREE(large);
+
+        auto after = getSlabStats();
+        REQUIRE( (size_t) after["by_class"][4]["used"] == MO_SLAB_BLOCKS_256 );
+        REQUIRE( (size_t) after["by_class"][4]["max_used"] == MO_SLAB_BLOCKS_256 );
+        REQUIRE( (size_t) after["fallbacks"] > fallbacks );
+        REQUIRE( (size_t) after["oversized"] == oversized + 1 );
+
+        for (auto block : blocks) {
+            MO_FREE(block);
+        }
+    }
+}
+#endif
@@ -0,0 +1,75 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#include <MicroOcpp/Core/OperationRegistry.h>
+#include <MicroOcpp/Core/Request.h>
+#include <MicroOcpp/Core/Operation.h>
+#include <MicroOcpp/Operations/CustomOperation.h>
+#include <MicroOcpp/Debug.h>
+#include <catch2/catch.hpp>
+#include "./helpers/testHelper.h"
+
+#include <string>
+#include <vector>
+
+TEST_CASE( "Operation dispatch" ) {
+    printf("\nRun %s\n",  "Operation dispatch");
+
+    MicroOcpp::OperationRegistry registry;
+
+    //enough operations to resize the hash table a few times
+    const size_t nOperations = 200;
+    std::vector<std::string> names; //registry doesn't copy the names
+    for (size_t i = 0; i < nOperations; i++) {
+        names.push_back("CustomOperation" + std::to_string(i));
+    }
+
+    for (size_t i = 0; i < nOperations; i++) {
+        const char *name = names[i].c_str();
+        registry.registerOperation(name, [name] () {
+            return new MicroOcpp::Ocpp16::CustomOperation(name, [] (JsonObject) {}, [] () {return MicroOcpp::createEmptyDocument();});
+        });
+    }
+
+    SECTION("Resolve all operations") {
+        for (size_t i = 0; i < nOperations; i++) {
+            auto request = registry.deserializeOperation(names[i].c_str());
+            REQUIRE( !strcmp(request->getOperationType(), names[i].c_str()) );
+        }
+    }
+
+    SECTION("Unknown operation") {
+        auto request = registry.deserializeOperation("CustomOperationX");
+        REQUIRE( request->getOperation()->getErrorCode() != nullptr );
+        REQUIRE( !strcmp(request->getOperation()->getErrorCode(), "NotImplemented") );
+    }
+
+    SECTION("Re-register operation") {
+        const char *name = names[42].c_str();
+
+        bool onRequestCalled = false;
+        registry.setOnRequest(name, [&onRequestCalled] (JsonObject) {
+            onRequestCalled = true;
+        });
+
+        bool replacedCalled = false;
+        registry.registerOperation(name, [name, &replacedCalled] () {
+            replacedCalled = true;
+            return new MicroOcpp::Ocpp16::CustomOperation(name, [] (JsonObject) {}, [] () {return MicroOcpp::createEmptyDocument();});
+        });
+
+        auto request = registry.deserializeOperation(name);
+        REQUIRE( replacedCalled );
+
+        //listeners of the former registration are dropped
+        auto doc = MicroOcpp::initJsonDoc("UnitTests", 256);
+        deserializeJson(doc, "[2,\"msgId\",\"CustomOperation42\",{}]");
+        REQUIRE( request->receiveRequest(doc.as<JsonArray>()) );
+        REQUIRE( !onRequestCalled );
+
+        //neighbouring entries are unaffected
+        REQUIRE( !strcmp(registry.deserializeOperation(names[41].c_str())->getOperationType(), names[41].c_str()) );
+        REQUIRE( !strcmp(registry.deserializeOperation(names[43].c_str())->getOperationType(), names[43].c_str()) );
+    }
+}
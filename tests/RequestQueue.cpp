@@ -0,0 +1,796 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#include <MicroOcpp.h>
+#include <MicroOcpp/Core/Connection.h>
+#include <MicroOcpp/Core/Context.h>
+#include <MicroOcpp/Core/Request.h>
+#include <MicroOcpp/Core/PersistentRequestQueue.h>
+#include <MicroOcpp/Core/RequestScheduler.h>
+#include <MicroOcpp/Operations/StatusNotification.h>
+#include <MicroOcpp/Operations/CustomOperation.h>
+#include <MicroOcpp/Core/FilesystemUtils.h>
+#include <MicroOcpp/Debug.h>
+#include <catch2/catch.hpp>
+#include "./helpers/testHelper.h"
+
+#include <string>
+#include <vector>
+
+#define BASE_TIME "2023-01-01T00:00:00.000Z"
+
+using namespace MicroOcpp;
+
+//Connection which keeps the outgoing messages so that the test can answer them in an arbitrary order
+class ManualConnection : public Connection {
+private:
+    ReceiveTXTcallback receiveTXT;
+public:
+    struct SentMessage {
+        std::string messageId;
+        std::string operationType;
+        std::string payload;
+    };
+    std::vector<SentMessage> sent; //outgoing CALLs which haven't been answered yet
+    bool connected = true;
+    size_t confsSent = 0; //outgoing CALLRESULTs and CALLERRORs
+    std::string lastConf;
+
+    bool zeroCopy = false; //provide TXT buffer
+    std::vector<char> txtBuffer;
+    size_t txtBufferCommits = 0;
+
+    void loop() override { }
+
+    bool sendTXT(const char *msg, size_t length) override {
+        auto doc = makeJsonDoc(UNIT_MEM_TAG, 4096);
+        if (deserializeJson(*doc, msg, length)) {
+            return false;
+        }
+        if (((*doc)[0] | -1) == MESSAGE_TYPE_CALL) {
+            SentMessage sentMsg;
+            sentMsg.messageId = (*doc)[1] | "";
+            sentMsg.operationType = (*doc)[2] | "";
+            serializeJson((*doc)[3], sentMsg.payload);
+            sent.push_back(sentMsg);
+        } else {
+            confsSent++;
+            lastConf = std::string(msg, length);
+        }
+        return true;
+    }
+
+    void setReceiveTXTcallback(ReceiveTXTcallback &receiveTXT) override {
+        this->receiveTXT = receiveTXT;
+    }
+
+    unsigned long getLastConnected() override {return 0;}
+
+    bool isConnected() override {return connected;}
+
+    char *leaseTXTBuffer(size_t size) override {
+        if (!zeroCopy) {
+            return nullptr;
+        }
+        txtBuffer.assign(size, '\xff'); //detect missing terminating zero
+        return txtBuffer.data();
+    }
+
+    bool commitTXTBuffer(size_t length) override {
+        REQUIRE( length < txtBuffer.size() );
+        REQUIRE( txtBuffer[length] == '\0' );
+        txtBufferCommits++;
+        return sendTXT(txtBuffer.data(), length);
+    }
+
+    size_t count(const char *operationType) {
+        size_t res = 0;
+        for (auto& msg : sent) {
+            if (msg.operationType == operationType) {
+                res++;
+            }
+        }
+        return res;
+    }
+
+    //answer the n-th pending CALL of this type with a CALLRESULT
+    bool respond(const char *operationType, const char *payload, size_t n = 0) {
+        for (auto msg = sent.begin(); msg != sent.end(); msg++) {
+            if (msg->operationType == operationType && n-- == 0) {
+                std::string response = std::string("[3,\"") + msg->messageId + "\"," + payload + "]";
+                sent.erase(msg);
+                return receiveTXT(response.c_str(), response.length());
+            }
+        }
+        return false;
+    }
+
+    void respondAll(const char *operationType, const char *payload) {
+        while (respond(operationType, payload));
+    }
+
+    bool receive(const char *msg) {
+        return receiveTXT(msg, strlen(msg));
+    }
+};
+
+TEST_CASE( "RequestQueue" ) {
+    printf("\nRun %s\n",  "RequestQueue");
+
+    //clean state
+    auto filesystem = makeDefaultFilesystemAdapter(FilesystemOpt::Use_Mount_FormatOnFail);
+    FilesystemUtils::remove_if(filesystem, [] (const char*) {return true;});
+
+    ManualConnection connection;
+    mocpp_initialize(connection, ChargerCredentials("test-runner1234"), filesystem);
+    auto context = getOcppContext();
+    auto& reqQueue = context->getRequestQueue();
+
+    mocpp_set_timer(custom_timer_cb);
+
+    //BootNotification is never pipelined
+    reqQueue.setPipelineWindow(3);
+    loop();
+    REQUIRE( connection.count("BootNotification") == 1 );
+    REQUIRE( connection.sent.size() == 1 );
+    connection.respond("BootNotification", "{\"currentTime\":\"" BASE_TIME "\",\"interval\":3600,\"status\":\"Accepted\"}");
+    loop();
+    connection.respondAll("StatusNotification", "{}");
+    loop();
+    REQUIRE( connection.sent.empty() );
+
+    const size_t nRequests = 3;
+    std::vector<std::string> receivedData;
+
+    auto sendDataTransfers = [&receivedData, nRequests] () {
+        for (size_t i = 0; i < nRequests; i++) {
+            sendRequest("DataTransfer", [i] () {
+                auto doc = makeJsonDoc(UNIT_MEM_TAG, JSON_OBJECT_SIZE(2));
+                (*doc)["vendorId"] = "mVendorId";
+                (*doc)["messageId"] = i;
+                return doc;
+            }, [&receivedData] (JsonObject payload) {
+                receivedData.push_back(payload["data"] | "_Undefined");
+            });
+        }
+    };
+
+    SECTION("No pipelining") {
+        reqQueue.setPipelineWindow(1);
+
+        sendDataTransfers();
+        loop();
+        REQUIRE( connection.count("DataTransfer") == 1 );
+
+        //response which doesn't belong to any request doesn't affect the sent request
+        connection.receive("[3,\"stray-msg-id\",{\"status\":\"Accepted\",\"data\":\"stray\"}]");
+        loop();
+        REQUIRE( connection.count("DataTransfer") == 1 );
+        REQUIRE( receivedData.empty() );
+
+        for (size_t i = 0; i < nRequests; i++) {
+            REQUIRE( connection.count("DataTransfer") == 1 );
+            connection.respond("DataTransfer", "{\"status\":\"Accepted\",\"data\":\"ok\"}");
+            loop();
+        }
+
+        REQUIRE( connection.sent.empty() );
+        REQUIRE( receivedData.size() == nRequests );
+    }
+
+    SECTION("Pipelining with out-of-order responses") {
+
+        sendDataTransfers();
+        loop();
+        REQUIRE( connection.count("DataTransfer") == nRequests );
+
+        //answer in reverse order; the messageIds must correlate each response with its request
+        for (size_t i = nRequests; i >= 1; i--) {
+            auto doc = makeJsonDoc(UNIT_MEM_TAG, 1024);
+            REQUIRE( !deserializeJson(*doc, connection.sent[i - 1].payload) );
+            char payload [64];
+            snprintf(payload, sizeof(payload), "{\"status\":\"Accepted\",\"data\":\"resp-%i\"}", (*doc)["messageId"] | -1);
+            REQUIRE( connection.respond("DataTransfer", payload, i - 1) );
+        }
+
+        REQUIRE( receivedData.size() == nRequests );
+        REQUIRE( receivedData[0] == "resp-2" );
+        REQUIRE( receivedData[1] == "resp-1" );
+        REQUIRE( receivedData[2] == "resp-0" );
+        REQUIRE( connection.sent.empty() );
+    }
+
+    SECTION("Pipelining keeps tx message order") {
+
+        beginTransaction_authorized("mIdTag");
+        loop();
+        endTransaction();
+        sendDataTransfers();
+        loop();
+
+        //StopTransaction must wait for the StartTransaction response while independent requests are pipelined
+        REQUIRE( connection.count("StartTransaction") == 1 );
+        REQUIRE( connection.count("StopTransaction") == 0 );
+        REQUIRE( connection.count("DataTransfer") + connection.count("StatusNotification") + 1 <= 3 );
+
+        connection.respondAll("StatusNotification", "{}");
+        connection.respondAll("DataTransfer", "{\"status\":\"Accepted\"}");
+        loop();
+
+        REQUIRE( connection.count("StopTransaction") == 0 );
+        REQUIRE( connection.respond("StartTransaction", "{\"idTagInfo\":{\"status\":\"Accepted\"},\"transactionId\":1000}") );
+        loop();
+        connection.respondAll("StatusNotification", "{}");
+        connection.respondAll("DataTransfer", "{\"status\":\"Accepted\"}");
+        loop();
+
+        REQUIRE( connection.count("StopTransaction") == 1 );
+        REQUIRE( connection.sent.back().payload.find("\"transactionId\":1000") != std::string::npos );
+    }
+
+    SECTION("Confirmation budget") {
+
+        const size_t nBurst = 6;
+        auto receiveBurst = [&connection, nBurst] () {
+            for (size_t i = 0; i < nBurst; i++) {
+                char msg [128];
+                snprintf(msg, sizeof(msg), "[2,\"burst-%zu\",\"GetConfiguration\",{\"key\":[\"HeartbeatInterval\"]}]", i);
+                REQUIRE( connection.receive(msg) );
+            }
+        };
+
+        //default: one confirmation per loop, no request in the same loop
+        receiveBurst();
+        sendDataTransfers();
+        connection.confsSent = 0;
+        mocpp_loop();
+        REQUIRE( connection.confsSent == 1 );
+        REQUIRE( connection.count("DataTransfer") == 0 );
+        loop();
+        REQUIRE( connection.confsSent == nBurst );
+        connection.respondAll("DataTransfer", "{\"status\":\"Accepted\"}");
+        loop();
+        connection.respondAll("DataTransfer", "{\"status\":\"Accepted\"}");
+        loop();
+        connection.respondAll("DataTransfer", "{\"status\":\"Accepted\"}");
+        REQUIRE( receivedData.size() == nRequests );
+
+        //budget of 4 confirmations, then the next request in the same loop
+        reqQueue.setConfirmationBudget(4);
+        receiveBurst();
+        sendDataTransfers();
+        connection.confsSent = 0;
+        mocpp_loop();
+        REQUIRE( connection.confsSent == 4 );
+        REQUIRE( connection.count("DataTransfer") == 1 );
+        mocpp_loop();
+        REQUIRE( connection.confsSent == nBurst );
+        REQUIRE( connection.count("DataTransfer") == 2 );
+    }
+
+    SECTION("Zero-copy sending") {
+
+        connection.zeroCopy = true;
+
+        sendDataTransfers();
+        connection.receive("[2,\"msg-1\",\"GetConfiguration\",{\"key\":[\"HeartbeatInterval\"]}]");
+        connection.confsSent = 0;
+        loop();
+
+        //all messages have been serialized into the TXT buffer of the connection
+        REQUIRE( connection.count("DataTransfer") == nRequests );
+        REQUIRE( connection.confsSent == 1 );
+        REQUIRE( connection.lastConf.find("\"HeartbeatInterval\"") != std::string::npos );
+        REQUIRE( connection.txtBufferCommits == nRequests + 1 );
+
+        connection.respondAll("DataTransfer", "{\"status\":\"Accepted\",\"data\":\"ok\"}");
+        REQUIRE( receivedData.size() == nRequests );
+    }
+
+    SECTION("Single-pass JSON ingest") {
+
+        const char *samples [] = {
+            "[]",
+            "[2,\"msg-1\",\"DataTransfer\",{}]",
+            "[2,\"msg-2\",\"DataTransfer\",{\"vendorId\":\"v\\\"e\\\\n\\u00e4\",\"data\":\"[{,}]\"}]",
+            "[3, \"msg-3\" , { \"idTagInfo\" : { \"status\" : \"Accepted\" } , \"transactionId\" : 1000 } ]",
+            "[2,\"msg-4\",\"SendLocalList\",{\"listVersion\":1,\"updateType\":\"Full\",\"localAuthorizationList\":["
+                    "{\"idTag\":\"A\",\"idTagInfo\":{\"status\":\"Accepted\",\"expiryDate\":\"" BASE_TIME "\"}},"
+                    "{\"idTag\":\"B\",\"idTagInfo\":{\"status\":\"Blocked\"}},{\"idTag\":\"C\"},[[],{},[1,2.5,null,true]]]}]"
+        };
+
+        //the measured capacity is sufficient to deserialize the input
+        for (const char *sample : samples) {
+            size_t capacity = measureJsonCapacity(sample, strlen(sample));
+            auto doc = initJsonDoc(UNIT_MEM_TAG, capacity);
+            REQUIRE( !deserializeJson(doc, sample) );
+            REQUIRE( doc.memoryUsage() <= capacity );
+        }
+
+        //large message is deserialized at once
+        std::string data (MO_MAX_JSON_CAPACITY / 2, 'x');
+        std::string msg = "[2,\"msg-large\",\"DataTransfer\",{\"vendorId\":\"mVendorId\",\"data\":\"" + data + "\"}]";
+        connection.confsSent = 0;
+        REQUIRE( connection.receive(msg.c_str()) );
+        loop();
+        REQUIRE( connection.confsSent == 1 );
+
+        //message which exceeds MO_MAX_JSON_CAPACITY is rejected with the recovered messageId
+        data = std::string(MO_MAX_JSON_CAPACITY, 'x');
+        msg = "[2,\"msg-exceeded\",\"DataTransfer\",{\"vendorId\":\"mVendorId\",\"data\":\"" + data + "\"}]";
+        connection.confsSent = 0;
+        REQUIRE( connection.receive(msg.c_str()) );
+        loop();
+        REQUIRE( connection.confsSent == 1 );
+        REQUIRE( connection.lastConf.find("[4,\"msg-exceeded\"") == 0 );
+    }
+
+    SECTION("No coalescing of incoming requests") {
+
+        //each incoming CALL gets its response, even if a CoalescingKey applies to the operation
+        connection.confsSent = 0;
+        REQUIRE( connection.receive("[2,\"msg-1\",\"StatusNotification\",{\"connectorId\":1,\"errorCode\":\"NoError\",\"status\":\"Available\"}]") );
+        REQUIRE( connection.receive("[2,\"msg-2\",\"StatusNotification\",{\"connectorId\":1,\"errorCode\":\"NoError\",\"status\":\"Charging\"}]") );
+        loop();
+        REQUIRE( connection.confsSent == 2 );
+        REQUIRE( connection.lastConf.find("[3,\"msg-2\"") == 0 );
+    }
+
+    SECTION("Weighted-fair scheduling") {
+
+        reqQueue.setPipelineWindow(1);
+        reqQueue.setScheduler(std::unique_ptr<RequestScheduler>(new WeightedFairScheduler()));
+
+        //backlog of the default queue
+        for (size_t i = 0; i < 3; i++) {
+            sendDataTransfers();
+        }
+        beginTransaction_authorized("mIdTag");
+
+        size_t defaultDepth = 0, txDepth = 0;
+        for (size_t i = 0; i < reqQueue.getSendQueueCount(); i++) {
+            auto emitter = reqQueue.getSendQueue(i);
+            if (emitter->getRequestPriority() == RequestPriority::TxCritical) {
+                txDepth += emitter->getQueueDepth();
+            } else {
+                defaultDepth += emitter->getQueueDepth();
+            }
+        }
+        REQUIRE( defaultDepth >= 3 * nRequests );
+        REQUIRE( txDepth == 1 );
+
+        //StartTransaction doesn't wait until the default queue is drained
+        size_t sentBeforeStartTx = 0;
+        for (size_t i = 0; i < 3 * nRequests + 5 && connection.count("StartTransaction") == 0; i++) {
+            mocpp_loop();
+            sentBeforeStartTx += connection.count("DataTransfer");
+            connection.respondAll("DataTransfer", "{\"status\":\"Accepted\"}");
+            connection.respondAll("StatusNotification", "{}");
+        }
+        REQUIRE( connection.count("StartTransaction") == 1 );
+        REQUIRE( sentBeforeStartTx <= 2 );
+
+        //StopTransaction still waits for the StartTransaction response while the others pass by
+        reqQueue.setPipelineWindow(2);
+        endTransaction();
+        for (size_t i = 0; i < 3 * nRequests + 5; i++) {
+            mocpp_loop();
+            connection.respondAll("DataTransfer", "{\"status\":\"Accepted\"}");
+            connection.respondAll("StatusNotification", "{}");
+        }
+        REQUIRE( connection.count("StopTransaction") == 0 );
+        REQUIRE( receivedData.size() == 3 * nRequests );
+
+        REQUIRE( connection.respond("StartTransaction", "{\"idTagInfo\":{\"status\":\"Accepted\"},\"transactionId\":1000}") );
+        loop();
+        REQUIRE( connection.count("StopTransaction") == 1 );
+
+        reqQueue.setScheduler(nullptr);
+    }
+
+    SECTION("Adaptive timeouts") {
+
+        auto& rttEstimator = reqQueue.getRttEstimator();
+        rttEstimator.setTimeoutLimits(1000, 60000);
+
+        auto sendDataTransfer = [&context] (unsigned long timeout, bool& checkTimeout) {
+            auto dataTransfer = makeRequest(new Ocpp16::CustomOperation("DataTransfer",
+                [] () {
+                    auto doc = makeJsonDoc(UNIT_MEM_TAG, JSON_OBJECT_SIZE(1));
+                    (*doc)["vendorId"] = "mVendorId";
+                    return doc;
+                }, [] (JsonObject) { }));
+            if (timeout) {
+                dataTransfer->setTimeout(timeout);
+            }
+            dataTransfer->setOnTimeoutListener([&checkTimeout] () {
+                checkTimeout = true;
+            });
+            context->initiateRequest(std::move(dataTransfer));
+        };
+
+        //answer each DataTransfer after 200 ms
+        auto measureRtt = [&connection, nRequests] () {
+            for (size_t i = 0; i < nRequests; i++) {
+                mocpp_loop();
+                mtime += 200;
+                connection.respondAll("DataTransfer", "{\"status\":\"Accepted\"}");
+            }
+        };
+
+        //first request of a type: legacy timeout
+        REQUIRE( rttEstimator.getTimeout("DataTransfer") == MO_REQUEST_RTO_INITIAL );
+
+        for (size_t i = 0; i < 3; i++) {
+            sendDataTransfers();
+            measureRtt();
+        }
+        REQUIRE( receivedData.size() == 3 * nRequests );
+        REQUIRE( rttEstimator.getSmoothedRtt("DataTransfer") == 200 );
+        REQUIRE( rttEstimator.getTimeout("DataTransfer") == 1000 ); //floor
+
+        //lost response: timeout after 1 s instead of 40 s
+        bool checkTimeout = false;
+        sendDataTransfer(0, checkTimeout);
+        mocpp_loop();
+        REQUIRE( connection.count("DataTransfer") == 1 );
+        mtime += 999;
+        mocpp_loop();
+        REQUIRE( !checkTimeout );
+        mtime += 1;
+        mocpp_loop();
+        REQUIRE( checkTimeout );
+        connection.sent.clear();
+
+        //exponential backoff until the next sample
+        REQUIRE( rttEstimator.getTimeout("DataTransfer") == 2000 );
+        sendDataTransfers();
+        measureRtt();
+        REQUIRE( rttEstimator.getTimeout("DataTransfer") == 1000 );
+
+        //requests with fixed timeout are not affected
+        checkTimeout = false;
+        sendDataTransfer(5000, checkTimeout);
+        mocpp_loop();
+        REQUIRE( connection.count("DataTransfer") == 1 );
+        mtime += 4000;
+        mocpp_loop();
+        REQUIRE( !checkTimeout );
+        mtime += 1000;
+        mocpp_loop();
+        REQUIRE( checkTimeout );
+    }
+
+    SECTION("Message ID length") {
+        auto request = makeRequest(new Ocpp16::CustomOperation("DataTransfer",
+                [] (JsonObject) {}, [] () {return createEmptyDocument();}));
+
+        auto doc = initJsonDoc(UNIT_MEM_TAG, 256);
+        deserializeJson(doc, "[2,\"012345678901234567890123456789012345\",\"DataTransfer\",{}]");
+        REQUIRE( request->receiveRequest(doc.as<JsonArray>()) );
+        REQUIRE( !strcmp(request->getMessageID(), "012345678901234567890123456789012345") );
+
+        //longer than OCPP-J allows, kept on the heap
+        request = makeRequest(new Ocpp16::CustomOperation("DataTransfer",
+                [] (JsonObject) {}, [] () {return createEmptyDocument();}));
+        deserializeJson(doc, "[2,\"0123456789012345678901234567890123456789\",\"DataTransfer\",{}]");
+        REQUIRE( request->receiveRequest(doc.as<JsonArray>()) );
+        REQUIRE( !strcmp(request->getMessageID(), "0123456789012345678901234567890123456789") );
+
+        //through the RequestQueue
+        int processed = 0;
+        context->getOperationRegistry().registerOperation("DataTransfer", [&processed] () {
+            return new Ocpp16::CustomOperation("DataTransfer",
+                    [&processed] (JsonObject payload) {processed += payload["n"] | 0;},
+                    [] () {return createEmptyDocument();});
+        });
+
+        connection.confsSent = 0;
+        REQUIRE( connection.receive("[2,\"0123456789012345678901234567890123456789\",\"DataTransfer\",{\"n\":1}]") );
+        loop();
+        REQUIRE( processed == 1 );
+        REQUIRE( connection.confsSent == 1 );
+        deserializeJson(doc, connection.lastConf);
+        REQUIRE( (doc[0] | -1) == MESSAGE_TYPE_CALLRESULT );
+        REQUIRE( !strcmp(doc[1] | "", "0123456789012345678901234567890123456789") );
+
+        //requests with invalid message IDs are dropped without executing the operation
+        connection.receive("[2,42,\"DataTransfer\",{\"n\":1}]");
+        loop();
+        REQUIRE( processed == 1 );
+        REQUIRE( connection.confsSent == 1 );
+    }
+
+    mocpp_deinitialize();
+}
+
+#if MO_ENABLE_PERSISTENT_REQUEST_QUEUE
+
+TEST_CASE( "PersistentRequestQueue" ) {
+    printf("\nRun %s\n",  "PersistentRequestQueue");
+
+    //clean state
+    auto filesystem = makeDefaultFilesystemAdapter(FilesystemOpt::Use_Mount_FormatOnFail);
+    FilesystemUtils::remove_if(filesystem, [] (const char*) {return true;});
+
+    ManualConnection connection;
+    mocpp_set_timer(custom_timer_cb);
+
+    auto boot = [&connection, &filesystem] () {
+        mocpp_initialize(connection, ChargerCredentials("test-runner1234"), filesystem);
+        loop();
+        REQUIRE( connection.respond("BootNotification", "{\"currentTime\":\"" BASE_TIME "\",\"interval\":3600,\"status\":\"Accepted\"}") );
+        for (size_t i = 0; i < MO_NUMCONNECTORS; i++) {
+            loop();
+            connection.respondAll("StatusNotification", "{}");
+        }
+        REQUIRE( connection.sent.empty() );
+    };
+
+    auto countSegmentFiles = [&filesystem] () {
+        size_t n = 0;
+        filesystem->ftw_root([&n] (const char *fname) -> int {
+            if (!strncmp(fname, MO_REQUEST_SEGMENT_FN_PREFIX, sizeof(MO_REQUEST_SEGMENT_FN_PREFIX) - 1)) {
+                n++;
+            }
+            return 0;
+        });
+        return n;
+    };
+
+    auto sendNotifications = [] (int seqBegin, int seqEnd) {
+        for (int seq = seqBegin; seq < seqEnd; seq++) {
+            sendRequest("StatusNotification", [seq] () {
+                auto doc = makeJsonDoc(UNIT_MEM_TAG, JSON_OBJECT_SIZE(1));
+                (*doc)["seq"] = seq;
+                return doc;
+            }, [] (JsonObject) { });
+        }
+    };
+
+    //answer all StatusNotifications and collect the seq numbers of the notifications of this test
+    std::vector<int> seqs;
+    auto respondAndCollect = [&connection, &seqs] () {
+        for (auto& msg : connection.sent) {
+            auto doc = makeJsonDoc(UNIT_MEM_TAG, 1024);
+            if (msg.operationType == "StatusNotification" && !deserializeJson(*doc, msg.payload) && (*doc).containsKey("seq")) {
+                seqs.push_back((*doc)["seq"]);
+            }
+        }
+        connection.respondAll("StatusNotification", "{}");
+    };
+
+    boot();
+
+    SECTION("Online: keep in RAM") {
+        sendNotifications(0, 3);
+        REQUIRE( countSegmentFiles() == 0 );
+        for (size_t i = 0; i < 3; i++) {
+            loop();
+            respondAndCollect();
+        }
+        REQUIRE( seqs.size() == 3 );
+        REQUIRE( countSegmentFiles() == 0 );
+    }
+
+    //StatusNotifications for connectorIds which don't exist in the test setup, so that they aren't superseded by the model
+    auto sendStatus = [] (int connectorId, ChargePointStatus status, const char *errorCode = nullptr) {
+        getOcppContext()->initiateRequest(makeRequest(new Ocpp16::StatusNotification(connectorId, status, getOcppContext()->getModel().getClock().now(), ErrorData(errorCode))));
+    };
+
+    //answer all StatusNotifications and collect "<connectorId>:<status>" of the test notifications
+    std::vector<std::string> statuses;
+    auto respondAndCollectStatus = [&connection, &statuses] () {
+        for (auto& msg : connection.sent) {
+            auto doc = makeJsonDoc(UNIT_MEM_TAG, 1024);
+            if (msg.operationType == "StatusNotification" && !deserializeJson(*doc, msg.payload) && ((*doc)["connectorId"] | -1) >= 10) {
+                statuses.push_back(std::to_string((*doc)["connectorId"] | -1) + ":" + ((*doc)["status"] | ""));
+            }
+        }
+        connection.respondAll("StatusNotification", "{}");
+    };
+
+    SECTION("Online: coalesce in RAM") {
+        sendStatus(10, ChargePointStatus_Preparing);
+        sendStatus(11, ChargePointStatus_Preparing);
+        sendStatus(10, ChargePointStatus_Faulted, "GroundFailure");
+        sendStatus(10, ChargePointStatus_Charging);
+        sendStatus(10, ChargePointStatus_Finishing);
+
+        for (size_t i = 0; i < 5; i++) {
+            loop();
+            respondAndCollectStatus();
+        }
+
+        //the superseded statuses of connector 10 have been dropped. Error reports are kept
+        REQUIRE( statuses.size() == 3 );
+        REQUIRE( statuses[0] == "11:Preparing" );
+        REQUIRE( statuses[1] == "10:Faulted" );
+        REQUIRE( statuses[2] == "10:Finishing" );
+    }
+
+    SECTION("Connecting after boot: keep in RAM") {
+        mocpp_deinitialize();
+        connection.connected = false;
+        mocpp_initialize(connection, ChargerCredentials("test-runner1234"), filesystem);
+
+        //the WebSocket hasn't connected yet. This is no offline period
+        sendNotifications(0, 3);
+        for (size_t i = 0; i < 3; i++) {
+            loop();
+        }
+        REQUIRE( countSegmentFiles() == 0 );
+
+        //PreBoot blocks sending
+        connection.connected = true;
+        loop();
+        sendNotifications(3, 5);
+        loop();
+        REQUIRE( countSegmentFiles() == 0 );
+
+        REQUIRE( connection.respond("BootNotification", "{\"currentTime\":\"" BASE_TIME "\",\"interval\":3600,\"status\":\"Accepted\"}") );
+        for (int i = 0; i < 20 && seqs.size() < 5; i++) {
+            loop();
+            respondAndCollect();
+        }
+        REQUIRE( seqs.size() == 5 );
+        REQUIRE( countSegmentFiles() == 0 );
+
+        //lost connection: secure the RAM queue on flash
+        connection.connected = false;
+        sendNotifications(5, 6);
+        loop();
+        REQUIRE( countSegmentFiles() == 1 );
+    }
+
+    SECTION("Offline: coalesce on flash") {
+        connection.connected = false;
+        sendStatus(10, ChargePointStatus_Preparing);
+        loop(); //move RAM queue to flash
+        sendStatus(11, ChargePointStatus_Preparing);
+        for (size_t i = 0; i < MO_REQUEST_SEGMENT_MAXRECORDS; i++) {
+            sendStatus(10, i % 2 ? ChargePointStatus_Charging : ChargePointStatus_SuspendedEV);
+        }
+        sendStatus(10, ChargePointStatus_Finishing);
+        REQUIRE( countSegmentFiles() == 2 );
+
+        //the CoalescingKeys are restored from flash after a reboot
+        mocpp_deinitialize();
+        connection.connected = true;
+        mocpp_initialize(connection, ChargerCredentials("test-runner1234"), filesystem);
+        loop();
+        REQUIRE( connection.respond("BootNotification", "{\"currentTime\":\"" BASE_TIME "\",\"interval\":3600,\"status\":\"Accepted\"}") );
+        for (size_t i = 0; i < 5 + MO_NUMCONNECTORS; i++) {
+            loop();
+            respondAndCollectStatus();
+        }
+
+        REQUIRE( statuses.size() == 2 );
+        REQUIRE( statuses[0] == "11:Preparing" );
+        REQUIRE( statuses[1] == "10:Finishing" );
+        REQUIRE( countSegmentFiles() == 0 );
+    }
+
+    SECTION("Replay backlog after reboot") {
+
+        const int nNotifications = 3 * MO_REQUEST_SEGMENT_MAXRECORDS + 5;
+
+        //go offline: notifications are appended to the backlog on flash
+        sendNotifications(0, 2);
+        connection.connected = false;
+        loop(); //move RAM queue to flash
+        sendNotifications(2, nNotifications);
+        loop();
+        REQUIRE( connection.sent.empty() );
+        REQUIRE( countSegmentFiles() == (nNotifications + MO_REQUEST_SEGMENT_MAXRECORDS - 1) / MO_REQUEST_SEGMENT_MAXRECORDS );
+
+        //reboot while offline
+        mocpp_deinitialize();
+        connection.connected = true;
+        mocpp_initialize(connection, ChargerCredentials("test-runner1234"), filesystem);
+
+        //backlog is only sent after the BootNotification has been accepted
+        loop();
+        respondAndCollect();
+        REQUIRE( seqs.empty() );
+        REQUIRE( connection.respond("BootNotification", "{\"currentTime\":\"" BASE_TIME "\",\"interval\":3600,\"status\":\"Accepted\"}") );
+
+        for (int i = 0; i < 2 * nNotifications && seqs.size() < (size_t) nNotifications; i++) {
+            loop();
+            respondAndCollect();
+        }
+
+        //complete backlog replayed in order
+        REQUIRE( seqs.size() == (size_t) nNotifications );
+        for (int seq = 0; seq < nNotifications; seq++) {
+            REQUIRE( seqs[seq] == seq );
+        }
+
+        //the StatusNotifications of the connectors after the reboot have been queued behind the backlog
+        for (size_t i = 0; i < MO_NUMCONNECTORS; i++) {
+            loop();
+            connection.respondAll("StatusNotification", "{}");
+        }
+        REQUIRE( connection.sent.empty() );
+        REQUIRE( countSegmentFiles() == 0 );
+    }
+
+    SECTION("Resume replay after reboot") {
+
+        const int nNotifications = MO_REQUEST_SEGMENT_MAXRECORDS / 2 + 2;
+
+        connection.connected = false;
+        sendNotifications(0, nNotifications);
+        loop();
+        connection.connected = true;
+
+        //confirm first two records
+        while (seqs.size() < 2) {
+            mocpp_loop();
+            respondAndCollect();
+        }
+
+        mocpp_deinitialize();
+        mocpp_initialize(connection, ChargerCredentials("test-runner1234"), filesystem);
+        loop();
+        REQUIRE( connection.respond("BootNotification", "{\"currentTime\":\"" BASE_TIME "\",\"interval\":3600,\"status\":\"Accepted\"}") );
+
+        for (int i = 0; i < 2 * nNotifications && seqs.size() < (size_t) nNotifications; i++) {
+            loop();
+            respondAndCollect();
+        }
+
+        //records which have been confirmed before the reboot are not sent again
+        REQUIRE( seqs.size() == (size_t) nNotifications );
+        for (int seq = 0; seq < nNotifications; seq++) {
+            REQUIRE( seqs[seq] == seq );
+        }
+    }
+
+    SECTION("Incomplete record after power loss") {
+
+        connection.connected = false;
+        sendNotifications(0, 3);
+        loop();
+        REQUIRE( countSegmentFiles() == 1 );
+        mocpp_deinitialize();
+
+        //power loss while appending the next record
+        {
+            const char *partial = "{\"type\":\"StatusNotification\",\"payl";
+            auto file = filesystem->open(MO_FILENAME_PREFIX MO_REQUEST_SEGMENT_FN_PREFIX "0.jsn", "a");
+            REQUIRE( file );
+            REQUIRE( file->write(partial, strlen(partial)) == strlen(partial) );
+        }
+
+        //new records don't continue the incomplete one
+        mocpp_initialize(connection, ChargerCredentials("test-runner1234"), filesystem);
+        sendNotifications(3, 5);
+        REQUIRE( countSegmentFiles() == 2 );
+
+        connection.connected = true;
+        loop();
+        REQUIRE( connection.respond("BootNotification", "{\"currentTime\":\"" BASE_TIME "\",\"interval\":3600,\"status\":\"Accepted\"}") );
+
+        for (int i = 0; i < 20 && seqs.size() < 5; i++) {
+            loop();
+            respondAndCollect();
+        }
+
+        REQUIRE( seqs.size() == 5 );
+        for (int seq = 0; seq < 5; seq++) {
+            REQUIRE( seqs[seq] == seq );
+        }
+
+        for (size_t i = 0; i < MO_NUMCONNECTORS; i++) {
+            loop();
+            connection.respondAll("StatusNotification", "{}");
+        }
+        REQUIRE( countSegmentFiles() == 0 );
+    }
+
+    mocpp_deinitialize();
+}
+
+#endif //MO_ENABLE_PERSISTENT_REQUEST_QUEUE
@@ -0,0 +1,131 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#include <MicroOcpp.h>
+#include <MicroOcpp/Core/Connection.h>
+#include <MicroOcpp/Core/ThreadedConnection.h>
+#include <MicroOcpp/Debug.h>
+#include <catch2/catch.hpp>
+#include "./helpers/testHelper.h"
+
+#include <chrono>
+#include <thread>
+
+#if MO_ENABLE_THREADED_CONNECTION
+
+using namespace MicroOcpp;
+
+TEST_CASE( "ThreadedConnection" ) {
+    printf("\nRun %s\n",  "ThreadedConnection");
+
+    SECTION("SPSC frame ring") {
+
+        SpscFrameRing ring {8 * sizeof(size_t)};
+        size_t length;
+
+        REQUIRE( ring.isEmpty() );
+        REQUIRE( ring.front(&length) == nullptr );
+
+        //each frame takes 3 * sizeof(size_t), i.e. two frames fit
+        const char *frame1 = "abcdefghijklmnop";
+        const char *frame2 = "qrstuvwxyz012345";
+        const char *frame3 = "6789ABCDEFGHIJKL";
+        size_t frameLength = 2 * sizeof(size_t) - 1 - 1;
+        REQUIRE( ring.push(frame1, frameLength) );
+        REQUIRE( ring.push(frame2, frameLength) );
+        REQUIRE( !ring.push(frame3, frameLength) );
+
+        auto frame = ring.front(&length);
+        REQUIRE( length == frameLength );
+        REQUIRE( !strncmp(frame, frame1, frameLength) );
+        REQUIRE( frame[frameLength] == '\0' );
+        ring.pop();
+
+        //frame 3 doesn't fit before the end of the buffer and wraps around
+        REQUIRE( ring.push(frame3, frameLength) );
+
+        frame = ring.front(&length);
+        REQUIRE( !strncmp(frame, frame2, frameLength) );
+        ring.pop();
+        frame = ring.front(&length);
+        REQUIRE( !strncmp(frame, frame3, frameLength) );
+        ring.pop();
+        REQUIRE( ring.isEmpty() );
+
+        //too large for the ring
+        char large [8 * sizeof(size_t)] = {'\0'};
+        REQUIRE( !ring.push(large, sizeof(large)) );
+    }
+
+    SECTION("SPSC frame ring between threads") {
+
+        SpscFrameRing ring {256};
+        const unsigned int nFrames = 10000;
+
+        std::thread producer ([&ring] () {
+            char buf [32];
+            for (unsigned int i = 0; i < nFrames; i++) {
+                auto len = snprintf(buf, sizeof(buf), "%u%.*s", i, (int) (i % 16), "................");
+                while (!ring.push(buf, (size_t) len)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+
+        bool inOrder = true;
+        char expected [32];
+        for (unsigned int i = 0; i < nFrames; ) {
+            size_t length;
+            auto frame = ring.front(&length);
+            if (!frame) {
+                std::this_thread::yield();
+                continue;
+            }
+            auto len = snprintf(expected, sizeof(expected), "%u%.*s", i, (int) (i % 16), "................");
+            if (length != (size_t) len || strcmp(frame, expected)) {
+                inOrder = false;
+            }
+            ring.pop();
+            i++;
+        }
+
+        producer.join();
+
+        REQUIRE( inOrder );
+        REQUIRE( ring.isEmpty() );
+    }
+
+    SECTION("Slow network doesn't block the loop") {
+
+        const unsigned long latencyMs = 100;
+
+        LoopbackConnection loopback;
+        LatencyInjector slowNetwork {loopback, latencyMs};
+        ThreadedConnection connection {slowNetwork};
+
+        mocpp_initialize(connection, ChargerCredentials("test-runner1234"));
+        mocpp_set_timer(custom_timer_cb);
+
+        auto start = std::chrono::steady_clock::now();
+        auto maxLoopDuration = std::chrono::steady_clock::duration::zero();
+
+        while (getChargePointStatus() != ChargePointStatus_Available &&
+                std::chrono::steady_clock::now() - start < std::chrono::seconds(10)) {
+            auto loopStart = std::chrono::steady_clock::now();
+            mocpp_loop();
+            maxLoopDuration = std::max(maxLoopDuration, std::chrono::steady_clock::now() - loopStart);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        //BootNotification went through the network thread
+        REQUIRE( getChargePointStatus() == ChargePointStatus_Available );
+        REQUIRE( maxLoopDuration < std::chrono::milliseconds(latencyMs) );
+        REQUIRE( connection.getTxDropped() == 0 );
+        REQUIRE( connection.getRxDropped() == 0 );
+
+        mocpp_deinitialize();
+    }
+}
+
+#endif //MO_ENABLE_THREADED_CONNECTION
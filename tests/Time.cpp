@@ -0,0 +1,137 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#include <MicroOcpp/Core/Time.h>
+#include <MicroOcpp/Platform.h>
+#include <MicroOcpp/Debug.h>
+#include <catch2/catch.hpp>
+#include "./helpers/testHelper.h"
+
+#include <type_traits>
+
+TEST_CASE( "Timestamp" ) {
+    printf("\nRun %s\n",  "Timestamp");
+
+    static_assert(std::is_trivially_copyable<MicroOcpp::Timestamp>::value, "Timestamp must be a plain value type");
+    REQUIRE( sizeof(MicroOcpp::Timestamp) <= 8 );
+
+    char buf [JSONDATE_LENGTH + 1];
+
+    SECTION("Parse and format") {
+        MicroOcpp::Timestamp t;
+        REQUIRE( t.toJsonString(buf, sizeof(buf)) );
+        REQUIRE( !strncmp(buf, "1970-01-01T00:00:00", 19) );
+
+        const char *dates [] = {"2024-02-29T23:59:59", "2000-02-29T00:00:00", "2037-12-31T23:59:59", "2010-01-01T00:00:00"};
+        for (auto date : dates) {
+            REQUIRE( t.setTime(date) );
+            REQUIRE( t.toJsonString(buf, sizeof(buf)) );
+            REQUIRE( !strncmp(buf, date, 19) );
+        }
+
+        REQUIRE( !t.setTime("2023-02-29T00:00:00") );
+        REQUIRE( !t.setTime("2100-01-01T00:00:00") );
+
+        MicroOcpp::MIN_TIME.toJsonString(buf, sizeof(buf));
+        REQUIRE( !strncmp(buf, "2010-01-01T00:00:00", 19) );
+    }
+
+    SECTION("Arithmetic") {
+        MicroOcpp::Timestamp t1, t2;
+        REQUIRE( t1.setTime("2020-01-01T00:00:00") );
+        REQUIRE( t2.setTime("2030-01-01T00:00:00") );
+        REQUIRE( t2 - t1 == 3653 * 24 * 3600 );
+        REQUIRE( t1 - t2 == -3653 * 24 * 3600 );
+        REQUIRE( t1 < t2 );
+        REQUIRE( t1 <= t2 );
+        REQUIRE( t2 > t1 );
+        REQUIRE( t1 != t2 );
+
+        t1 += 3653 * 24 * 3600;
+        REQUIRE( t1 == t2 );
+
+        t1 -= 1;
+        t1.toJsonString(buf, sizeof(buf));
+        REQUIRE( !strncmp(buf, "2029-12-31T23:59:59", 19) );
+
+        t1 = t1 + 60 * 24 * 3600;
+        t1.toJsonString(buf, sizeof(buf));
+        REQUIRE( !strncmp(buf, "2030-03-01T23:59:59", 19) );
+
+        //out-of-range calendar fields carry over
+        REQUIRE( MicroOcpp::Timestamp(2023, 12, 0, 0, 0, 0) == MicroOcpp::Timestamp(2024, 0, 0, 0, 0, 0) );
+        REQUIRE( MicroOcpp::Timestamp(2024, 1, 28, 24, 0, 0) == MicroOcpp::Timestamp(2024, 2, 0, 0, 0, 0) );
+    }
+
+    SECTION("Strict format") {
+        MicroOcpp::Timestamp t;
+        const char *invalid [] = {"", "2024", "2024-01-01T00:00", "2024-01-01 00:00:00", "2024-1-01T00:00:00",
+                "2024-13-01T00:00:00", "2024-00-01T00:00:00", "2024-04-31T00:00:00", "2024-01-01T24:00:00",
+                "2024-01-01T00:60:00", "2024-01-01T00:00:61", "2024-01-01T00:00:00.Z", "2O24-01-01T00:00:00"};
+        for (auto date : invalid) {
+            REQUIRE( !t.setTime(date) );
+        }
+
+        const char *valid [] = {"2024-01-01T00:00:00", "2024-01-01T00:00:00Z", "2024-01-01T00:00:00.1Z",
+                "2024-01-01T00:00:00.123456Z", "2016-12-31T23:59:60Z"};
+        for (auto date : valid) {
+            REQUIRE( t.setTime(date) );
+        }
+    }
+
+    SECTION("Cached formatting of now()") {
+        mocpp_set_timer(custom_timer_cb);
+        MicroOcpp::Clock clock;
+        REQUIRE( clock.setTime("2024-06-30T23:59:58.250Z") );
+
+        char cached [JSONDATE_LENGTH + 1];
+        for (int i = 0; i < 20; i++) {
+            REQUIRE( clock.nowJsonString(cached, sizeof(cached)) );
+            clock.now().toJsonString(buf, sizeof(buf));
+            REQUIRE( !strcmp(cached, buf) );
+            mtime += 150;
+        }
+        REQUIRE( !strncmp(cached, "2024-07-01T00:00:0", 18) ); //crossed midnight
+
+        REQUIRE( !clock.nowJsonString(cached, JSONDATE_LENGTH) );
+
+        //other timestamps go through the same cache
+        MicroOcpp::Timestamp t1, t2;
+        REQUIRE( t1.setTime("2024-03-15T12:34:56.789Z") );
+        REQUIRE( t2.setTime("2024-03-15T12:34:57.000Z") );
+        for (auto t : {t1, t1, t2, t1, clock.now()}) {
+            REQUIRE( clock.toJsonString(t, cached, sizeof(cached)) );
+            t.toJsonString(buf, sizeof(buf));
+            REQUIRE( !strcmp(cached, buf) );
+        }
+    }
+
+#if MO_ENABLE_TIMESTAMP_MILLISECONDS
+    SECTION("Milliseconds") {
+        MicroOcpp::Timestamp t1, t2;
+        REQUIRE( t1.setTime("2024-12-31T23:59:59.900Z") );
+        t2 = t1;
+        t2.addMilliseconds(200);
+        t2.toJsonString(buf, sizeof(buf));
+        REQUIRE( !strcmp(buf, "2025-01-01T00:00:00.100Z") );
+        REQUIRE( t2 - t1 == 0 ); //rounded to the nearest second
+        REQUIRE( t1 < t2 );
+
+        t2.addMilliseconds(-1300);
+        t2.toJsonString(buf, sizeof(buf));
+        REQUIRE( !strcmp(buf, "2024-12-31T23:59:58.800Z") );
+        REQUIRE( t2 - t1 == -1 );
+    }
+
+    SECTION("Fractional seconds") {
+        MicroOcpp::Timestamp t;
+        REQUIRE( t.setTime("2024-01-01T00:00:00.5Z") );
+        t.toJsonString(buf, sizeof(buf));
+        REQUIRE( !strcmp(buf, "2024-01-01T00:00:00.500Z") );
+        REQUIRE( t.setTime("2024-01-01T00:00:00.0429Z") );
+        t.toJsonString(buf, sizeof(buf));
+        REQUIRE( !strcmp(buf, "2024-01-01T00:00:00.042Z") );
+    }
+#endif //MO_ENABLE_TIMESTAMP_MILLISECONDS
+}
@@ -0,0 +1,132 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#include <MicroOcpp/Core/TimerWheel.h>
+#include <MicroOcpp/Platform.h>
+#include <MicroOcpp/Debug.h>
+#include <catch2/catch.hpp>
+#include "./helpers/testHelper.h"
+
+#include <array>
+#include <memory>
+
+TEST_CASE( "Timer wheel" ) {
+    printf("\nRun %s\n",  "Timer wheel");
+
+    mocpp_set_timer(custom_timer_cb);
+    mtime = 1000;
+
+    MicroOcpp::TimerWheel wheel;
+
+    SECTION("Fire once at the deadline") {
+        //deadlines on all levels and in the overflow list
+        const unsigned long delays [] = {0, 1, 63, 64, 65, 100, 4095, 4096, 5000, 300000, 20000000, 40000000};
+        const size_t n = sizeof(delays) / sizeof(delays[0]);
+        std::array<std::unique_ptr<MicroOcpp::Timer>, n> timers;
+        std::array<unsigned long, n> fired;
+        for (size_t i = 0; i < n; i++) {
+            fired[i] = 0;
+            timers[i].reset(new MicroOcpp::Timer([&fired, i] () {
+                REQUIRE( fired[i] == 0 );
+                fired[i] = mtime;
+            }));
+            wheel.schedule(*timers[i], delays[i]);
+        }
+        REQUIRE( wheel.size() == n );
+
+        //advance in irregular steps, never past a deadline without firing it
+        unsigned long start = mtime;
+        unsigned long step = 1;
+        while (mtime - start <= 40000000 + 100000) {
+            REQUIRE( wheel.getNextDelay(1000000000) <= (wheel.size() ? 40000000 : 1000000000) );
+            mtime += step;
+            wheel.advance(mtime);
+            for (size_t i = 0; i < n; i++) {
+                if (fired[i]) {
+                    REQUIRE( fired[i] >= start + delays[i] );
+                } else {
+                    REQUIRE( mtime < start + delays[i] );
+                }
+            }
+            step = (step * 7 + 3) % 150001 + 1;
+        }
+        for (size_t i = 0; i < n; i++) {
+            REQUIRE( fired[i] );
+        }
+        REQUIRE( wheel.size() == 0 );
+    }
+
+    SECTION("Next delay") {
+        MicroOcpp::Timer timer;
+        REQUIRE( wheel.getNextDelay(1000) == 1000 );
+
+        wheel.schedule(timer, 10);
+        REQUIRE( wheel.getNextDelay(1000) == 10 );
+
+        wheel.schedule(timer, 500000);
+        REQUIRE( wheel.getNextDelay(1000) == 1000 ); //never later than the deadline, at most maxDelay
+        REQUIRE( wheel.getNextDelay(1000000) <= 500000 );
+
+        //waking up at the returned delays reaches the deadline
+        size_t nWakeups = 0;
+        while (timer.isScheduled()) {
+            mtime += wheel.getNextDelay(1000000);
+            wheel.advance(mtime);
+            nWakeups++;
+        }
+        REQUIRE( nWakeups <= 8 );
+    }
+
+    SECTION("Cancel and reschedule") {
+        int nFired = 0;
+        MicroOcpp::Timer periodic;
+        periodic.setCallback([&] () {
+            nFired++;
+            wheel.schedule(periodic, 100);
+        });
+        MicroOcpp::Timer canceled ([&nFired] () {nFired += 1000;});
+
+        wheel.schedule(periodic, 100);
+        wheel.schedule(canceled, 50);
+        canceled.cancel();
+        REQUIRE( !canceled.isScheduled() );
+
+        {
+            MicroOcpp::Timer destroyed ([&nFired] () {nFired += 1000;});
+            wheel.schedule(destroyed, 20);
+        }
+
+        for (int i = 0; i < 1000; i++) {
+            mtime += 1;
+            wheel.advance(mtime);
+        }
+        REQUIRE( nFired == 10 );
+        REQUIRE( wheel.size() == 1 );
+
+        //a Timer which is rescheduled as due fires with the next advance()
+        MicroOcpp::Timer immediate;
+        immediate.setCallback([&] () {
+            nFired++;
+            wheel.schedule(immediate, 0);
+        });
+        wheel.schedule(immediate, 0);
+        wheel.advance(mtime);
+        REQUIRE( nFired == 11 );
+        REQUIRE( immediate.isScheduled() );
+        REQUIRE( wheel.getNextDelay(1000) == 0 );
+        immediate.cancel();
+    }
+
+    SECTION("Time goes backwards") {
+        bool fired = false;
+        MicroOcpp::Timer timer ([&fired] () {fired = true;});
+        wheel.schedule(timer, 5000);
+        mtime -= 500;
+        wheel.advance(mtime);
+        REQUIRE( !fired );
+        mtime += 5500;
+        wheel.advance(mtime);
+        REQUIRE( fired );
+    }
+}
@@ -9,6 +9,9 @@
 #include <MicroOcpp/Core/Configuration.h>
 #include <MicroOcpp/Operations/BootNotification.h>
 #include <MicroOcpp/Operations/StatusNotification.h>
+#include <MicroOcpp/Model/Transactions/TransactionStore.h>
+#include <MicroOcpp/Core/FilesystemAdapter.h>
+#include <MicroOcpp/Core/FilesystemUtils.h>
 #include <MicroOcpp/Debug.h>
 #include <catch2/catch.hpp>
 #include "./helpers/testHelper.h"
@@ -97,3 +100,249 @@ TEST_CASE( "Transaction safety" ) {
     }
 
 }
+
+#if MO_ENABLE_TX_JOURNAL
+TEST_CASE( "Transaction journal" ) {
+    printf("\nRun %s\n",  "Transaction journal");
+
+    auto filesystem = makeDefaultFilesystemAdapter(FilesystemOpt::Use_Mount_FormatOnFail);
+    FilesystemUtils::remove_if(filesystem, [] (const char *fname) -> bool {
+        return !strncmp(fname, "tx", strlen("tx"));
+    });
+
+    const char *txFn = MO_FILENAME_PREFIX "tx-1-3.json";
+    const char *journalFn = MO_FILENAME_PREFIX MO_TX_JOURNAL_FN_PREFIX "1.jsn";
+
+    SECTION("Replay records") {
+        size_t txFileSize = 0;
+        {
+            TransactionStore txStore {2, filesystem};
+            auto tx = txStore.createTransaction(1, 3);
+            REQUIRE( tx );
+            REQUIRE( filesystem->stat(txFn, &txFileSize) == 0 );
+
+            tx->setIdTag("mIdTag");
+            tx->setAuthorized();
+            REQUIRE( tx->commit() );
+            tx->getStartSync().setRequested();
+            tx->setMeterStart(100);
+            REQUIRE( tx->commit() );
+            tx->getStartSync().confirm();
+            tx->setTransactionId(1234);
+            REQUIRE( tx->commit() );
+            REQUIRE( tx->commit() ); //no change, no record
+        }
+
+        //the tx file is as created, the changes are in the journal
+        size_t msize = 0;
+        REQUIRE( filesystem->stat(txFn, &msize) == 0 );
+        REQUIRE( msize == txFileSize );
+        REQUIRE( filesystem->stat(journalFn, &msize) == 0 );
+
+        size_t records = 0;
+        if (auto file = filesystem->open(journalFn, "r")) {
+            int c;
+            while ((c = file->read()) >= 0) {
+                records += c == '\n';
+            }
+        }
+        REQUIRE( records == 3 );
+
+        TransactionStore txStore {2, filesystem};
+        auto tx = txStore.getTransaction(1, 3);
+        REQUIRE( tx );
+        REQUIRE( !strcmp(tx->getIdTag(), "mIdTag") );
+        REQUIRE( tx->isAuthorized() );
+        REQUIRE( tx->getStartSync().isRequested() );
+        REQUIRE( tx->getStartSync().isConfirmed() );
+        REQUIRE( tx->getMeterStart() == 100 );
+        REQUIRE( tx->getTransactionId() == 1234 );
+        REQUIRE( !tx->getStopSync().isRequested() );
+    }
+
+    SECTION("Compaction") {
+        {
+            TransactionStore txStore {2, filesystem};
+            auto tx = txStore.createTransaction(1, 3);
+            REQUIRE( tx );
+            tx->setIdTag("mIdTag");
+            for (int i = 1; i <= MO_TX_JOURNAL_MAXRECORDS; i++) {
+                tx->setMeterStart(i);
+                REQUIRE( tx->commit() );
+            }
+
+            //the journal has been written into the tx file
+            size_t msize = 0;
+            REQUIRE( filesystem->stat(journalFn, &msize) != 0 );
+
+            tx->setMeterStart(1000);
+            REQUIRE( tx->commit() );
+            REQUIRE( filesystem->stat(journalFn, &msize) == 0 );
+        }
+
+        auto doc = FilesystemUtils::loadJson(filesystem, txFn);
+        REQUIRE( doc );
+        REQUIRE( ((*doc)["start"]["meter"] | -1) == MO_TX_JOURNAL_MAXRECORDS );
+
+        TransactionStore txStore {2, filesystem};
+        auto tx = txStore.getTransaction(1, 3);
+        REQUIRE( tx );
+        REQUIRE( !strcmp(tx->getIdTag(), "mIdTag") );
+        REQUIRE( tx->getMeterStart() == 1000 );
+    }
+
+    SECTION("Reuse txNr") {
+        {
+            TransactionStore txStore {2, filesystem};
+            auto tx = txStore.createTransaction(1, 3);
+            REQUIRE( tx );
+            tx->setIdTag("mIdTag");
+            tx->setMeterStart(100);
+            REQUIRE( tx->commit() );
+            tx = nullptr;
+
+            REQUIRE( txStore.remove(1, 3) );
+            REQUIRE( !txStore.getTransaction(1, 3) );
+
+            tx = txStore.createTransaction(1, 3);
+            REQUIRE( tx );
+            tx->setIdTag("mIdTag2");
+            REQUIRE( tx->commit() );
+        }
+
+        //the records of the removed tx don't apply on the new tx
+        TransactionStore txStore {2, filesystem};
+        auto tx = txStore.getTransaction(1, 3);
+        REQUIRE( tx );
+        REQUIRE( !strcmp(tx->getIdTag(), "mIdTag2") );
+        REQUIRE( !tx->isMeterStartDefined() );
+    }
+
+    SECTION("Interrupted write") {
+        {
+            TransactionStore txStore {2, filesystem};
+            auto tx = txStore.createTransaction(1, 3);
+            REQUIRE( tx );
+            tx->setIdTag("mIdTag");
+            REQUIRE( tx->commit() );
+        }
+
+        //power loss while appending a record
+        const char *incomplete = "{\"txNr\":3,\"d\":{\"start\":{\"req";
+        if (auto file = filesystem->open(journalFn, "a")) {
+            file->write(incomplete, strlen(incomplete));
+        }
+
+        {
+            TransactionStore txStore {2, filesystem};
+            auto tx = txStore.getTransaction(1, 3);
+            REQUIRE( tx );
+            REQUIRE( !strcmp(tx->getIdTag(), "mIdTag") );
+            REQUIRE( !tx->getStartSync().isRequested() );
+
+            //the journal starts over
+            size_t msize = 0;
+            REQUIRE( filesystem->stat(journalFn, &msize) != 0 );
+
+            tx->getStartSync().setRequested();
+            REQUIRE( tx->commit() );
+        }
+
+        TransactionStore txStore {2, filesystem};
+        auto tx = txStore.getTransaction(1, 3);
+        REQUIRE( tx );
+        REQUIRE( !strcmp(tx->getIdTag(), "mIdTag") );
+        REQUIRE( tx->getStartSync().isRequested() );
+    }
+
+    SECTION("Keep journal on replay errors") {
+        {
+            TransactionStore txStore {2, filesystem};
+            auto tx = txStore.createTransaction(1, 3);
+            REQUIRE( tx );
+            tx->setIdTag("mIdTag");
+            REQUIRE( tx->commit() );
+        }
+
+        //a record which can't be replayed, then a power loss while appending a record. Loading the journal compacts it
+        const char *records = "{\"txNr\":3,\"d\":{\"start\":}\n{\"txNr\":3,\"d\":{\"start\":{\"req";
+        if (auto file = filesystem->open(journalFn, "a")) {
+            file->write(records, strlen(records));
+        }
+
+        size_t journalSize = 0;
+        REQUIRE( filesystem->stat(journalFn, &journalSize) == 0 );
+
+        {
+            TransactionStore txStore {2, filesystem};
+            REQUIRE( !txStore.getTransaction(1, 3) );
+        }
+
+        //the committed records are still there
+        size_t msize = 0;
+        REQUIRE( filesystem->stat(journalFn, &msize) == 0 );
+        REQUIRE( msize == journalSize );
+    }
+
+    SECTION("Tx files removed externally") {
+        {
+            TransactionStore txStore {2, filesystem};
+            auto tx = txStore.createTransaction(1, 3);
+            REQUIRE( tx );
+            tx->setIdTag("mIdTag");
+            REQUIRE( tx->commit() );
+
+            //like ClearCache
+            FilesystemUtils::remove_if(filesystem, [] (const char *fname) -> bool {
+                return !strncmp(fname, "tx", strlen("tx"));
+            });
+
+            tx->setMeterStart(100);
+            REQUIRE( tx->commit() );
+            size_t msize = 0;
+            REQUIRE( filesystem->stat(txFn, &msize) == 0 );
+        }
+
+        TransactionStore txStore {2, filesystem};
+        auto tx = txStore.getTransaction(1, 3);
+        REQUIRE( tx );
+        REQUIRE( !strcmp(tx->getIdTag(), "mIdTag") );
+        REQUIRE( tx->getMeterStart() == 100 );
+    }
+
+    SECTION("Power loss before group commit") {
+        auto groupCommit = makeGroupCommitFilesystemAdapter(filesystem);
+        TransactionStore txStore {2, groupCommit};
+        auto tx = txStore.createTransaction(1, 3);
+        REQUIRE( tx );
+        tx->setIdTag("mIdTag");
+        REQUIRE( tx->commit() );
+        REQUIRE( groupCommit->flush() );
+
+        int meterFlushed = -1;
+        for (int i = 1; i <= 2 * MO_TX_JOURNAL_MAXRECORDS; i++) {
+            tx->setMeterStart(i);
+            REQUIRE( tx->commit() );
+            if (i % 5 == 0) {
+                REQUIRE( groupCommit->flush() );
+                meterFlushed = i;
+            }
+
+            //power loss now. The flash has the state of the last flush, also if the journal has been compacted since
+            TransactionStore txStoreFlash {2, filesystem};
+            auto txFlash = txStoreFlash.getTransaction(1, 3);
+            REQUIRE( txFlash );
+            REQUIRE( !strcmp(txFlash->getIdTag(), "mIdTag") );
+            if (meterFlushed < 0) {
+                REQUIRE( !txFlash->isMeterStartDefined() );
+            } else {
+                REQUIRE( txFlash->getMeterStart() == meterFlushed );
+            }
+        }
+    }
+
+    FilesystemUtils::remove_if(filesystem, [] (const char *fname) -> bool {
+        return !strncmp(fname, "tx", strlen("tx"));
+    });
+}
+#endif //MO_ENABLE_TX_JOURNAL
@@ -0,0 +1,495 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+/*
+ * Fleet load test: runs N simulated charge points in one process against a scripted stand-in CSMS. Each charger
+ * replays plug / authorize / charge / unplug cycles with synthetic meter inputs in simulated time. The CSMS answers
+ * all CALLs after a configurable latency and can be limited to a service rate, so that its queueing shows in the
+ * request latencies.
+ *
+ * Usage: mo_loadtest [-n chargers] [-H simulated hours] [-t threads] [-s step ms] [-l CSMS latency ms]
+ *                    [-r CSMS rate msgs/s, 0 = unlimited] [-f (use filesystem)]
+ *
+ * The results are printed as a JSON document in the format of mo_benchmarks
+ */
+
+#include <MicroOcpp.h>
+#include <MicroOcpp/Core/Connection.h>
+#include <MicroOcpp/Core/Context.h>
+#include <MicroOcpp/Core/FilesystemAdapter.h>
+#include <MicroOcpp/Core/FilesystemUtils.h>
+#include <MicroOcpp/Core/Memory.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <ctime>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace MicroOcpp;
+
+namespace {
+
+/*
+ * Simulated time, shared by all chargers. Only the main thread advances it, while the workers wait at the barrier
+ */
+unsigned long mtime = 10000;
+unsigned long mtime_cb() {
+    return mtime;
+}
+
+const time_t BASE_TIME = 1704067200; //2024-01-01T00:00:00Z
+
+void formatTime(unsigned long ms, char *buf, size_t size) {
+    time_t t = BASE_TIME + (time_t) (ms / 1000);
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    size_t len = strftime(buf, size, "%Y-%m-%dT%H:%M:%S", &tm);
+    snprintf(buf + len, size - len, ".%03luZ", ms % 1000);
+}
+
+/*
+ * Heap accounting of the MO allocations. Lighter than the heap profiler, so that the CPU time isn't distorted
+ */
+std::atomic<size_t> heapCurrent {0};
+std::atomic<size_t> heapPeak {0};
+
+const size_t HEAP_HEADER = alignof(std::max_align_t);
+
+void *countingMalloc(size_t size) {
+    auto block = static_cast<unsigned char*>(malloc(HEAP_HEADER + size));
+    if (!block) {
+        return nullptr;
+    }
+    memcpy(block, &size, sizeof(size_t));
+    size_t current = heapCurrent.fetch_add(size) + size;
+    size_t peak = heapPeak.load();
+    while (current > peak && !heapPeak.compare_exchange_weak(peak, current));
+    return block + HEAP_HEADER;
+}
+
+void countingFree(void *ptr) {
+    if (!ptr) {
+        return;
+    }
+    auto block = static_cast<unsigned char*>(ptr) - HEAP_HEADER;
+    size_t size;
+    memcpy(&size, block, sizeof(size_t));
+    heapCurrent.fetch_sub(size);
+    free(block);
+}
+
+/*
+ * Scripted stand-in CSMS, shared by all chargers. It serves the CALLs in order of arrival with a fixed service
+ * time per message (if rate-limited) and answers each CALL after the network latency
+ */
+class Csms {
+private:
+    std::mutex mutex;
+    unsigned long latencyMs;
+    double serviceMs; //0 = unlimited rate
+    double busyUntil = 0.;
+    int nextTxId = 1;
+    std::map<std::string, size_t> callCounts;
+public:
+    Csms(unsigned long latencyMs, unsigned long rate) : latencyMs(latencyMs), serviceMs(rate ? 1000. / rate : 0.) { }
+
+    //build the response payload and return the time when the response arrives at the charger
+    unsigned long handleCall(const char *action, JsonObject payload, JsonObject response) {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        callCounts[action]++;
+
+        double start = std::max((double) mtime, busyUntil);
+        busyUntil = start + serviceMs;
+
+        if (!strcmp(action, "BootNotification")) {
+            char currentTime [32];
+            formatTime(mtime, currentTime, sizeof(currentTime));
+            response["status"] = "Accepted";
+            response["currentTime"] = currentTime;
+            response["interval"] = 300;
+        } else if (!strcmp(action, "Heartbeat")) {
+            char currentTime [32];
+            formatTime(mtime, currentTime, sizeof(currentTime));
+            response["currentTime"] = currentTime;
+        } else if (!strcmp(action, "Authorize") || !strcmp(action, "StopTransaction")) {
+            response.createNestedObject("idTagInfo")["status"] = "Accepted";
+        } else if (!strcmp(action, "StartTransaction")) {
+            response["transactionId"] = nextTxId++;
+            response.createNestedObject("idTagInfo")["status"] = "Accepted";
+        }
+        //StatusNotification, MeterValues and others: empty payload
+
+        return (unsigned long) busyUntil + latencyMs;
+    }
+
+    const std::map<std::string, size_t>& getCallCounts() {
+        return callCounts;
+    }
+};
+
+/*
+ * In-process transport between one charger and the CSMS. Responses are delivered in loop() once they're due
+ */
+class CsmsConnection : public Connection {
+private:
+    Csms& csms;
+    ReceiveTXTcallback receiveTXT;
+
+    struct Pending {
+        unsigned long due;
+        unsigned long sentAt;
+        std::string msg;
+    };
+    std::deque<Pending> pending;
+public:
+    std::vector<double> latencies; //time from sending a CALL until its response arrives, in simulated ms
+    size_t callsSent = 0;
+
+    CsmsConnection(Csms& csms) : csms(csms) { }
+
+    void loop() override {
+        while (!pending.empty() && (long) (mtime - pending.front().due) >= 0) {
+            auto response = std::move(pending.front());
+            pending.pop_front();
+            latencies.push_back((double) (mtime - response.sentAt));
+            if (receiveTXT) {
+                receiveTXT(response.msg.c_str(), response.msg.length());
+            }
+        }
+    }
+
+    bool sendTXT(const char *msg, size_t length) override {
+        DynamicJsonDocument request (length * 2 + 256);
+        if (deserializeJson(request, msg, length) || !request.is<JsonArray>()) {
+            return false;
+        }
+        if (request[0] != 2) {
+            return true; //CALLRESULT or CALLERROR, the CSMS doesn't send CALLs
+        }
+
+        callsSent++;
+
+        DynamicJsonDocument response (512);
+        response.add(3);
+        response.add(request[1]);
+        JsonObject payload = response.createNestedObject();
+        unsigned long due = csms.handleCall(request[2] | "", request[3], payload);
+
+        Pending entry;
+        entry.due = due;
+        entry.sentAt = mtime;
+        serializeJson(response, entry.msg);
+        pending.push_back(std::move(entry));
+        return true;
+    }
+
+    void setReceiveTXTcallback(ReceiveTXTcallback &receiveTXT) override {
+        this->receiveTXT = receiveTXT;
+    }
+
+    unsigned long getLastConnected() override {
+        return 0;
+    }
+};
+
+/*
+ * Simulated charger with one connector. Replays charging sessions with random durations and charging powers
+ */
+class Charger {
+private:
+    uint32_t rngState;
+
+    enum class Phase {Idle, Plugged, Charging, Finishing} phase = Phase::Idle;
+    unsigned long phaseEnd = 0;
+    unsigned long lastUpdate = 0;
+
+    bool plugged = false;
+    float chargePower = 0.f; //W
+    float power = 0.f; //W
+    double energy = 0.; //Wh
+
+    char idTag [21];
+
+    unsigned long random(unsigned long min, unsigned long max) {
+        rngState = rngState * 1664525U + 1013904223U;
+        return min + (rngState >> 8) % (max - min + 1);
+    }
+public:
+    CsmsConnection connection;
+    Context *instance = nullptr;
+    size_t sessions = 0;
+
+    Charger(Csms& csms, unsigned int index) : rngState(index * 2654435761U + 1), connection(csms) {
+        snprintf(idTag, sizeof(idTag), "TAG%u", index);
+        phaseEnd = mtime + random(0, 60 * 60 * 1000); //spread the first sessions over the first hour
+        lastUpdate = mtime;
+    }
+
+    void initialize(std::shared_ptr<FilesystemAdapter> filesystem) {
+        mocpp_select_instance(nullptr);
+        mocpp_initialize(connection, ChargerCredentials("LoadTest Charger", "MicroOcpp"), filesystem);
+        instance = getOcppContext();
+
+        setConnectorPluggedInput([this] () {return plugged;});
+        setEnergyMeterInput([this] () {return (int) energy;});
+        setPowerMeterInput([this] () {return power;});
+    }
+
+    void deinitialize() {
+        mocpp_select_instance(instance);
+        mocpp_deinitialize();
+        instance = nullptr;
+    }
+
+    //execute script and loop MO. The instance must be selected
+    void update() {
+        energy += power * (mtime - lastUpdate) / 3600000.;
+        lastUpdate = mtime;
+
+        bool due = (long) (mtime - phaseEnd) >= 0;
+
+        switch (phase) {
+            case Phase::Idle:
+                if (due) {
+                    plugged = true;
+                    phase = Phase::Plugged;
+                    phaseEnd = mtime + random(5, 30) * 1000;
+                }
+                break;
+            case Phase::Plugged:
+                if (due) {
+                    beginTransaction(idTag);
+                    chargePower = (float) random(3700, 22000);
+                    phase = Phase::Charging;
+                    phaseEnd = mtime + random(20, 120) * 60 * 1000;
+                }
+                break;
+            case Phase::Charging:
+                power = ocppPermitsCharge() ? chargePower : 0.f;
+                if (due) {
+                    endTransaction(idTag, "Local");
+                    power = 0.f;
+                    phase = Phase::Finishing;
+                    phaseEnd = mtime + random(10, 60) * 1000;
+                }
+                break;
+            case Phase::Finishing:
+                if (due) {
+                    plugged = false;
+                    sessions++;
+                    phase = Phase::Idle;
+                    phaseEnd = mtime + random(10, 60) * 60 * 1000;
+                }
+                break;
+        }
+
+        mocpp_loop();
+    }
+};
+
+//synchronizes the main thread and the workers at each simulation step
+class StepBarrier {
+private:
+    std::mutex mutex;
+    std::condition_variable cv;
+    unsigned int count;
+    unsigned int waiting = 0;
+    unsigned int generation = 0;
+public:
+    StepBarrier(unsigned int count) : count(count) { }
+
+    void arriveAndWait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        unsigned int gen = generation;
+        if (++waiting == count) {
+            waiting = 0;
+            generation++;
+            cv.notify_all();
+        } else {
+            cv.wait(lock, [this, gen] () {return gen != generation;});
+        }
+    }
+};
+
+bool firstResult = true;
+
+void report(const char *metric, double value, const char *unit) {
+    printf("%s\n    {\"benchmark\":\"LoadTest.Fleet\",\"metric\":\"%s\",\"value\":%.6g,\"unit\":\"%s\"}",
+            firstResult ? "" : ",",
+            metric,
+            value,
+            unit);
+    firstResult = false;
+}
+
+double percentile(std::vector<double>& samples, double p) {
+    if (samples.empty()) {
+        return 0.;
+    }
+    std::sort(samples.begin(), samples.end());
+    size_t index = (size_t) ((p / 100.) * (samples.size() - 1) + 0.5);
+    return samples[std::min(index, samples.size() - 1)];
+}
+
+} //end namespace
+
+int main(int argc, char **argv) {
+
+    unsigned int nChargers = 100;
+    double hours = 1.;
+    unsigned int nThreads = 1;
+    unsigned long stepMs = 100;
+    unsigned long latencyMs = 50;
+    unsigned long rate = 0;
+    bool useFilesystem = false;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *val = i + 1 < argc ? argv[i + 1] : "";
+        if (!strcmp(arg, "-n")) {
+            nChargers = (unsigned int) strtoul(val, nullptr, 10); i++;
+        } else if (!strcmp(arg, "-H")) {
+            hours = strtod(val, nullptr); i++;
+        } else if (!strcmp(arg, "-t")) {
+            nThreads = std::max(1U, (unsigned int) strtoul(val, nullptr, 10)); i++;
+        } else if (!strcmp(arg, "-s")) {
+            stepMs = std::max(1UL, strtoul(val, nullptr, 10)); i++;
+        } else if (!strcmp(arg, "-l")) {
+            latencyMs = strtoul(val, nullptr, 10); i++;
+        } else if (!strcmp(arg, "-r")) {
+            rate = strtoul(val, nullptr, 10); i++;
+        } else if (!strcmp(arg, "-f")) {
+            useFilesystem = true;
+        } else {
+            fprintf(stderr, "usage: %s [-n chargers] [-H hours] [-t threads] [-s step ms] [-l CSMS latency ms] [-r CSMS rate msgs/s] [-f]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    mo_mem_set_malloc_free(countingMalloc, countingFree);
+    mocpp_set_timer(mtime_cb);
+
+    std::shared_ptr<FilesystemAdapter> filesystem;
+    if (useFilesystem) {
+        filesystem = makeDefaultFilesystemAdapter(FilesystemOpt::Use_Mount_FormatOnFail);
+        FilesystemUtils::remove_if(filesystem, [] (const char*) {return true;});
+    }
+
+    Csms csms {latencyMs, rate};
+
+    std::vector<std::unique_ptr<Charger>> chargers;
+    for (unsigned int i = 0; i < nChargers; i++) {
+        chargers.emplace_back(new Charger(csms, i));
+        char prefix [16];
+        snprintf(prefix, sizeof(prefix), "cp%u-", i);
+        chargers.back()->initialize(filesystem ? makePrefixedFilesystemAdapter(filesystem, prefix) : nullptr);
+    }
+
+    size_t heapInitialized = heapCurrent.load();
+
+    unsigned long simEnd = mtime + (unsigned long) (hours * 3600. * 1000.);
+
+    auto wallStart = std::chrono::steady_clock::now();
+    std::clock_t cpuStart = std::clock();
+
+    //each worker updates a fixed share of the chargers per step
+    auto runShare = [&chargers, nThreads] (unsigned int worker) {
+        for (size_t i = worker; i < chargers.size(); i += nThreads) {
+            mocpp_select_instance(chargers[i]->instance);
+            chargers[i]->update();
+        }
+    };
+
+    if (nThreads <= 1) {
+        while ((long) (simEnd - mtime) > 0) {
+            mtime += stepMs;
+            runShare(0);
+        }
+    } else {
+        StepBarrier barrier {nThreads + 1};
+        std::atomic<bool> finished {false};
+
+        std::vector<std::thread> workers;
+        for (unsigned int w = 0; w < nThreads; w++) {
+            workers.emplace_back([&barrier, &finished, &runShare, w] () {
+                for (;;) {
+                    barrier.arriveAndWait(); //step start
+                    if (finished) {
+                        break;
+                    }
+                    runShare(w);
+                    barrier.arriveAndWait(); //step end
+                }
+            });
+        }
+
+        while ((long) (simEnd - mtime) > 0) {
+            mtime += stepMs;
+            barrier.arriveAndWait();
+            barrier.arriveAndWait();
+        }
+
+        finished = true;
+        barrier.arriveAndWait();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    double cpuSeconds = (double) (std::clock() - cpuStart) / CLOCKS_PER_SEC;
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+    std::vector<double> latencies;
+    size_t calls = 0;
+    size_t sessions = 0;
+    for (auto& charger : chargers) {
+        latencies.insert(latencies.end(), charger->connection.latencies.begin(), charger->connection.latencies.end());
+        calls += charger->connection.callsSent;
+        sessions += charger->sessions;
+    }
+
+    double chargerHours = nChargers * hours;
+
+    printf("{\"benchmarks\":[");
+    report("chargers", nChargers, "count");
+    report("threads", nThreads, "count");
+    report("simulated_time", hours, "h");
+    report("wall_time", wallSeconds, "s");
+    report("sessions", (double) sessions, "count");
+    report("messages", (double) calls, "count");
+    report("throughput", wallSeconds > 0. ? calls / wallSeconds : 0., "msgs/s");
+    report("latency_p50", percentile(latencies, 50.), "ms");
+    report("latency_p99", percentile(latencies, 99.), "ms");
+    report("cpu_time_per_charger_hour", chargerHours > 0. ? cpuSeconds * 1000. / chargerHours : 0., "ms");
+    report("heap_initialized_per_charger", nChargers ? (double) heapInitialized / nChargers : 0., "B");
+    report("heap_peak_per_charger", nChargers ? (double) heapPeak.load() / nChargers : 0., "B");
+    for (auto& count : csms.getCallCounts()) {
+        std::string metric = "messages." + count.first;
+        report(metric.c_str(), (double) count.second, "count");
+    }
+    printf("\n]}\n");
+
+    for (auto& charger : chargers) {
+        charger->deinitialize();
+    }
+    chargers.clear();
+
+    if (filesystem) {
+        FilesystemUtils::remove_if(filesystem, [] (const char*) {return true;});
+    }
+
+    return 0;
+}
@@ -0,0 +1,663 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#include "benchmark.h"
+
+#include <MicroOcpp.h>
+#include <MicroOcpp/Core/Connection.h>
+#include <MicroOcpp/Core/Context.h>
+#include <MicroOcpp/Core/Request.h>
+#include <MicroOcpp/Core/Time.h>
+#include <MicroOcpp/Core/TimerWheel.h>
+#include <MicroOcpp/Core/ConfigurationContainerFlash.h>
+#include <MicroOcpp/Core/FilesystemAdapter.h>
+#include <MicroOcpp/Core/FilesystemUtils.h>
+#include <MicroOcpp/Operations/CustomOperation.h>
+#include <MicroOcpp/Model/Model.h>
+#include <MicroOcpp/Model/Authorization/AuthorizationList.h>
+#include <MicroOcpp/Model/SmartCharging/SmartChargingService.h>
+#include <MicroOcpp/Model/Transactions/TransactionStore.h>
+#include <MicroOcpp/Model/Transactions/TransactionDeserialize.h>
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <stdio.h>
+
+/*
+ * Micro-benchmarks of the core primitives which run on the hot paths of mocpp_loop() and the message handling.
+ * Each metric is the median time per call in ns over several batches
+ */
+
+using namespace MicroOcpp;
+using namespace MicroOcpp::Benchmark;
+
+namespace {
+
+volatile int sink; //keeps the compiler from optimizing the measured calls away
+
+//Connection which accepts all outgoing CALLs and discards the responses to incoming CALLs
+class AcceptingConnection : public Connection {
+private:
+    ReceiveTXTcallback receiveTXT;
+    std::deque<std::string> responses;
+public:
+    void loop() override {
+        while (!responses.empty()) {
+            auto msg = std::move(responses.front());
+            responses.pop_front();
+            receiveTXT(msg.c_str(), msg.length());
+        }
+    }
+
+    bool sendTXT(const char *msg, size_t length) override {
+        if (length > 5 && !strncmp(msg, "[2,\"", 4)) {
+            const char *idBegin = msg + 4;
+            const char *idEnd = strchr(idBegin, '\"');
+            if (idEnd) {
+                responses.push_back("[3,\"" + std::string(idBegin, idEnd - idBegin) +
+                        "\",{\"status\":\"Accepted\",\"currentTime\":\"2024-01-01T00:00:00.000Z\",\"interval\":3600}]");
+            }
+        }
+        return true;
+    }
+
+    void setReceiveTXTcallback(ReceiveTXTcallback &receiveTXT) override {
+        this->receiveTXT = receiveTXT;
+    }
+
+    unsigned long getLastConnected() override {
+        return 0;
+    }
+
+    //pass a server message to MO. MO handles it in RequestQueue::receiveMessage()
+    bool receive(const char *msg, size_t length) {
+        return receiveTXT(msg, length);
+    }
+};
+
+void initializeCharger(AcceptingConnection& connection) {
+    clearFilesystem();
+    mocpp_set_timer(mtime_cb);
+    mocpp_initialize(connection, ChargerCredentials("benchmark-runner"));
+    for (int i = 0; i < 100; i++) {
+        mtime += 10;
+        mocpp_loop(); //BootNotification and initial StatusNotifications
+    }
+}
+
+void deinitializeCharger() {
+    mocpp_deinitialize();
+    clearFilesystem();
+}
+
+void runReceiveMessage(AcceptingConnection& connection, const char *name, const char *format, size_t nIterations) {
+    std::vector<double> samples;
+    for (size_t i = 0; i < nIterations; i++) {
+        char msg [512];
+        int len = snprintf(msg, sizeof(msg), format, i);
+
+        auto t_start = now_ns();
+        connection.receive(msg, (size_t) len);
+        auto t_end = now_ns();
+        samples.push_back((double) (t_end - t_start));
+
+        mtime += 1;
+        mocpp_loop(); //send response outside of the measurement
+    }
+
+    char metric [64];
+    snprintf(metric, sizeof(metric), "%s.time", name);
+    report(metric, percentile(samples, 50.), "ns/op");
+    snprintf(metric, sizeof(metric), "%s.time_p99", name);
+    report(metric, percentile(samples, 99.), "ns/op");
+}
+
+std::unique_ptr<ChargingProfile> makeChargingProfile(int id, const char *purpose, const char *kind, size_t nPeriods) {
+    auto doc = makeJsonDoc("Benchmark", 4096);
+    JsonObject json = doc->to<JsonObject>();
+    json["chargingProfileId"] = id;
+    json["stackLevel"] = 0;
+    json["chargingProfilePurpose"] = purpose;
+    json["chargingProfileKind"] = kind;
+    if (!strcmp(kind, "Recurring")) {
+        json["recurrencyKind"] = "Daily";
+    }
+    JsonObject schedule = json.createNestedObject("chargingSchedule");
+    schedule["startSchedule"] = "2024-01-01T00:00:00.000Z";
+    schedule["chargingRateUnit"] = "W";
+    JsonArray periods = schedule.createNestedArray("chargingSchedulePeriod");
+    for (size_t i = 0; i < nPeriods; i++) {
+        JsonObject period = periods.createNestedObject();
+        period["startPeriod"] = (int) (i * 3600);
+        period["limit"] = 4000 + (int) (i % 8) * 1000;
+    }
+    return loadChargingProfile(json);
+}
+
+//FilesystemAdapter decorator which counts the written bytes and the opened files
+class CountingFilesystem : public FilesystemAdapter {
+private:
+    class CountingFile : public FileAdapter {
+    private:
+        std::unique_ptr<FileAdapter> file;
+        size_t& bytesWritten;
+    public:
+        CountingFile(std::unique_ptr<FileAdapter> file, size_t& bytesWritten) : file(std::move(file)), bytesWritten(bytesWritten) { }
+        size_t read(char *buf, size_t len) override {return file->read(buf, len);}
+        size_t write(const char *buf, size_t len) override {
+            auto ret = file->write(buf, len);
+            bytesWritten += ret;
+            return ret;
+        }
+        size_t seek(size_t offset) override {return file->seek(offset);}
+        int read() override {return file->read();}
+    };
+
+    std::shared_ptr<FilesystemAdapter> filesystem;
+public:
+    size_t bytesWritten = 0;
+    size_t filesWritten = 0;
+
+    CountingFilesystem(std::shared_ptr<FilesystemAdapter> filesystem) : filesystem(filesystem) { }
+
+    int stat(const char *path, size_t *size) override {return filesystem->stat(path, size);}
+    std::unique_ptr<FileAdapter> open(const char *fn, const char *mode) override {
+        auto file = filesystem->open(fn, mode);
+        if (!file) {
+            return nullptr;
+        }
+        if (strcmp(mode, "r")) {
+            filesWritten++;
+        }
+        return std::unique_ptr<FileAdapter>(new CountingFile(std::move(file), bytesWritten));
+    }
+    bool remove(const char *fn) override {return filesystem->remove(fn);}
+    bool rename(const char *from, const char *to) override {return filesystem->rename(from, to);}
+    bool flush() override {return filesystem->flush();}
+    int ftw_root(std::function<int(const char *fpath)> fn) override {return filesystem->ftw_root(fn);}
+};
+
+//state changes of a charging session like the Connector commits them. commit is called after each step
+void runChargingSession(Transaction& tx, const std::function<void()>& commit) {
+    Timestamp t;
+    t.setTime("2024-01-01T12:00:00.000Z");
+
+    tx.setIdTag("mIdTag");
+    tx.setBeginTimestamp(t);
+    commit();
+    tx.setAuthorized();
+    commit();
+    tx.setMeterStart(1000);
+    tx.setStartTimestamp(t);
+    tx.setStartBootNr(1);
+    commit();
+    tx.getStartSync().setRequested();
+    tx.getStartSync().setOpNr(10);
+    commit();
+    tx.getStartSync().setAttemptNr(1);
+    tx.getStartSync().setAttemptTime(t);
+    commit();
+    tx.getStartSync().confirm();
+    tx.setTransactionId(1234);
+    commit();
+
+    t += 3600;
+    tx.setStopIdTag("mIdTag");
+    tx.setMeterStop(12000);
+    tx.setStopTimestamp(t);
+    tx.setStopBootNr(1);
+    tx.setStopReason("Local");
+    commit();
+    tx.setInactive();
+    commit();
+    tx.getStopSync().setRequested();
+    tx.getStopSync().setOpNr(11);
+    commit();
+    tx.getStopSync().setAttemptNr(1);
+    tx.getStopSync().setAttemptTime(t);
+    commit();
+    tx.getStopSync().confirm();
+    commit();
+}
+
+} //namespace
+
+/*
+ * RequestQueue::receiveMessage() of incoming CALLs: deserialization, operation lookup, request creation and
+ * processing of the payload. The responses are sent outside of the measurement
+ */
+MO_BENCHMARK("HotPath.ReceiveMessage") {
+    AcceptingConnection connection;
+    initializeCharger(connection);
+
+    runReceiveMessage(connection, "DataTransfer",
+            "[2,\"bench-%zu\",\"DataTransfer\",{\"vendorId\":\"Benchmark\",\"messageId\":\"Bench\",\"data\":\"0123456789abcdef\"}]",
+            10000);
+    runReceiveMessage(connection, "GetConfiguration",
+            "[2,\"bench-%zu\",\"GetConfiguration\",{\"key\":[\"HeartbeatInterval\",\"MeterValueSampleInterval\"]}]",
+            10000);
+    runReceiveMessage(connection, "CallResult_unmatched",
+            "[3,\"bench-%zu\",{\"status\":\"Accepted\"}]",
+            10000);
+
+    deinitializeCharger();
+}
+
+/*
+ * Request::createRequest() and Request::createResponse() including the serialization of the OCPP-J message
+ */
+MO_BENCHMARK("HotPath.RequestSerialization") {
+    AcceptingConnection connection;
+    initializeCharger(connection);
+
+    const size_t nIterations = 10000;
+
+    auto request = makeRequest(new Ocpp16::CustomOperation("StatusNotification",
+        [] () {
+            auto doc = makeJsonDoc("Benchmark", JSON_OBJECT_SIZE(5));
+            JsonObject payload = doc->to<JsonObject>();
+            payload["connectorId"] = 1;
+            payload["errorCode"] = "NoError";
+            payload["status"] = "Charging";
+            payload["timestamp"] = "2024-01-01T00:00:00.000Z";
+            return doc;
+        }, [] (JsonObject) {}));
+
+    auto out = initJsonDoc("Benchmark");
+    char buf [512];
+
+    report("createRequest.time", timePerOp(nIterations, [&request, &out] () {
+        sink = (int) request->createRequest(out);
+    }), "ns/op");
+    report("createRequest_serialize.time", timePerOp(nIterations, [&request, &out, &buf] () {
+        request->createRequest(out);
+        sink = (int) serializeJson(out, buf, sizeof(buf));
+    }), "ns/op");
+
+    auto response = makeRequest(new Ocpp16::CustomOperation("DataTransfer",
+        [] (JsonObject) {},
+        [] () {
+            auto doc = makeJsonDoc("Benchmark", JSON_OBJECT_SIZE(2));
+            JsonObject payload = doc->to<JsonObject>();
+            payload["status"] = "Accepted";
+            payload["data"] = "0123456789abcdef";
+            return doc;
+        }));
+    {
+        const char *msg = "[2,\"bench-response\",\"DataTransfer\",{\"vendorId\":\"Benchmark\"}]";
+        auto doc = initJsonDoc("Benchmark", 256);
+        deserializeJson(doc, msg);
+        response->receiveRequest(doc.as<JsonArray>());
+    }
+
+    report("createResponse.time", timePerOp(nIterations, [&response, &out] () {
+        sink = (int) response->createResponse(out);
+    }), "ns/op");
+    report("createResponse_serialize.time", timePerOp(nIterations, [&response, &out, &buf] () {
+        response->createResponse(out);
+        sink = (int) serializeJson(out, buf, sizeof(buf));
+    }), "ns/op");
+
+    request.reset();
+    response.reset();
+    deinitializeCharger();
+}
+
+/*
+ * Timestamp parsing, formatting and arithmetic
+ */
+MO_BENCHMARK("HotPath.Timestamp") {
+    const size_t nIterations = 100000;
+
+    Timestamp t;
+    report("parse.time", timePerOp(nIterations, [&t] () {
+        sink = t.setTime("2024-03-15T12:34:56.789Z");
+    }), "ns/op");
+
+    char buf [JSONDATE_LENGTH + 1];
+    report("format.time", timePerOp(nIterations, [&t, &buf] () {
+        sink = t.toJsonString(buf, sizeof(buf));
+    }), "ns/op");
+
+    Timestamp t2 = t;
+    report("add_seconds.time", timePerOp(nIterations, [&t2] () {
+        t2 += 3601;
+    }), "ns/op");
+
+    report("add_days.time", timePerOp(nIterations, [&t, &t2] () {
+        t2 = t + 86400 * 40;
+    }), "ns/op");
+
+    report("difference.time", timePerOp(nIterations, [&t, &t2] () {
+        sink = t2 - t;
+    }), "ns/op");
+
+    report("compare.time", timePerOp(nIterations, [&t, &t2] () {
+        sink = t < t2;
+    }), "ns/op");
+}
+
+/*
+ * Smart Charging limit calculation with a ChargePointMaxProfile and a TxDefaultProfile of 24 periods each. The
+ * limit calculation is measured as one loop() of the SmartChargingService after invalidating the last limit, which
+ * recalculates the limit of the charger and all connectors
+ */
+MO_BENCHMARK("HotPath.SmartCharging") {
+    AcceptingConnection connection;
+    initializeCharger(connection);
+
+    setSmartChargingPowerOutput([] (float) {}, 1);
+    auto scService = getOcppContext()->getModel().getSmartChargingService();
+    if (!scService) {
+        deinitializeCharger();
+        return;
+    }
+
+    scService->setChargingProfile(0, makeChargingProfile(1, "ChargePointMaxProfile", "Absolute", MO_ChargingScheduleMaxPeriods));
+    scService->setChargingProfile(1, makeChargingProfile(2, "TxDefaultProfile", "Recurring", MO_ChargingScheduleMaxPeriods));
+
+    const size_t nIterations = 10000;
+
+    std::vector<double> samples;
+    for (size_t i = 0; i < nIterations; i++) {
+        scService->clearChargingProfile([] (int, int, ChargingProfilePurposeType, int) {return false;}); //invalidate limit
+        auto t_start = now_ns();
+        scService->loop();
+        auto t_end = now_ns();
+        samples.push_back((double) (t_end - t_start));
+    }
+    report("calculateLimit.time", percentile(samples, 50.), "ns/op");
+
+    report("getCompositeSchedule_1h.time", timePerOp(1000, [scService] () {
+        sink = scService->getCompositeSchedule(1, 3600, ChargingRateUnitType_Optional::Watt) != nullptr;
+    }), "ns/op");
+    report("getCompositeSchedule_24h.time", timePerOp(1000, [scService] () {
+        sink = scService->getCompositeSchedule(1, 86400, ChargingRateUnitType_Optional::Watt) != nullptr;
+    }), "ns/op");
+
+    deinitializeCharger();
+}
+
+/*
+ * Lookup in a full local authorization list
+ */
+MO_BENCHMARK("HotPath.AuthorizationList") {
+    const size_t nEntries = MO_LocalAuthListMaxLength;
+
+    auto doc = makeJsonDoc("Benchmark", JSON_ARRAY_SIZE(nEntries) + nEntries * (JSON_OBJECT_SIZE(2) + JSON_OBJECT_SIZE(1) + 32));
+    JsonArray list = doc->to<JsonArray>();
+    for (size_t i = 0; i < nEntries; i++) {
+        char idTag [21];
+        snprintf(idTag, sizeof(idTag), "IDTAG%06zu", i);
+        JsonObject entry = list.createNestedObject();
+        entry["idTag"] = idTag;
+        entry["idTagInfo"]["status"] = "Accepted";
+    }
+
+    AuthorizationList authList;
+    if (!authList.readJson(list, 1)) {
+        report("setup_failed", 1, "bool");
+        return;
+    }
+
+    const size_t nIterations = 100000;
+    size_t i = 0;
+    report("get_hit.time", timePerOp(nIterations, [&authList, &i, nEntries] () {
+        char idTag [21];
+        snprintf(idTag, sizeof(idTag), "IDTAG%06zu", (i++) % nEntries);
+        sink = authList.get(idTag) != nullptr;
+    }), "ns/op");
+    report("get_miss.time", timePerOp(nIterations, [&authList] () {
+        sink = authList.get("UNKNOWN00001") != nullptr;
+    }), "ns/op");
+}
+
+/*
+ * Configuration lookup by key in a file-backed container
+ */
+MO_BENCHMARK("HotPath.ConfigurationLookup") {
+    clearFilesystem();
+    auto filesystem = makeDefaultFilesystemAdapter(FilesystemOpt::Use_Mount_FormatOnFail);
+
+    const size_t nConfigs = 50;
+
+    std::vector<std::string> keys; //the container doesn't copy the keys
+    for (size_t i = 0; i < nConfigs; i++) {
+        keys.push_back("BenchmarkConfigurationKey" + std::to_string(i));
+    }
+
+    auto container = makeConfigurationContainerFlash(filesystem, MO_FILENAME_PREFIX "bench-config.jsn", true);
+    for (size_t i = 0; i < nConfigs; i++) {
+        if (auto config = container->createConfiguration(TConfig::Int, keys[i].c_str())) {
+            config->setInt((int) i);
+        }
+    }
+
+    const size_t nIterations = 100000;
+    size_t i = 0;
+    report("getConfiguration.time", timePerOp(nIterations, [&container, &keys, &i, nConfigs] () {
+        sink = container->getConfiguration(keys[(i++) % nConfigs].c_str()) != nullptr;
+    }), "ns/op");
+    report("getConfiguration_miss.time", timePerOp(nIterations, [&container] () {
+        sink = container->getConfiguration("UnknownConfigurationKey") != nullptr;
+    }), "ns/op");
+
+    container.reset();
+    clearFilesystem();
+}
+
+/*
+ * JSON file persistence with the POSIX filesystem adapter
+ */
+MO_BENCHMARK("HotPath.FilesystemJson") {
+    clearFilesystem();
+    auto filesystem = makeDefaultFilesystemAdapter(FilesystemOpt::Use_Mount_FormatOnFail);
+
+    for (size_t nEntries : {8, 64}) {
+        auto doc = initJsonDoc("Benchmark", JSON_OBJECT_SIZE(1) + JSON_ARRAY_SIZE(nEntries) + nEntries * (JSON_OBJECT_SIZE(3) + 48));
+        JsonArray configurations = doc.createNestedArray("configurations");
+        for (size_t i = 0; i < nEntries; i++) {
+            char key [48];
+            snprintf(key, sizeof(key), "BenchmarkConfigurationKey%zu", i);
+            JsonObject entry = configurations.createNestedObject();
+            entry["type"] = "int";
+            entry["key"] = key;
+            entry["value"] = (int) i;
+        }
+
+        const char *fn = MO_FILENAME_PREFIX "bench-json.jsn";
+
+        char metric [64];
+        snprintf(metric, sizeof(metric), "storeJson_%zu.time", nEntries);
+        report(metric, timePerOp(200, [&filesystem, &doc, fn] () {
+            sink = FilesystemUtils::storeJson(filesystem, fn, doc);
+        }), "ns/op");
+
+        snprintf(metric, sizeof(metric), "loadJson_%zu.time", nEntries);
+        report(metric, timePerOp(200, [&filesystem, fn] () {
+            sink = FilesystemUtils::loadJson(filesystem, fn, "Benchmark") != nullptr;
+        }), "ns/op");
+
+        //baseline of storeJson: overwrite the file in place, not crash-safe
+        snprintf(metric, sizeof(metric), "storeJson_inplace_%zu.time", nEntries);
+        report(metric, timePerOp(200, [&filesystem, &doc, fn] () {
+            auto file = filesystem->open(fn, "w");
+            ArduinoJsonFileAdapter fileWriter {file.get()};
+            sink = serializeJson(doc, fileWriter) >= 2;
+        }), "ns/op");
+
+        //a loop which stores the same file 4 times, committed by one flush
+        auto groupCommit = makeGroupCommitFilesystemAdapter(filesystem);
+        snprintf(metric, sizeof(metric), "storeJson_groupcommit_4x%zu.time", nEntries);
+        report(metric, timePerOp(50, [&groupCommit, &doc, fn] () {
+            for (int i = 0; i < 4; i++) {
+                sink = FilesystemUtils::storeJson(groupCommit, fn, doc);
+            }
+            sink = groupCommit->flush();
+        }), "ns/op");
+    }
+
+    clearFilesystem();
+}
+
+/*
+ * Bookkeeping of the heap profiler per allocation: malloc and free of a tagged block with a few hundred live
+ * blocks, and the tagging of a MemoryManaged object on the heap and on the stack
+ */
+MO_BENCHMARK("HotPath.HeapProfiler") {
+
+    std::vector<void*> live;
+    for (size_t i = 0; i < 500; i++) {
+        char tag [32];
+        snprintf(tag, sizeof(tag), "Benchmark.Live%zu", i % 50);
+        live.push_back(MO_MALLOC(tag, 16 + i % 64));
+    }
+
+    report("malloc_free.time", timePerOp(10000, [] () {
+        void *ptr = MO_MALLOC("Benchmark.Profiler", 64);
+        sink = ptr != nullptr;
+        MO_FREE(ptr);
+    }), "ns/op");
+
+    report("MemoryManaged_heap.time", timePerOp(10000, [] () {
+        auto obj = new MemoryManaged("Benchmark.Profiler");
+        sink = obj != nullptr;
+        delete obj;
+    }), "ns/op");
+
+    report("MemoryManaged_stack.time", timePerOp(10000, [] () {
+        MemoryManaged obj {"Benchmark.Profiler"};
+        sink = sizeof(obj);
+    }), "ns/op");
+
+    for (auto ptr : live) {
+        MO_FREE(ptr);
+    }
+}
+
+/*
+ * Periodic deadlines with intervals between 1 s and 1 h. Compares the time per loop with 1 ms steps of the
+ * TimerWheel with polling each deadline like the services did before, for 10, 100 and 1000 deadlines
+ */
+MO_BENCHMARK("HotPath.TimerWheel") {
+    const size_t nIterations = 100000;
+    mocpp_set_timer(mtime_cb);
+
+    {
+        TimerWheel wheel;
+        Timer timer;
+        report("schedule_cancel.time", timePerOp(nIterations, [&wheel, &timer] () {
+            wheel.schedule(timer, 30000);
+            timer.cancel();
+        }), "ns/op");
+    }
+
+    const size_t nDeadlines [] = {10, 100, 1000};
+    for (auto n : nDeadlines) {
+        std::vector<unsigned long> intervals;
+        for (size_t i = 0; i < n; i++) {
+            intervals.push_back(1000 + (i * 7919) % 3599000);
+        }
+
+        TimerWheel wheel;
+        std::vector<std::unique_ptr<Timer>> timers;
+        for (size_t i = 0; i < n; i++) {
+            timers.emplace_back(new Timer());
+            auto timer = timers.back().get();
+            auto interval = intervals[i];
+            timer->setCallback([&wheel, timer, interval] () {
+                sink++;
+                wheel.schedule(*timer, interval);
+            });
+            wheel.schedule(*timer, interval);
+        }
+
+        char metric [64];
+        snprintf(metric, sizeof(metric), "advance_%zu.time", n);
+        report(metric, timePerOp(nIterations, [&wheel] () {
+            mtime++;
+            wheel.advance(mtime);
+        }), "ns/op");
+
+        std::vector<unsigned long> lastRun (n, mtime);
+        snprintf(metric, sizeof(metric), "poll_%zu.time", n);
+        report(metric, timePerOp(nIterations, [&intervals, &lastRun, n] () {
+            mtime++;
+            for (size_t i = 0; i < n; i++) {
+                if (mtime - lastRun[i] >= intervals[i]) {
+                    lastRun[i] = mtime;
+                    sink++;
+                }
+            }
+        }), "ns/op");
+    }
+}
+
+/*
+ * Flash writes per charging session of 11 commits: rewriting the full tx file per commit like before, compared
+ * with the ConnectorTransactionStore which appends the changes to the journal and compacts it periodically.
+ * Averaged over 100 sessions on a queue of 4 txs
+ */
+MO_BENCHMARK("HotPath.TransactionStore") {
+    const unsigned int nSessions = 100;
+    const unsigned int txQueueSize = 4;
+
+    clearFilesystem();
+    auto counting = std::make_shared<CountingFilesystem>(makeDefaultFilesystemAdapter(FilesystemOpt::Use_Mount_FormatOnFail));
+
+    {
+        TransactionStore volatileStore {2, nullptr};
+        auto t_start = now_ns();
+        for (unsigned int txNr = 0; txNr < nSessions; txNr++) {
+            char fn [MO_MAX_PATH_SIZE];
+            snprintf(fn, sizeof(fn), MO_FILENAME_PREFIX "tx-1-%u.json", txNr);
+
+            auto tx = volatileStore.createTransaction(1, txNr);
+            auto storeFull = [&tx, &counting, fn] () {
+                auto txDoc = initJsonDoc("Benchmark");
+                sink = serializeTransaction(*tx, txDoc) && FilesystemUtils::storeJson(counting, fn, txDoc);
+            };
+            storeFull();
+            runChargingSession(*tx, storeFull);
+
+            if (txNr >= txQueueSize) {
+                snprintf(fn, sizeof(fn), MO_FILENAME_PREFIX "tx-1-%u.json", txNr - txQueueSize);
+                counting->remove(fn);
+            }
+        }
+        auto t_end = now_ns();
+
+        report("full_rewrite.bytes", (double) counting->bytesWritten / nSessions, "B/session");
+        report("full_rewrite.writes", (double) counting->filesWritten / nSessions, "files/session");
+        report("full_rewrite.time", (double) (t_end - t_start) / nSessions, "ns/session");
+    }
+
+    clearFilesystem();
+    counting->bytesWritten = 0;
+    counting->filesWritten = 0;
+
+    {
+        TransactionStore txStore {2, counting};
+        auto t_start = now_ns();
+        for (unsigned int txNr = 0; txNr < nSessions; txNr++) {
+            auto tx = txStore.createTransaction(1, txNr);
+            runChargingSession(*tx, [&tx] () {
+                sink = tx->commit();
+            });
+            tx = nullptr;
+
+            if (txNr >= txQueueSize) {
+                txStore.remove(1, txNr - txQueueSize);
+            }
+        }
+        auto t_end = now_ns();
+
+        report("journal.bytes", (double) counting->bytesWritten / nSessions, "B/session");
+        report("journal.writes", (double) counting->filesWritten / nSessions, "files/session");
+        report("journal.time", (double) (t_end - t_start) / nSessions, "ns/session");
+    }
+
+    clearFilesystem();
+}
@@ -0,0 +1,144 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#include "benchmark.h"
+
+#include <MicroOcpp/Core/Memory.h>
+#include <MicroOcpp/Platform.h>
+
+#include <string>
+#include <stdio.h>
+
+using namespace MicroOcpp;
+using namespace MicroOcpp::Benchmark;
+
+namespace {
+
+//sizing strategy of RequestQueue::receiveMessage before the pre-scan: guess 1.5x of the input and double on NoMemory
+DeserializationError ingestLegacy(const char *payload, size_t length, size_t& attempts) {
+    size_t capacity_init = (3 * length) / 2;
+
+    size_t capacity = 128;
+    while (capacity < capacity_init && capacity < MO_MAX_JSON_CAPACITY) {
+        capacity *= 2;
+    }
+    if (capacity > MO_MAX_JSON_CAPACITY) {
+        capacity = MO_MAX_JSON_CAPACITY;
+    }
+
+    auto doc = initJsonDoc("Benchmark");
+    DeserializationError err = DeserializationError::NoMemory;
+
+    while (err == DeserializationError::NoMemory && capacity <= MO_MAX_JSON_CAPACITY) {
+        doc = initJsonDoc("Benchmark", capacity);
+        err = deserializeJson(doc, payload, length);
+        attempts++;
+        capacity *= 2;
+    }
+    return err;
+}
+
+//current sizing strategy of RequestQueue::receiveMessage
+DeserializationError ingestMeasured(const char *payload, size_t length, size_t& attempts) {
+    size_t capacity = measureJsonCapacity(payload, length);
+    auto doc = initJsonDoc("Benchmark", capacity <= MO_MAX_JSON_CAPACITY ? capacity : 0);
+    if (capacity > MO_MAX_JSON_CAPACITY) {
+        return DeserializationError::NoMemory;
+    }
+    attempts++;
+    return deserializeJson(doc, payload, length);
+}
+
+std::string makeSendLocalList(size_t nEntries) {
+    std::string msg = "[2,\"bench-sll\",\"SendLocalList\",{\"listVersion\":1,\"updateType\":\"Full\",\"localAuthorizationList\":[";
+    for (size_t i = 0; i < nEntries; i++) {
+        char entry [128];
+        snprintf(entry, sizeof(entry), "%s{\"idTag\":\"IDTAG%06zu\",\"idTagInfo\":{\"status\":\"Accepted\",\"expiryDate\":\"2030-01-01T00:00:00.000Z\"}}",
+                i ? "," : "", i);
+        msg += entry;
+    }
+    msg += "]}]";
+    return msg;
+}
+
+std::string makeSetChargingProfile(size_t nPeriods) {
+    std::string msg = "[2,\"bench-scp\",\"SetChargingProfile\",{\"connectorId\":1,\"csChargingProfiles\":{\"chargingProfileId\":1,"
+            "\"stackLevel\":0,\"chargingProfilePurpose\":\"TxDefaultProfile\",\"chargingProfileKind\":\"Absolute\","
+            "\"chargingSchedule\":{\"startSchedule\":\"2023-01-01T00:00:00.000Z\",\"chargingRateUnit\":\"W\",\"chargingSchedulePeriod\":[";
+    for (size_t i = 0; i < nPeriods; i++) {
+        char period [64];
+        snprintf(period, sizeof(period), "%s{\"startPeriod\":%zu,\"limit\":%zu}", i ? "," : "", i * 900, 6 + i % 26);
+        msg += period;
+    }
+    msg += "]}}}]";
+    return msg;
+}
+
+std::string makeGetConfiguration(size_t nKeys) {
+    std::string msg = "[2,\"bench-gc\",\"GetConfiguration\",{\"key\":[";
+    for (size_t i = 0; i < nKeys; i++) {
+        char key [32];
+        snprintf(key, sizeof(key), "%s\"K%zu\"", i ? "," : "", i);
+        msg += key;
+    }
+    msg += "]}]";
+    return msg;
+}
+
+std::string makeDataTransfer(size_t dataLen) {
+    return "[2,\"bench-dt\",\"DataTransfer\",{\"vendorId\":\"Benchmark\",\"data\":\"" + std::string(dataLen, 'x') + "\"}]";
+}
+
+void runIngest(const char *message, const std::string& payload, size_t nIterations) {
+
+    struct {
+        const char *name;
+        DeserializationError (*ingest)(const char*, size_t, size_t&);
+    } strategies [] = {
+        {"legacy", ingestLegacy},
+        {"measured", ingestMeasured}
+    };
+
+    for (auto& strategy : strategies) {
+        size_t attempts = 0;
+        bool ok = true;
+
+        resetHeapPeak();
+        size_t heapBase = getHeapPeak();
+
+        auto t_start = now_us();
+        for (size_t i = 0; i < nIterations; i++) {
+            if (strategy.ingest(payload.c_str(), payload.length(), attempts)) {
+                ok = false;
+            }
+        }
+        auto t_end = now_us();
+
+        size_t heapPeak = getHeapPeak() - heapBase;
+
+        char metric [64];
+        snprintf(metric, sizeof(metric), "%s.%s.throughput", message, strategy.name);
+        report(metric, ok ? (double) nIterations * 1000000. / (double) (t_end - t_start + 1) : 0., "msg/s");
+        snprintf(metric, sizeof(metric), "%s.%s.parse_attempts", message, strategy.name);
+        report(metric, (double) attempts / nIterations, "parses/msg");
+        snprintf(metric, sizeof(metric), "%s.%s.peak_heap", message, strategy.name);
+        report(metric, (double) heapPeak, "bytes");
+    }
+}
+
+} //namespace
+
+/*
+ * Deserialization of large inbound messages: legacy capacity guessing with doubling retries vs. exact sizing
+ * with a pre-scan of the input. Reports throughput, number of deserialization passes and peak heap per message
+ */
+MO_BENCHMARK("RequestQueue.Ingest") {
+    const size_t nIterations = 2000;
+    runIngest("SendLocalList_50", makeSendLocalList(50), nIterations);
+    runIngest("SetChargingProfile_48", makeSetChargingProfile(48), nIterations);
+    runIngest("SetChargingProfile_200", makeSetChargingProfile(200), nIterations);
+    runIngest("GetConfiguration_100", makeGetConfiguration(100), nIterations);
+    runIngest("DataTransfer_4k", makeDataTransfer(4096), nIterations);
+    runIngest("DataTransfer_64", makeDataTransfer(64), nIterations);
+}
@@ -0,0 +1,217 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#include "benchmark.h"
+
+#include <MicroOcpp.h>
+#include <MicroOcpp/Core/Connection.h>
+#include <MicroOcpp/Core/Context.h>
+#include <MicroOcpp/Core/Request.h>
+
+#include <atomic>
+#include <map>
+#include <string>
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace MicroOcpp;
+using namespace MicroOcpp::Benchmark;
+
+namespace {
+
+//LoopbackConnection which timestamps the outgoing CALLRESULTs to the burst CALLs
+class TimedLoopback : public LoopbackConnection {
+public:
+    std::map<std::string, unsigned long long> confSent; //messageId -> time of sending in us
+    std::map<std::string, size_t> confSentLoop; //messageId -> loop iteration of sending
+    size_t loopNr = 0;
+
+    bool sendTXT(const char *msg, size_t length) override {
+        if (length > 10 && !strncmp(msg, "[3,\"burst-", 10)) {
+            const char *idBegin = msg + 4;
+            const char *idEnd = strchr(idBegin, '\"');
+            if (idEnd) {
+                std::string messageId (idBegin, idEnd - idBegin);
+                confSent[messageId] = now_us();
+                confSentLoop[messageId] = loopNr;
+            }
+        }
+        return LoopbackConnection::sendTXT(msg, length);
+    }
+};
+
+void runConfBurst(const char *scenario, size_t confBudgetCount, unsigned long confBudgetMs) {
+
+    const size_t nRounds = 50;
+    const size_t burstSize = 8; //must not exceed MO_REQUEST_CACHE_MAXSIZE
+    const size_t outboundPerRound = 2;
+
+    clearFilesystem();
+
+    TimedLoopback loopback;
+    mocpp_set_timer(mtime_cb);
+    mocpp_initialize(loopback, ChargerCredentials("benchmark-runner"));
+    getOcppContext()->getRequestQueue().setConfirmationBudget(confBudgetCount, confBudgetMs);
+
+    for (int i = 0; i < 100; i++) {
+        mtime += 10;
+        mocpp_loop(); //BootNotification and initial StatusNotifications
+    }
+
+    std::vector<double> latencyLoops, latencyUs;
+    size_t outboundConfirmed = 0;
+    size_t loopsTotal = 0;
+
+    for (size_t round = 0; round < nRounds; round++) {
+
+        std::map<std::string, unsigned long long> received;
+        std::map<std::string, size_t> receivedLoop;
+
+        for (size_t i = 0; i < outboundPerRound; i++) {
+            sendRequest("DataTransfer", [] () {
+                auto doc = makeJsonDoc("Benchmark", JSON_OBJECT_SIZE(1));
+                (*doc)["vendorId"] = "Benchmark";
+                return doc;
+            }, [&outboundConfirmed] (JsonObject) {
+                outboundConfirmed++;
+            });
+        }
+
+        for (size_t i = 0; i < burstSize; i++) {
+            char messageId [32];
+            snprintf(messageId, sizeof(messageId), "burst-%zu-%zu", round, i);
+            char msg [256];
+            if (i % 2 == 0) {
+                snprintf(msg, sizeof(msg), "[2,\"%s\",\"GetConfiguration\",{\"key\":[\"HeartbeatInterval\",\"MeterValueSampleInterval\"]}]", messageId);
+            } else {
+                snprintf(msg, sizeof(msg), "[2,\"%s\",\"ChangeConfiguration\",{\"key\":\"HeartbeatInterval\",\"value\":\"%zu\"}]", messageId, 3600 + round);
+            }
+            received[messageId] = now_us();
+            receivedLoop[messageId] = loopback.loopNr;
+            loopback.sendTXT(msg, strlen(msg)); //loopback forwards the server-initiated CALL to MO
+        }
+
+        size_t loops = 0;
+        while (loopback.confSent.size() < burstSize && loops < 1000) {
+            mtime += 1;
+            loopback.loopNr++;
+            loops++;
+            mocpp_loop();
+        }
+        loopsTotal += loops;
+
+        for (auto& rcv : received) {
+            auto sent = loopback.confSent.find(rcv.first);
+            if (sent != loopback.confSent.end()) {
+                latencyUs.push_back((double) (sent->second - rcv.second));
+                latencyLoops.push_back((double) (loopback.confSentLoop[rcv.first] - receivedLoop[rcv.first]));
+            }
+        }
+        loopback.confSent.clear();
+        loopback.confSentLoop.clear();
+
+        for (int i = 0; i < 10; i++) {
+            mtime += 1;
+            loopback.loopNr++;
+            mocpp_loop(); //settle outbound requests
+        }
+    }
+
+    mocpp_deinitialize();
+
+    char metric [64];
+    snprintf(metric, sizeof(metric), "%s.latency_p50", scenario);
+    report(metric, percentile(latencyLoops, 50), "loops");
+    snprintf(metric, sizeof(metric), "%s.latency_p99", scenario);
+    report(metric, percentile(latencyLoops, 99), "loops");
+    snprintf(metric, sizeof(metric), "%s.latency_p50_time", scenario);
+    report(metric, percentile(latencyUs, 50), "us");
+    snprintf(metric, sizeof(metric), "%s.latency_p99_time", scenario);
+    report(metric, percentile(latencyUs, 99), "us");
+    snprintf(metric, sizeof(metric), "%s.loops_per_burst", scenario);
+    report(metric, (double) loopsTotal / nRounds, "loops");
+    snprintf(metric, sizeof(metric), "%s.outbound_confirmed", scenario);
+    report(metric, (double) outboundConfirmed / (nRounds * outboundPerRound), "ratio");
+}
+
+std::atomic<size_t> mallocCount {0};
+
+void *countingMalloc(size_t size) {
+    mallocCount++;
+    return malloc(size);
+}
+
+void countingFree(void *ptr) {
+    free(ptr);
+}
+
+void runJsonArena(const char *scenario, size_t arenaSize) {
+
+    const size_t nMessages = 2000;
+
+    clearFilesystem();
+
+    LoopbackConnection loopback;
+    mocpp_set_timer(mtime_cb);
+    mocpp_initialize(loopback, ChargerCredentials("benchmark-runner"));
+    getOcppContext()->getRequestQueue().setJsonArenaSize(arenaSize);
+
+    for (int i = 0; i < 100; i++) {
+        mtime += 10;
+        mocpp_loop(); //BootNotification and initial StatusNotifications
+    }
+
+    mo_mem_set_malloc_free(countingMalloc, countingFree);
+    mallocCount = 0;
+    resetHeapPeak();
+
+    auto t_start = now_us();
+
+    for (size_t i = 0; i < nMessages; i++) {
+        char msg [256];
+        snprintf(msg, sizeof(msg), "[2,\"arena-%zu\",\"GetConfiguration\",{\"key\":[\"HeartbeatInterval\",\"MeterValueSampleInterval\"]}]", i);
+        loopback.sendTXT(msg, strlen(msg)); //incoming CALL. The loopback also echoes the CALLRESULT back to MO
+
+        mtime += 1;
+        mocpp_loop();
+    }
+
+    auto t_end = now_us();
+    size_t heapPeak = getHeapPeak();
+    size_t allocs = mallocCount;
+    mo_mem_set_malloc_free(nullptr, nullptr);
+
+    mocpp_deinitialize();
+
+    char metric [64];
+    snprintf(metric, sizeof(metric), "%s.allocs_per_msg", scenario);
+    report(metric, (double) allocs / nMessages, "allocs");
+    snprintf(metric, sizeof(metric), "%s.heap_peak", scenario);
+    report(metric, (double) heapPeak, "B");
+    snprintf(metric, sizeof(metric), "%s.time_per_msg", scenario);
+    report(metric, (double) (t_end - t_start) / nMessages, "us");
+}
+
+} //namespace
+
+/*
+ * Response latency under bursty inbound load: the server issues bursts of GetConfiguration and
+ * ChangeConfiguration calls while the charger has outbound requests queued. Latency is measured from
+ * receiving the CALL until sending the CALLRESULT, in host loop iterations and in wall time
+ */
+MO_BENCHMARK("RequestQueue.ConfBurst") {
+    runConfBurst("unbudgeted", 0, 0);
+    runConfBurst("budget_4", 4, 0);
+    runConfBurst("budget_8", 8, 0);
+}
+
+/*
+ * Heap traffic of the message cycle: the server sends GetConfiguration CALLs, the charger deserializes them,
+ * serializes the CALLRESULTs and receives them back over the loopback. Compares a JsonDoc per message with the
+ * JsonArenas of the RequestQueue which keep their memory between the messages
+ */
+MO_BENCHMARK("RequestQueue.JsonArena") {
+    runJsonArena("no_arena", 0);
+    runJsonArena("arena", MO_JSON_ARENA_SIZE);
+}
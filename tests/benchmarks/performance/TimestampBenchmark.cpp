@@ -0,0 +1,291 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#include "benchmark.h"
+
+#include <MicroOcpp/Core/Time.h>
+#include <MicroOcpp/Platform.h>
+
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+
+using namespace MicroOcpp;
+using namespace MicroOcpp::Benchmark;
+
+namespace {
+
+volatile int sink; //keeps the compiler from optimizing the measured calls away
+
+int legacyNoDays(int month, int year) {
+    return (month == 0 || month == 2 || month == 4 || month == 6 || month == 7 || month == 9 || month == 11) ? 31 :
+            ((month == 3 || month == 5 || month == 8 || month == 10) ? 30 :
+            ((year % 4 == 0 && (year % 100 != 0 || year % 400 == 0)) ? 29 : 28));
+}
+
+//calendar field representation of Timestamp before the switch to epoch seconds
+struct LegacyTimestamp {
+    int16_t year = 1970;
+    int16_t month = 0;
+    int16_t day = 0;
+    int32_t hour = 0;
+    int32_t minute = 0;
+    int32_t second = 0;
+    int32_t ms = 0;
+
+    LegacyTimestamp(int16_t year, int16_t month, int16_t day, int32_t hour, int32_t minute, int32_t second) :
+            year(year), month(month), day(day), hour(hour), minute(minute), second(second) { }
+
+    LegacyTimestamp &operator+=(int secs) {
+        second += secs;
+        if (second >= 0 && second < 60) return *this;
+        minute += second / 60;
+        second %= 60;
+        if (second < 0) {
+            minute--;
+            second += 60;
+        }
+        if (minute >= 0 && minute < 60) return *this;
+        hour += minute / 60;
+        minute %= 60;
+        if (minute < 0) {
+            hour--;
+            minute += 60;
+        }
+        if (hour >= 0 && hour < 24) return *this;
+        day += hour / 24;
+        hour %= 24;
+        if (hour < 0) {
+            day--;
+            hour += 24;
+        }
+        while (day >= legacyNoDays(month, year)) {
+            day -= legacyNoDays(month, year);
+            month++;
+            if (month >= 12) {
+                month -= 12;
+                year++;
+            }
+        }
+        while (day < 0) {
+            month--;
+            if (month < 0) {
+                month += 12;
+                year--;
+            }
+            day += legacyNoDays(month, year);
+        }
+        return *this;
+    }
+
+    int operator-(const LegacyTimestamp &rhs) const {
+        int16_t year_base = year <= rhs.year ? year : rhs.year;
+        int16_t year_end = year <= rhs.year ? rhs.year : year;
+
+        int16_t lhsDays = day;
+        int16_t rhsDays = rhs.day;
+
+        for (int16_t iy = year_base; iy <= year_end; iy++) {
+            for (int16_t im = 0; im < 12; im++) {
+                if (year > iy || (year == iy && month > im)) {
+                    lhsDays += legacyNoDays(im, iy);
+                }
+                if (rhs.year > iy || (rhs.year == iy && rhs.month > im)) {
+                    rhsDays += legacyNoDays(im, iy);
+                }
+            }
+        }
+
+        int dt = (lhsDays - rhsDays) * (24 * 3600) + (hour - rhs.hour) * 3600 + (minute - rhs.minute) * 60 + second - rhs.second;
+        if ((ms - rhs.ms) > 500) dt++;
+        if ((ms - rhs.ms) < -500) dt--;
+        return dt;
+    }
+
+    bool operator<(const LegacyTimestamp &rhs) const {
+        if (year != rhs.year)
+            return year < rhs.year;
+        if (month != rhs.month)
+            return month < rhs.month;
+        if (day != rhs.day)
+            return day < rhs.day;
+        if (hour != rhs.hour)
+            return hour < rhs.hour;
+        if (minute != rhs.minute)
+            return minute < rhs.minute;
+        if (second != rhs.second)
+            return second < rhs.second;
+        return ms < rhs.ms;
+    }
+};
+
+//character-wise validation and conversion of Timestamp::setTime() before the table-driven parser
+bool legacyParse(const char *jsonDateString, int *fields) {
+    if (strlen(jsonDateString) < 19) {
+        return false;
+    }
+    if (!isdigit(jsonDateString[0]) || !isdigit(jsonDateString[1]) || !isdigit(jsonDateString[2]) ||
+            !isdigit(jsonDateString[3]) || jsonDateString[4] != '-' || !isdigit(jsonDateString[5]) ||
+            !isdigit(jsonDateString[6]) || jsonDateString[7] != '-' || !isdigit(jsonDateString[8]) ||
+            !isdigit(jsonDateString[9]) || jsonDateString[10] != 'T' || !isdigit(jsonDateString[11]) ||
+            !isdigit(jsonDateString[12]) || jsonDateString[13] != ':' || !isdigit(jsonDateString[14]) ||
+            !isdigit(jsonDateString[15]) || jsonDateString[16] != ':' || !isdigit(jsonDateString[17]) ||
+            !isdigit(jsonDateString[18])) {
+        return false;
+    }
+    fields[0] = (jsonDateString[0] - '0') * 1000 + (jsonDateString[1] - '0') * 100 + (jsonDateString[2] - '0') * 10 + (jsonDateString[3] - '0');
+    fields[1] = (jsonDateString[5] - '0') * 10 + (jsonDateString[6] - '0') - 1;
+    fields[2] = (jsonDateString[8] - '0') * 10 + (jsonDateString[9] - '0') - 1;
+    fields[3] = (jsonDateString[11] - '0') * 10 + (jsonDateString[12] - '0');
+    fields[4] = (jsonDateString[14] - '0') * 10 + (jsonDateString[15] - '0');
+    fields[5] = (jsonDateString[17] - '0') * 10 + (jsonDateString[18] - '0');
+    fields[6] = 0;
+    if (jsonDateString[19] == '.') {
+        if (isdigit(jsonDateString[20]) || isdigit(jsonDateString[21]) || isdigit(jsonDateString[22])) {
+            fields[6] = (jsonDateString[20] - '0') * 100 + (jsonDateString[21] - '0') * 10 + (jsonDateString[22] - '0');
+        } else {
+            return false;
+        }
+    }
+    return fields[0] >= 1970 && fields[0] < 2038 && fields[1] >= 0 && fields[1] < 12 &&
+            fields[2] >= 0 && fields[2] < legacyNoDays(fields[1], fields[0]) && fields[3] < 24 &&
+            fields[4] < 60 && fields[5] <= 60 && fields[6] >= 0 && fields[6] < 1000;
+}
+
+//digit-wise formatting of Timestamp::toJsonString() before the table-driven formatter
+void legacyFormat(const Timestamp& t, char *jsonDateString) {
+    int32_t time = t - Timestamp();
+    int32_t days = time / (24 * 3600);
+    int32_t secOfDay = time % (24 * 3600);
+
+    //civil date from days since 1970, see Time.cpp
+    int32_t doe = days + 719468 - 5 * 146097;
+    int32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int32_t mp = (5 * doy + 2) / 153;
+    int32_t month = mp < 10 ? mp + 2 : mp - 10;
+    int32_t fields [6] = {yoe + 2000 + (month <= 1), month, doy - (153 * mp + 2) / 5,
+            secOfDay / 3600, (secOfDay / 60) % 60, secOfDay % 60};
+
+    jsonDateString[0] = ((char) ((fields[0] / 1000) % 10)) + '0';
+    jsonDateString[1] = ((char) ((fields[0] / 100) % 10)) + '0';
+    jsonDateString[2] = ((char) ((fields[0] / 10) % 10))  + '0';
+    jsonDateString[3] = ((char) ((fields[0] / 1) % 10))  + '0';
+    jsonDateString[4] = '-';
+    jsonDateString[5] = ((char) (((fields[1] + 1) / 10) % 10))  + '0';
+    jsonDateString[6] = ((char) (((fields[1] + 1) / 1) % 10))  + '0';
+    jsonDateString[7] = '-';
+    jsonDateString[8] = ((char) (((fields[2] + 1) / 10) % 10))  + '0';
+    jsonDateString[9] = ((char) (((fields[2] + 1) / 1) % 10))  + '0';
+    jsonDateString[10] = 'T';
+    jsonDateString[11] = ((char) ((fields[3] / 10) % 10))  + '0';
+    jsonDateString[12] = ((char) ((fields[3] / 1) % 10))  + '0';
+    jsonDateString[13] = ':';
+    jsonDateString[14] = ((char) ((fields[4] / 10) % 10))  + '0';
+    jsonDateString[15] = ((char) ((fields[4] / 1) % 10))  + '0';
+    jsonDateString[16] = ':';
+    jsonDateString[17] = ((char) ((fields[5] / 10) % 10))  + '0';
+    jsonDateString[18] = ((char) ((fields[5] / 1) % 10))  + '0';
+    jsonDateString[19] = 'Z';
+    jsonDateString[20] = '\0';
+}
+
+unsigned long benchmarkTime = 0;
+unsigned long benchmarkTimer() {
+    return benchmarkTime;
+}
+
+} //namespace
+
+/*
+ * Timestamp arithmetic of the calendar field representation vs. epoch seconds. The difference is measured over
+ * a span of one hour and of ten years, because the former implementation iterated over all months in between
+ */
+MO_BENCHMARK("Timestamp.Epoch") {
+    const size_t nIterations = 100000;
+
+    report("legacy.size", (double) sizeof(LegacyTimestamp), "bytes");
+    report("epoch.size", (double) sizeof(Timestamp), "bytes");
+
+    {
+        LegacyTimestamp t1 (2024, 2, 14, 12, 34, 56);
+        LegacyTimestamp t2 = t1;
+        t2 += 3600;
+        LegacyTimestamp t3 (2034, 2, 14, 12, 34, 56);
+
+        report("legacy.difference_1h.time", timePerOp(nIterations, [&t1, &t2] () {
+            sink = t2 - t1;
+        }), "ns/op");
+        report("legacy.difference_10y.time", timePerOp(nIterations, [&t1, &t3] () {
+            sink = t3 - t1;
+        }), "ns/op");
+        report("legacy.add_days.time", timePerOp(nIterations, [&t1, &t2] () {
+            t2 = t1;
+            t2 += 86400 * 40;
+        }), "ns/op");
+        report("legacy.compare.time", timePerOp(nIterations, [&t1, &t2] () {
+            sink = t1 < t2;
+        }), "ns/op");
+    }
+
+    {
+        Timestamp t1 (2024, 2, 14, 12, 34, 56);
+        Timestamp t2 = t1 + 3600;
+        Timestamp t3 (2034, 2, 14, 12, 34, 56);
+
+        report("epoch.difference_1h.time", timePerOp(nIterations, [&t1, &t2] () {
+            sink = t2 - t1;
+        }), "ns/op");
+        report("epoch.difference_10y.time", timePerOp(nIterations, [&t1, &t3] () {
+            sink = t3 - t1;
+        }), "ns/op");
+        report("epoch.add_days.time", timePerOp(nIterations, [&t1, &t2] () {
+            t2 = t1 + 86400 * 40;
+        }), "ns/op");
+        report("epoch.compare.time", timePerOp(nIterations, [&t1, &t2] () {
+            sink = t1 < t2;
+        }), "ns/op");
+    }
+}
+
+/*
+ * ISO 8601 parsing and formatting: character-wise conversion of the former implementation vs. the table-driven
+ * parser and formatter. Formatting of now() is measured with and without the per-second cache of the Clock, with
+ * 10 calls per second of simulated time
+ */
+MO_BENCHMARK("Timestamp.JsonString") {
+    const size_t nIterations = 100000;
+    const char *date = "2024-03-15T12:34:56.789Z";
+    char buf [JSONDATE_LENGTH + 1];
+
+    Timestamp t;
+    report("legacy.parse.time", timePerOp(nIterations, [date, &t] () {
+        int fields [7] = {0};
+        sink = legacyParse(date, fields);
+        t = Timestamp(fields[0], fields[1], fields[2], fields[3], fields[4], fields[5]);
+    }), "ns/op");
+    report("legacy.format.time", timePerOp(nIterations, [&t, &buf] () {
+        legacyFormat(t, buf);
+        sink = buf[18];
+    }), "ns/op");
+
+    report("table.parse.time", timePerOp(nIterations, [date, &t] () {
+        sink = t.setTime(date);
+    }), "ns/op");
+    report("table.format.time", timePerOp(nIterations, [&t, &buf] () {
+        sink = t.toJsonString(buf, sizeof(buf));
+    }), "ns/op");
+
+    mocpp_set_timer(benchmarkTimer);
+    Clock clock;
+    clock.setTime(date);
+    report("now.uncached.time", timePerOp(nIterations, [&clock, &buf] () {
+        benchmarkTime += 100;
+        sink = clock.now().toJsonString(buf, sizeof(buf));
+    }), "ns/op");
+    report("now.cached.time", timePerOp(nIterations, [&clock, &buf] () {
+        benchmarkTime += 100;
+        sink = clock.nowJsonString(buf, sizeof(buf));
+    }), "ns/op");
+}
@@ -0,0 +1,68 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#ifndef MO_BENCHMARK_H
+#define MO_BENCHMARK_H
+
+#include <stddef.h>
+#include <functional>
+#include <vector>
+
+/*
+ * Minimal harness for host performance benchmarks. Each benchmark reports its results as metrics which are
+ * printed as one JSON document on stdout, e.g.
+ *
+ *     {"benchmarks":[{"benchmark":"RequestQueue.ConfBurst","metric":"latency_p99","value":12,"unit":"loops"}, ...]}
+ *
+ * Run all benchmarks: ./mo_benchmarks
+ * Run a selection:    ./mo_benchmarks RequestQueue.ConfBurst ...
+ */
+
+namespace MicroOcpp {
+namespace Benchmark {
+
+using BenchmarkFn = void (*)();
+
+struct Registrar {
+    Registrar(const char *name, BenchmarkFn fn);
+};
+
+//add a result metric of the running benchmark to the JSON output
+void report(const char *metric, double value, const char *unit);
+
+//high-resolution host clock (not the MO timer which runs on a simulated clock in the benchmarks)
+unsigned long long now_us();
+unsigned long long now_ns();
+
+//execute fn nIterations times per batch and return the median time per call over nBatches batches in ns
+double timePerOp(size_t nIterations, const std::function<void()>& fn, size_t nBatches = 5);
+
+//simulated MO clock
+extern unsigned long mtime;
+unsigned long mtime_cb();
+
+//p in [0, 100]. Sorts the samples
+double percentile(std::vector<double>& samples, double p);
+
+//reset the peak value of the heap profiler to the current heap usage
+void resetHeapPeak();
+
+//peak heap usage of MO since the last resetHeapPeak() in bytes
+size_t getHeapPeak();
+
+//clear the filesystem under MO_FILENAME_PREFIX
+void clearFilesystem();
+
+} //namespace Benchmark
+} //namespace MicroOcpp
+
+#define MO_BENCHMARK_CONCAT_(A, B) A##B
+#define MO_BENCHMARK_CONCAT(A, B) MO_BENCHMARK_CONCAT_(A, B)
+
+#define MO_BENCHMARK(NAME) \
+    static void MO_BENCHMARK_CONCAT(mo_benchmark_, __LINE__)(); \
+    static MicroOcpp::Benchmark::Registrar MO_BENCHMARK_CONCAT(mo_benchmark_registrar_, __LINE__) (NAME, MO_BENCHMARK_CONCAT(mo_benchmark_, __LINE__)); \
+    static void MO_BENCHMARK_CONCAT(mo_benchmark_, __LINE__)()
+
+#endif
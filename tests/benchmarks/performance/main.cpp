@@ -0,0 +1,131 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#include "benchmark.h"
+
+#include <MicroOcpp/Core/FilesystemAdapter.h>
+#include <MicroOcpp/Core/FilesystemUtils.h>
+#include <MicroOcpp/Core/Memory.h>
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace MicroOcpp {
+namespace Benchmark {
+
+struct Entry {
+    const char *name;
+    BenchmarkFn fn;
+};
+
+std::vector<Entry>& registry() {
+    static std::vector<Entry> entries;
+    return entries;
+}
+
+const char *runningBenchmark = nullptr;
+bool firstResult = true;
+
+Registrar::Registrar(const char *name, BenchmarkFn fn) {
+    registry().push_back({name, fn});
+}
+
+void report(const char *metric, double value, const char *unit) {
+    printf("%s\n    {\"benchmark\":\"%s\",\"metric\":\"%s\",\"value\":%.6g,\"unit\":\"%s\"}",
+            firstResult ? "" : ",",
+            runningBenchmark ? runningBenchmark : "",
+            metric,
+            value,
+            unit);
+    firstResult = false;
+}
+
+unsigned long long now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+unsigned long long now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+double timePerOp(size_t nIterations, const std::function<void()>& fn, size_t nBatches) {
+    std::vector<double> batches;
+    for (size_t b = 0; b < nBatches; b++) {
+        auto t_start = now_ns();
+        for (size_t i = 0; i < nIterations; i++) {
+            fn();
+        }
+        auto t_end = now_ns();
+        batches.push_back((double) (t_end - t_start) / (double) nIterations);
+    }
+    return percentile(batches, 50.);
+}
+
+unsigned long mtime = 10000;
+unsigned long mtime_cb() {
+    return mtime;
+}
+
+double percentile(std::vector<double>& samples, double p) {
+    if (samples.empty()) {
+        return 0.;
+    }
+    std::sort(samples.begin(), samples.end());
+    size_t index = (size_t) ((p / 100.) * (samples.size() - 1) + 0.5);
+    return samples[std::min(index, samples.size() - 1)];
+}
+
+void resetHeapPeak() {
+    MO_MEM_RESET();
+}
+
+size_t getHeapPeak() {
+    static char buf [16384];
+    if (mo_mem_write_stats_json(buf, sizeof(buf)) <= 0) {
+        return 0;
+    }
+    const char *totalMax = strstr(buf, "\"total_max\":");
+    return totalMax ? (size_t) strtoul(totalMax + strlen("\"total_max\":"), nullptr, 10) : 0;
+}
+
+void clearFilesystem() {
+    auto filesystem = makeDefaultFilesystemAdapter(FilesystemOpt::Use_Mount_FormatOnFail);
+    FilesystemUtils::remove_if(filesystem, [] (const char*) {return true;});
+}
+
+} //namespace Benchmark
+} //namespace MicroOcpp
+
+using namespace MicroOcpp::Benchmark;
+
+int main(int argc, char **argv) {
+
+    printf("{\"benchmarks\":[");
+
+    for (auto& entry : registry()) {
+        bool selected = argc <= 1;
+        for (int i = 1; i < argc; i++) {
+            if (!strcmp(argv[i], entry.name)) {
+                selected = true;
+            }
+        }
+        if (!selected) {
+            continue;
+        }
+
+        runningBenchmark = entry.name;
+        entry.fn();
+        runningBenchmark = nullptr;
+    }
+
+    printf("\n]}\n");
+
+    MO_MEM_DEINIT();
+    return 0;
+}
@@ -51,6 +51,10 @@ def categorize_table(df):
     df.at['MicroOcpp.cpp', 'v16'] = TICK
     df.at['MicroOcpp.cpp', 'v201'] = TICK
     df.at['MicroOcpp.cpp', 'Module'] = MODULE_API
+    if 'Core/CommandQueue.cpp' in df.index:
+        df.at['Core/CommandQueue.cpp', 'v16'] = TICK
+        df.at['Core/CommandQueue.cpp', 'v201'] = TICK
+        df.at['Core/CommandQueue.cpp', 'Module'] = MODULE_API
     df.at['Core/Configuration.cpp', 'v16'] = TICK
     df.at['Core/Configuration.cpp', 'v201'] = TICK
     df.at['Core/Configuration.cpp', 'Module'] = MODULE_CONFIGURATION
@@ -85,6 +89,13 @@ def categorize_table(df):
     df.at['Core/Memory.cpp', 'v16'] = TICK
     df.at['Core/Memory.cpp', 'v201'] = TICK
     df.at['Core/Memory.cpp', 'Module'] = MODULE_GENERAL
+    df.at['Core/ObjectPool.cpp', 'v16'] = TICK
+    df.at['Core/ObjectPool.cpp', 'v201'] = TICK
+    df.at['Core/ObjectPool.cpp', 'Module'] = MODULE_GENERAL
+    if 'Core/SlabAllocator.cpp' in df.index:
+        df.at['Core/SlabAllocator.cpp', 'v16'] = TICK
+        df.at['Core/SlabAllocator.cpp', 'v201'] = TICK
+        df.at['Core/SlabAllocator.cpp', 'Module'] = MODULE_GENERAL
     df.at['Core/Operation.cpp', 'v16'] = TICK
     df.at['Core/Operation.cpp', 'v201'] = TICK
     df.at['Core/Operation.cpp', 'Module'] = MODULE_RPC
@@ -97,9 +108,26 @@ def categorize_table(df):
     df.at['Core/RequestQueue.cpp', 'v16'] = TICK
     df.at['Core/RequestQueue.cpp', 'v201'] = TICK
     df.at['Core/RequestQueue.cpp', 'Module'] = MODULE_RPC
+    df.at['Core/PersistentRequestQueue.cpp', 'v16'] = TICK
+    df.at['Core/PersistentRequestQueue.cpp', 'v201'] = TICK
+    df.at['Core/PersistentRequestQueue.cpp', 'Module'] = MODULE_RPC
+    df.at['Core/RequestScheduler.cpp', 'v16'] = TICK
+    df.at['Core/RequestScheduler.cpp', 'v201'] = TICK
+    df.at['Core/RequestScheduler.cpp', 'Module'] = MODULE_RPC
+    df.at['Core/RttEstimator.cpp', 'v16'] = TICK
+    df.at['Core/RttEstimator.cpp', 'v201'] = TICK
+    df.at['Core/RttEstimator.cpp', 'Module'] = MODULE_RPC
+    if 'Core/ThreadedConnection.cpp' in df.index:
+        df.at['Core/ThreadedConnection.cpp', 'v16'] = TICK
+        df.at['Core/ThreadedConnection.cpp', 'v201'] = TICK
+        df.at['Core/ThreadedConnection.cpp', 'Module'] = MODULE_HAL
     df.at['Core/Time.cpp', 'v16'] = TICK
     df.at['Core/Time.cpp', 'v201'] = TICK
     df.at['Core/Time.cpp', 'Module'] = MODULE_GENERAL
+    if 'Core/TimerWheel.cpp' in df.index:
+        df.at['Core/TimerWheel.cpp', 'v16'] = TICK
+        df.at['Core/TimerWheel.cpp', 'v201'] = TICK
+        df.at['Core/TimerWheel.cpp', 'Module'] = MODULE_GENERAL
     df.at['Core/UuidUtils.cpp', 'v16'] = TICK
     df.at['Core/UuidUtils.cpp', 'v201'] = TICK
     df.at['Core/UuidUtils.cpp', 'Module'] = MODULE_GENERAL
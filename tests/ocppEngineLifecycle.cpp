@@ -4,9 +4,18 @@
 
 #include <MicroOcpp.h>
 #include <MicroOcpp/Core/Connection.h>
+#include <MicroOcpp/Core/Context.h>
+#include <MicroOcpp/Core/Configuration.h>
+#include <MicroOcpp/Core/FilesystemAdapter.h>
+#include <MicroOcpp/Core/FilesystemUtils.h>
 #include <catch2/catch.hpp>
 #include "./helpers/testHelper.h"
 
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
 TEST_CASE( "Context lifecycle" ) {
     printf("\nRun %s\n",  "Context lifecycle");
 
@@ -24,3 +33,185 @@ TEST_CASE( "Context lifecycle" ) {
         REQUIRE( !( getOcppContext() ) );
     }
 }
+
+TEST_CASE( "Tickless loop" ) {
+    printf("\nRun %s\n",  "Tickless loop");
+
+    MicroOcpp::LoopbackConnection loopback;
+    mocpp_initialize(loopback, ChargerCredentials("test-runner1234"));
+    mocpp_set_timer(custom_timer_cb);
+
+    loop();
+
+    //idle: wait at most MO_LOOP_MAX_DELAY
+    auto deadline = mocpp_loop_next_deadline_ms();
+    REQUIRE( deadline > 0 );
+    REQUIRE( deadline <= MO_LOOP_MAX_DELAY );
+
+    mtime += deadline / 2;
+    REQUIRE( mocpp_loop_next_deadline_ms() == deadline - deadline / 2 );
+
+    mtime += deadline;
+    REQUIRE( mocpp_loop_next_deadline_ms() == 0 );
+
+    //new request: run loop() right away
+    mocpp_loop();
+    REQUIRE( mocpp_loop_next_deadline_ms() > 0 );
+    sendRequest("DataTransfer", [] () {
+        auto doc = MicroOcpp::makeJsonDoc("UnitTests", JSON_OBJECT_SIZE(1));
+        (*doc)["vendorId"] = "mVendorId";
+        return doc;
+    }, [] (JsonObject) { });
+    REQUIRE( mocpp_loop_next_deadline_ms() == 0 );
+
+    //loop() sends the request, then checks for further work
+    mocpp_loop();
+    REQUIRE( mocpp_loop_next_deadline_ms() == 0 );
+
+    loop();
+    REQUIRE( mocpp_loop_next_deadline_ms() > 0 );
+
+    mocpp_deinitialize();
+}
+
+TEST_CASE( "Multiple instances" ) {
+    printf("\nRun %s\n",  "Multiple instances");
+
+    auto filesystem = MicroOcpp::makeDefaultFilesystemAdapter(MicroOcpp::FilesystemOpt::Use_Mount_FormatOnFail);
+    MicroOcpp::FilesystemUtils::remove_if(filesystem, [] (const char*) {return true;});
+
+    MicroOcpp::LoopbackConnection loopback1, loopback2;
+
+    mocpp_initialize(loopback1, ChargerCredentials("test-runner1"), MicroOcpp::makePrefixedFilesystemAdapter(filesystem, "cp1-"));
+    auto cp1 = getOcppContext();
+    mocpp_set_timer(custom_timer_cb);
+
+    mocpp_select_instance(nullptr);
+    REQUIRE( getOcppContext() == nullptr );
+
+    mocpp_initialize(loopback2, ChargerCredentials("test-runner2"), MicroOcpp::makePrefixedFilesystemAdapter(filesystem, "cp2-"));
+    auto cp2 = getOcppContext();
+
+    REQUIRE( cp1 != nullptr );
+    REQUIRE( cp2 != nullptr );
+    REQUIRE( cp1 != cp2 );
+
+    SECTION("Instance-scoped configuration") {
+
+        //cp2 is selected
+        auto heartbeatInterval = MicroOcpp::getConfigurationPublic("HeartbeatInterval");
+        REQUIRE( heartbeatInterval != nullptr );
+        int heartbeatIntervalDefault = heartbeatInterval->getInt();
+        heartbeatInterval->setInt(heartbeatIntervalDefault + 1);
+        REQUIRE( MicroOcpp::configuration_save() );
+
+        mocpp_select_instance(cp1);
+        REQUIRE( MicroOcpp::getConfigurationPublic("HeartbeatInterval")->getInt() == heartbeatIntervalDefault );
+        REQUIRE( MicroOcpp::configuration_save() );
+
+        mocpp_select_instance(cp2);
+        REQUIRE( MicroOcpp::getConfigurationPublic("HeartbeatInterval")->getInt() == heartbeatIntervalDefault + 1 );
+
+        //each instance has its own files
+        size_t size;
+        REQUIRE( filesystem->stat(MO_FILENAME_PREFIX "cp1-" "ocpp-config.jsn", &size) == 0 );
+        REQUIRE( filesystem->stat(MO_FILENAME_PREFIX "cp2-" "ocpp-config.jsn", &size) == 0 );
+        REQUIRE( filesystem->stat(MO_FILENAME_PREFIX "ocpp-config.jsn", &size) != 0 );
+
+        //ftw_root only lists the files of the instance
+        REQUIRE( filesystem->open(MO_FILENAME_PREFIX "cp2-" "only.jsn", "w") != nullptr );
+
+        std::vector<std::string> listed;
+        cp1->getFilesystem()->ftw_root([&listed] (const char *fn) -> int {
+            listed.emplace_back(fn);
+            return 0;
+        });
+        REQUIRE( std::find(listed.begin(), listed.end(), "ocpp-config.jsn") != listed.end() );
+        REQUIRE( std::find(listed.begin(), listed.end(), "only.jsn") == listed.end() );
+        for (auto& fn : listed) {
+            REQUIRE( filesystem->stat((MO_FILENAME_PREFIX "cp1-" + fn).c_str(), &size) == 0 );
+        }
+    }
+
+    SECTION("Loop on worker threads") {
+
+        std::thread worker1 ([cp1] () {
+            for (unsigned int i = 0; i < 30; i++) {
+                cp1->loop();
+            }
+        });
+        std::thread worker2 ([cp2] () {
+            for (unsigned int i = 0; i < 30; i++) {
+                mocpp_select_instance(cp2);
+                mocpp_loop();
+            }
+        });
+
+        worker1.join();
+        worker2.join();
+
+        mocpp_select_instance(cp1);
+        REQUIRE( getChargePointStatus() == ChargePointStatus_Available );
+        mocpp_select_instance(cp2);
+        REQUIRE( getChargePointStatus() == ChargePointStatus_Available );
+    }
+
+#if MO_ENABLE_COMMAND_QUEUE
+    SECTION("Post to an instance which loops on a worker thread") {
+
+        std::thread boot ([cp1] () {
+            for (unsigned int i = 0; i < 30; i++) {
+                cp1->loop();
+            }
+        });
+        boot.join();
+
+        mocpp_select_instance(cp1);
+        MicroOcpp::Context *executedOn = nullptr;
+        bool called = false;
+        bool result = false;
+        mocpp_post<bool>([&executedOn] () {
+                executedOn = getOcppContext();
+                return beginTransaction("mIdTag");
+            }, [&called, &result] (bool success) {
+                called = true;
+                result = success;
+            });
+        mocpp_select_instance(cp2);
+
+        //the worker thread has no instance selected
+        std::thread worker ([cp1] () {
+            cp1->loop();
+        });
+        worker.join();
+
+        REQUIRE( executedOn == cp1 );
+        REQUIRE( called );
+        REQUIRE( result );
+        REQUIRE( getOcppContext() == cp2 );
+        REQUIRE( !isTransactionActive() );
+        mocpp_select_instance(cp1);
+        REQUIRE( isTransactionActive() );
+        endTransaction();
+
+        //looping cp1 on a thread which has selected cp2
+        executedOn = nullptr;
+        mocpp_post([&executedOn] () {
+            executedOn = getOcppContext();
+        });
+        mocpp_select_instance(cp2);
+        cp1->loop();
+        REQUIRE( executedOn == cp1 );
+        REQUIRE( getOcppContext() == cp2 );
+    }
+#endif //MO_ENABLE_COMMAND_QUEUE
+
+    mocpp_select_instance(cp1);
+    mocpp_deinitialize();
+    mocpp_select_instance(cp2);
+    mocpp_deinitialize();
+
+    REQUIRE( getOcppContext() == nullptr );
+
+    MicroOcpp::FilesystemUtils::remove_if(filesystem, [] (const char*) {return true;});
+}